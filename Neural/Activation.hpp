@@ -0,0 +1,161 @@
+//
+//  Activation.hpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#ifndef Activation_hpp
+#define Activation_hpp
+#include "Definitions.h"
+#include <string>
+#include <math.h>
+NAMESPACE_NEURAL_BEGIN
+
+/**
+ * The activation functions that a layer can use.
+ */
+enum class ActivationType {
+    kSigmoid,
+    kReLU,
+    kLeakyReLU,
+    kTanh
+};
+
+/*
+ * Every activation is a policy with an 'Activate' function and a
+ * 'Derivative' function that is given the output of 'Activate' (all
+ * of the functions here can find their derivative from their output).
+ * The layers choose a policy once per call and then run a loop that
+ * is compiled for it, so there is no call per perceptron.
+ */
+
+struct SigmoidActivation {
+    
+    template <typename Scalar>
+    static Scalar Activate(Scalar value) { return 1 / (1 + exp(-value)); }
+    
+    template <typename Scalar>
+    static Scalar Derivative(Scalar output) { return output * (1 - output); }
+};
+
+struct ReLUActivation {
+    
+    template <typename Scalar>
+    static Scalar Activate(Scalar value) { return (value > 0) ? value : 0; }
+    
+    template <typename Scalar>
+    static Scalar Derivative(Scalar output) { return (output > 0) ? 1 : 0; }
+};
+
+struct LeakyReLUActivation {
+    
+    ///The slope of the negative side
+    static constexpr double kSlope = 0.01;
+    
+    template <typename Scalar>
+    static Scalar Activate(Scalar value) { return (value > 0) ? value : static_cast<Scalar>(kSlope) * value; }
+    
+    template <typename Scalar>
+    static Scalar Derivative(Scalar output) { return (output > 0) ? 1 : static_cast<Scalar>(kSlope); }
+};
+
+struct TanhActivation {
+    
+    template <typename Scalar>
+    static Scalar Activate(Scalar value) { return tanh(value); }
+    
+    template <typename Scalar>
+    static Scalar Derivative(Scalar output) { return 1 - output * output; }
+};
+
+/**
+ * Applies an activation policy to every value.
+ *
+ * @param values    The values, which are replaced by their activations.
+ * @param count     The number of values.
+ */
+template <typename Policy, typename Scalar>
+inline void ActivateAll(Scalar* values, size_t count) {
+    
+    for (size_t index = 0 ; index < count ; index++)
+        values[index] = Policy::Activate(values[index]);
+}
+
+/**
+ * Applies an activation function to every value.
+ *
+ * @param type      The activation function.
+ * @param values    The values, which are replaced by their activations.
+ * @param count     The number of values.
+ */
+template <typename Scalar>
+inline void Activate(ActivationType type, Scalar* values, size_t count) {
+    
+    switch (type) {
+        case ActivationType::kSigmoid:      ActivateAll<SigmoidActivation>(values, count);      break;
+        case ActivationType::kReLU:         ActivateAll<ReLUActivation>(values, count);         break;
+        case ActivationType::kLeakyReLU:    ActivateAll<LeakyReLUActivation>(values, count);    break;
+        case ActivationType::kTanh:         ActivateAll<TanhActivation>(values, count);         break;
+    }
+}
+
+/**
+ * Performs deltas[i] = Derivative(outputs[i]) * errors[i] for an activation policy.
+ *
+ * @param outputs   The outputs of the activation.
+ * @param errors    The errors of the outputs.
+ * @param deltas    Receives the deltas.
+ * @param count     The number of values.
+ */
+template <typename Policy, typename Scalar>
+inline void DeriveAll(const Scalar* outputs, const Scalar* errors, Scalar* deltas, size_t count) {
+    
+    for (size_t index = 0 ; index < count ; index++)
+        deltas[index] = Policy::Derivative(outputs[index]) * errors[index];
+}
+
+/**
+ * Returns the name of an activation function, as it is serialized.
+ *
+ * @param type  The activation function.
+ * @return The name of the activation function.
+ */
+inline std::string ActivationName(ActivationType type) {
+    
+    switch (type) {
+        case ActivationType::kSigmoid:      return "sigmoid";
+        case ActivationType::kReLU:         return "relu";
+        case ActivationType::kLeakyReLU:    return "leaky";
+        case ActivationType::kTanh:         return "tanh";
+    }
+    
+    return "sigmoid";
+}
+
+/**
+ * Finds the activation function by it's name.
+ *
+ * @param name  The name of the activation function, as 'ActivationName' returns it.
+ * @param type  Receives the activation function, unchanged if the name is unknown.
+ * @return True if the name is of an activation function.
+ */
+inline bool ActivationFromName(const std::string& name, ActivationType& type) {
+    
+    const ActivationType types[] = { ActivationType::kSigmoid, ActivationType::kReLU, ActivationType::kLeakyReLU, ActivationType::kTanh };
+    
+    for (ActivationType candidate : types) {
+        
+        if (name == ActivationName(candidate)) {
+            
+            type = candidate;
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+NAMESPACE_NEURAL_END
+#endif /* Activation_hpp */
@@ -0,0 +1,203 @@
+//
+//  AlignedAllocator.hpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#ifndef AlignedAllocator_hpp
+#define AlignedAllocator_hpp
+#include "Definitions.h"
+#include <stdlib.h>
+#include <stddef.h>
+#include <new>
+#include <vector>
+#include <memory>
+#include <utility>
+NAMESPACE_NEURAL_BEGIN
+
+///The alignment that is used for all the numeric buffers (a full cache line)
+#define NEURAL_ALIGNMENT 64
+
+/**
+ * Allocator that places the contents of a container on
+ * a cache line boundary, so that rows of a matrix can be
+ * streamed with aligned vector loads.
+ */
+template <typename T>
+class AlignedAllocator {
+public:
+    
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+    
+    template <typename U>
+    struct rebind { typedef AlignedAllocator<U> other; };
+    
+    AlignedAllocator() { }
+    
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U>&) { }
+    
+    T* allocate(size_t count) {
+        
+        void* memory = NULL;
+        if (posix_memalign(&memory, NEURAL_ALIGNMENT, count * sizeof(T)) != 0)
+            throw std::bad_alloc();
+        
+        return static_cast<T*>(memory);
+    }
+    
+    void deallocate(T* pointer, size_t) {
+        free(pointer);
+    }
+    
+    template <typename U>
+    bool operator==(const AlignedAllocator<U>&) const { return true; }
+    
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U>&) const { return false; }
+    
+};
+
+///A vector that is aligned to a cache line
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T> >;
+
+/**
+ * A buffer of aligned values that either owns it's memory or views
+ * memory that belongs to someone else (such as the pages of a mapped
+ * file), which it keeps alive for as long as the view exists. Copies
+ * of a view share the memory, copies of an owned buffer copy it.
+ */
+template <typename T>
+class AlignedBuffer {
+public:
+    
+    /**
+     * Constructor. Owns the values.
+     *
+     * @param count     The number of values.
+     * @param value     The value of every one of them.
+     */
+    AlignedBuffer(size_t count = 0, const T& value = T()) :
+    m_owned(count, value),
+    m_data(m_owned.data()),
+    m_size(count)
+    { }
+    
+    /**
+     * Constructor. Takes over the values of a vector.
+     *
+     * @param owned     The values.
+     */
+    AlignedBuffer(AlignedVector<T>&& owned) :
+    m_owned(std::move(owned)),
+    m_data(m_owned.data()),
+    m_size(m_owned.size())
+    { }
+    
+    /**
+     * Constructor. Views values that belong to another object.
+     *
+     * @param data      The values, aligned to 'NEURAL_ALIGNMENT'.
+     * @param count     The number of values.
+     * @param owner     The owner of the values, kept alive by the view.
+     */
+    AlignedBuffer(T* data, size_t count, std::shared_ptr<const void> owner) :
+    m_data(data),
+    m_size(count),
+    m_owner(std::move(owner))
+    { }
+    
+    AlignedBuffer(const AlignedBuffer& other) :
+    m_owned(other.m_owned),
+    m_data((other.m_owner) ? other.m_data : m_owned.data()),
+    m_size(other.m_size),
+    m_owner(other.m_owner)
+    { }
+    
+    //A moved vector keeps it's memory, so the pointer stays valid
+    AlignedBuffer(AlignedBuffer&& other) :
+    m_owned(std::move(other.m_owned)),
+    m_data(other.m_data),
+    m_size(other.m_size),
+    m_owner(std::move(other.m_owner)) {
+        
+        other.m_data = NULL;
+        other.m_size = 0;
+    }
+    
+    AlignedBuffer& operator=(AlignedBuffer other) {
+        
+        swap(other);
+        return *this;
+    }
+    
+    void swap(AlignedBuffer& other) {
+        
+        m_owned.swap(other.m_owned);
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+        m_owner.swap(other.m_owner);
+    }
+    
+    /**
+     * Returns true if the values belong to another object.
+     *
+     * @return True for a view.
+     */
+    bool Viewed() const { return m_owner != NULL; }
+    
+    T* data() { return m_data; }
+    const T* data() const { return m_data; }
+    
+    size_t size() const { return m_size; }
+    
+    T* begin() { return m_data; }
+    const T* begin() const { return m_data; }
+    
+    T* end() { return m_data + m_size; }
+    const T* end() const { return m_data + m_size; }
+    
+    T& operator[](size_t index) { return m_data[index]; }
+    const T& operator[](size_t index) const { return m_data[index]; }
+    
+private:
+    
+    ///Stores the values when the buffer owns them
+    AlignedVector<T> m_owned;
+    
+    ///Stores the beginning of the values
+    T* m_data;
+    
+    ///Stores the number of values
+    size_t m_size;
+    
+    ///Stores the owner of viewed values, NULL when the buffer owns them
+    std::shared_ptr<const void> m_owner;
+    
+};
+
+/**
+ * Returns the number of elements that a row of the given length
+ * occupies once padded to a cache line boundary.
+ *
+ * @param count     The number of elements in the row.
+ * @return The padded number of elements.
+ */
+template <typename T>
+constexpr size_t AlignedStride(size_t count) {
+    
+    const size_t per_line = NEURAL_ALIGNMENT / sizeof(T);
+    return (count + per_line - 1) / per_line * per_line;
+}
+
+NAMESPACE_NEURAL_END
+#endif /* AlignedAllocator_hpp */
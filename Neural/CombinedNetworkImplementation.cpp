@@ -8,51 +8,279 @@
 
 #include "CombinedNetworkImplementation.hpp"
 #include "Data.hpp"
+#include "ModelFile.hpp"
+#include "Layer.hpp"
 #include <string>
+#include <algorithm>
 
 using namespace neural;
 
-CombinedNetworkImplementation::CombinedNetworkImplementation() :
-m_network(new Network(301)){
+///The number of records that 'EstimateBatch' passes through the network at once
+static const size_t kRecordsPerChunk = 64;
+
+///The number of values of every record, the pixels of an image
+static const size_t kInputs = 784;
+
+///The number of results of the network, a certainty per digit
+static const size_t kOutputs = 10;
+
+/**
+ * Returns the index of the largest result.
+ *
+ * @param results   The results of the network.
+ * @param count     The number of results.
+ * @return The index of the largest result.
+ */
+template <typename Value>
+static size_t MaximalIndex(const Value* results, size_t count) {
+    
+    size_t max_pos = 0;
+    double max = 0.0;
+    for (size_t results_index = 0 ; results_index < count ; results_index++)
+        if (results[results_index] > max) {
+            max_pos = results_index;
+            max = results[results_index];
+        }
+    
+    return max_pos;
+}
+
+/**
+ * Returns the index of the largest result.
+ *
+ * @param results   The results of the network.
+ * @return The index of the largest result.
+ */
+template <typename Value>
+static size_t MaximalIndex(const std::vector<Value>& results) {
+    return MaximalIndex(results.data(), results.size());
+}
+
+template <typename Scalar>
+CombinedNetworkImplementation<Scalar>::CombinedNetworkImplementation(ActivationType hidden) :
+m_network(new BasicNetwork<Scalar>(301, hidden)),
+m_fast_activation(false) {
     
-    //Add the rest of the layers
-    m_network->AddNetwork(200);
-    m_network->AddNetwork(200);
-    m_network->AddNetwork(180);
-    m_network->AddNetwork(80);
+    //Add the rest of the layers, the output layer stays a sigmoid
+    m_network->AddNetwork(200, hidden);
+    m_network->AddNetwork(200, hidden);
+    m_network->AddNetwork(180, hidden);
+    m_network->AddNetwork(80, hidden);
     m_network->AddNetwork(10);
+    
+    //The data is conformed to binary values
+    m_network->SetBinaryInput(true);
 }
 
-CombinedNetworkImplementation::CombinedNetworkImplementation(const std::string& serialized) :
-m_network(new Network(serialized))
-{ }
+template <typename Scalar>
+std::unique_ptr<CombinedNetworkImplementation<Scalar> > CombinedNetworkImplementation<Scalar>::Deserialize(const char* serialized, const char* end, ThreadPool* pool) {
+    
+    return Load(BasicNetwork<Scalar>::Deserialize(serialized, end, pool));
+}
 
-CombinedNetworkImplementation::~CombinedNetworkImplementation() { };
+template <typename Scalar>
+std::unique_ptr<CombinedNetworkImplementation<Scalar> > CombinedNetworkImplementation<Scalar>::Load(std::unique_ptr<BasicNetwork<Scalar> > network) {
+    
+    //A network of another shape would read past it's weights or give other than a result per digit
+    if (!network || !network->HasShape(kInputs, kOutputs))
+        return NULL;
+    
+    return std::unique_ptr<CombinedNetworkImplementation<Scalar> >(new CombinedNetworkImplementation<Scalar>(std::move(network)));
+}
 
-OperationalNetwork::Type CombinedNetworkImplementation::Type() const {
+template <typename Scalar>
+CombinedNetworkImplementation<Scalar>::CombinedNetworkImplementation(std::unique_ptr<BasicNetwork<Scalar> > network) :
+m_network(std::move(network)),
+m_fast_activation(false) {
+    
+    //The data is conformed to binary values
+    m_network->SetBinaryInput(true);
+}
+
+template <typename Scalar>
+CombinedNetworkImplementation<Scalar>::~CombinedNetworkImplementation() { };
+
+template <typename Scalar>
+OperationalNetwork::Type CombinedNetworkImplementation<Scalar>::Type() const {
     return OperationalNetwork::Type::kCombined;
 }
 
-std::string CombinedNetworkImplementation::Serialize() const {
+template <typename Scalar>
+OperationalNetwork::Precision CombinedNetworkImplementation<Scalar>::Precision() const {
+    return PrecisionOf<Scalar>::value;
+}
+
+template <typename Scalar>
+std::string CombinedNetworkImplementation<Scalar>::Serialize() const {
     return m_network->Serialize();
 }
 
-double CombinedNetworkImplementation::Estimate(const Data& input) const {
+template <typename Scalar>
+bool CombinedNetworkImplementation<Scalar>::WriteBinary(std::ostream& output) const {
+    return ModelFile::Write<Scalar>(output, Type(), { m_network.get() });
+}
+
+template <typename Scalar>
+double CombinedNetworkImplementation<Scalar>::Estimate(const Data& input) const {
     
-    std::vector<double> results = m_network->Feed(ConformData(input));
+    if (m_quantized)
+        return MaximalIndex(m_quantized->Feed(ConformData(input)));
     
-    size_t max_pos = 0;
-    double max = 0.0;
-    for (size_t results_index = 0 ; results_index < results.size() ; results_index++)
-        if (results.at(results_index) > max) {
-            max_pos = results_index;
-            max = results.at(results_index);
+    if (m_fixed) {
+        
+        std::array<Scalar, FixedTopology::kOutputs> results;
+        m_fixed->Feed(ConformData(input), results);
+        return MaximalIndex(results.data(), results.size());
+    }
+    
+    //Every thread has it's own workspace, so that several threads can estimate at once
+    static thread_local Workspace<Scalar> workspace;
+    
+    return MaximalIndex(m_network->Feed(ConformData(input), workspace));
+}
+
+template <typename Scalar>
+void CombinedNetworkImplementation<Scalar>::EstimateBatch(const std::vector<Data>& data, std::vector<double>& results) const {
+    
+    results.resize(data.size());
+    
+    size_t chunks = (data.size() + kRecordsPerChunk - 1) / kRecordsPerChunk;
+    
+    //Every chunk writes only it's own results, so their order does not depend on the threads
+    auto estimate = [this, &data, &results](size_t begin, size_t end) {
+        
+        Workspace<Scalar> workspace;
+        std::vector<Data> conformed_data;
+        
+        for (size_t chunk = begin ; chunk < end ; chunk++) {
+            
+            size_t first = chunk * kRecordsPerChunk;
+            size_t last = std::min(first + kRecordsPerChunk, data.size());
+            
+            /*
+             * The fixed copy keeps a record's values on the stack and the
+             * quantized copy in buffers of every thread, so both run a
+             * record at a time, with the chunks still split between threads.
+             */
+            if (m_fixed || m_quantized) {
+                
+                for (size_t index = first ; index < last ; index++)
+                    results[index] = Estimate(data[index]);
+                
+                continue;
+            }
+            
+            conformed_data.clear();
+            
+            for (size_t index = first ; index < last ; index++)
+                conformed_data.push_back(ConformData(data[index]));
+            
+            const std::vector<Scalar>& outputs = m_network->FeedBatch(conformed_data, workspace);
+            size_t size = outputs.size() / conformed_data.size();
+            
+            for (size_t index = first ; index < last ; index++)
+                results[index] = MaximalIndex(outputs.data() + (index - first) * size, size);
         }
+    };
     
-    return max_pos;
+    //A single chunk is better off with the layers split between the threads
+    if (m_pool && chunks > 1)   m_pool->Run(chunks, 1, estimate);
+    else                        estimate(0, chunks);
+}
+    
+template <typename Scalar>
+void CombinedNetworkImplementation<Scalar>::Quantize(const std::vector<Data>& calibration) {
+    
+    std::unique_ptr<QuantizedNetwork> quantized(new QuantizedNetwork(m_network->Serialize()));
+    
+    for (size_t index = 0, total = calibration.size() ; index < total ; index++)
+        quantized->Calibrate(ConformData(calibration[index]));
+    
+    quantized->Quantize();
+    m_quantized = std::move(quantized);
+    m_fixed.reset();
+}
+
+template <typename Scalar>
+bool CombinedNetworkImplementation<Scalar>::Specialize() {
+    
+    //The fixed copy reads the same form that is saved to files
+    m_fixed = FixedTopology::Load(m_network->Serialize());
+    
+    if (!m_fixed)
+        return false;
+    
+    m_fixed->SetFastActivation(m_fast_activation);
+    m_quantized.reset();
+    return true;
+}
+
+template <typename Scalar>
+void CombinedNetworkImplementation<Scalar>::SetFastActivation(bool fast) {
+    
+    m_fast_activation = fast;
+    m_network->SetFastActivation(fast);
+    
+    if (m_fixed)
+        m_fixed->SetFastActivation(fast);
+}
+
+template <typename Scalar>
+void CombinedNetworkImplementation<Scalar>::SetThreads(size_t threads) {
+    
+    //The layers must let go of the old pool before it is destroyed
+    m_network->SetThreadPool(NULL);
+    m_pool.reset((threads != 1) ? new ThreadPool(threads) : NULL);
+    m_network->SetThreadPool(m_pool.get());
+}
+
+template <typename Scalar>
+void CombinedNetworkImplementation<Scalar>::SetPipelineStages(size_t stages) {
+    m_network->SetPipelineStages(stages);
+}
+
+template <typename Scalar>
+std::vector<PipelineStage> CombinedNetworkImplementation<Scalar>::PipelineStages() const {
+    return m_network->PipelineStages();
+}
+
+template <typename Scalar>
+size_t CombinedNetworkImplementation<Scalar>::Inputs() const {
+    return kInputs;
+}
+
+template <typename Scalar>
+size_t CombinedNetworkImplementation<Scalar>::Outputs() const {
+    return m_network->Layers().back()->Size();
 }
 
-void CombinedNetworkImplementation::Train(const neural::Data &data, size_t key) {
+template <typename Scalar>
+size_t CombinedNetworkImplementation<Scalar>::Bytes() const {
+    return (m_quantized) ? m_quantized->Bytes() : m_network->Bytes();
+}
+
+template <typename Scalar>
+void CombinedNetworkImplementation<Scalar>::ExportParameters(std::vector<double>& parameters) const {
+    
+    parameters.resize(m_network->Parameters());
+    m_network->ExportParameters(parameters.data());
+}
+
+template <typename Scalar>
+void CombinedNetworkImplementation<Scalar>::ImportParameters(const std::vector<double>& parameters) {
+    
+    //The copies no longer match the weights
+    m_quantized.reset();
+    m_fixed.reset();
+    m_network->ImportParameters(parameters.data());
+}
+
+template <typename Scalar>
+void CombinedNetworkImplementation<Scalar>::Train(const neural::Data &data, size_t key) {
+    
+    //The copies no longer match the weights
+    m_quantized.reset();
+    m_fixed.reset();
     
     Data modified_result;
     modified_result.content = std::vector<double>(10, 0.0);
@@ -61,12 +289,100 @@ void CombinedNetworkImplementation::Train(const neural::Data &data, size_t key)
     m_network->Train(ConformData(data), modified_result);
 }
 
-Data CombinedNetworkImplementation::ConformData(const neural::Data &data) const {
+template <typename Scalar>
+void CombinedNetworkImplementation<Scalar>::TrainBatch(const std::vector<Data>& data, const std::vector<size_t>& keys) {
+    
+    //The copies no longer match the weights
+    m_quantized.reset();
+    m_fixed.reset();
+    
+    std::vector<Data> conformed_data;
+    std::vector<Data> modified_results(keys.size());
+    conformed_data.reserve(data.size());
+    
+    for (size_t index = 0, total = data.size() ; index < total ; index++) {
+        
+        conformed_data.push_back(ConformData(data[index]));
+        
+        modified_results[index].content = std::vector<double>(10, 0.0);
+        modified_results[index].content[keys[index]] = 1.0;
+    }
+    
+    m_network->TrainBatch(conformed_data, modified_results);
+}
+
+template <typename Scalar>
+void CombinedNetworkImplementation<Scalar>::BeginConcurrentTraining(size_t threads) {
+    
+    //The copies no longer match the weights
+    m_quantized.reset();
+    m_fixed.reset();
+    m_workspaces.resize(threads);
+    
+    //Every thread runs whole records, the pool would only make them wait for each other
+    m_network->SetThreadPool(NULL);
+}
+
+template <typename Scalar>
+void CombinedNetworkImplementation<Scalar>::TrainConcurrently(const Data& data, size_t key, size_t thread) {
+    
+    Data modified_result;
+    modified_result.content = std::vector<double>(10, 0.0);
+    modified_result.content[key] = 1.0;
+    
+    /*
+     * The weights are shared by all threads without locks (Hogwild). The
+     * races are on single aligned values, which are read and written whole,
+     * so a thread sees either the old or the new value of a weight. When two
+     * threads update the same weight at once one of the updates is lost,
+     * which the training tolerates. The data is sparse, so the first layer
+     * (by far the largest) rarely sees two threads on the same row.
+     */
+    m_network->Train(ConformData(data), modified_result, m_workspaces[thread]);
+}
+
+template <typename Scalar>
+void CombinedNetworkImplementation<Scalar>::EndConcurrentTraining() {
+    
+    std::vector<Workspace<Scalar> >().swap(m_workspaces);
+    m_network->SetThreadPool(m_pool.get());
+}
+
+template <typename Scalar>
+void CombinedNetworkImplementation<Scalar>::TrainBatchConcurrently(const std::vector<Data>& data, const std::vector<size_t>& keys, ThreadPool& pool) {
+    
+    std::vector<Data> conformed_data;
+    std::vector<Data> modified_results(keys.size());
+    conformed_data.reserve(data.size());
+    
+    for (size_t index = 0, total = data.size() ; index < total ; index++) {
+        
+        conformed_data.push_back(ConformData(data[index]));
+        
+        modified_results[index].content = std::vector<double>(10, 0.0);
+        modified_results[index].content[keys[index]] = 1.0;
+    }
+    
+    m_network->TrainBatch(conformed_data, modified_results, m_workspaces.data(), pool);
+}
+
+template <typename Scalar>
+Data CombinedNetworkImplementation<Scalar>::ConformData(const neural::Data &data) const {
     
     Data modified_data;
-    modified_data.content.reserve(784);
-    for (size_t i = 0 ; i < 784 ; i++)
-        modified_data.content.push_back(data.content.at(i) > 50 ? 1.0 : 0.0);
+    modified_data.content.reserve(kInputs);
+    
+    //Missing values of a short record are taken as unset, so that estimating never throws
+    for (size_t i = 0 ; i < kInputs ; i++)
+        modified_data.content.push_back(i < data.content.size() && data.content[i] > 50 ? 1.0 : 0.0);
+    
+    //List the set pixels, so that the network only touches their weights
+    for (uint32_t i = 0 ; i < kInputs ; i++)
+        if (modified_data.content[i] != 0.0)
+            modified_data.active.push_back(i);
     
     return modified_data;
-}
\ No newline at end of file
+}
+
+template class neural::CombinedNetworkImplementation<double>;
+template class neural::CombinedNetworkImplementation<float>;
@@ -0,0 +1,255 @@
+//
+//  Connection.cpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#include "Connection.hpp"
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <thread>
+#include <chrono>
+
+using namespace neural;
+
+///The prefix of the addresses of Unix domain sockets
+static const std::string kUnixPrefix = "unix:";
+
+///The number of times that 'Connect' tries before it gives up, a tenth of a second apart
+static const size_t kConnectAttempts = 100;
+
+/**
+ * The header that comes before the payload of every message.
+ */
+struct MessageHeader {
+    uint32_t type;
+    uint32_t step;
+    uint64_t bytes;
+};
+
+/**
+ * Creates a socket that is either bound and listening or connected to
+ * an address.
+ *
+ * @param address   The address, as in 'Connection'.
+ * @param listen    True to listen on the address, false to connect to it.
+ * @return The socket, or -1 on failure.
+ */
+static int OpenSocket(const std::string& address, bool listen) {
+    
+    if (address.compare(0, kUnixPrefix.size(), kUnixPrefix) == 0) {
+        
+        std::string path = address.substr(kUnixPrefix.size());
+        sockaddr_un socket_address;
+        
+        if (path.empty() || path.size() >= sizeof(socket_address.sun_path))
+            return -1;
+        
+        memset(&socket_address, 0, sizeof(socket_address));
+        socket_address.sun_family = AF_UNIX;
+        strncpy(socket_address.sun_path, path.c_str(), sizeof(socket_address.sun_path) - 1);
+        
+        int unix_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (unix_socket < 0)
+            return -1;
+        
+        struct stat status;
+        
+        //Only an old socket is removed, a mistyped path must not delete a file
+        if (listen && lstat(path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode))
+            unlink(path.c_str());
+        
+        int result = (listen) ?
+        bind(unix_socket, reinterpret_cast<sockaddr*>(&socket_address), sizeof(socket_address)) :
+        connect(unix_socket, reinterpret_cast<sockaddr*>(&socket_address), sizeof(socket_address));
+        
+        if (result != 0 || (listen && ::listen(unix_socket, SOMAXCONN) != 0)) {
+            
+            close(unix_socket);
+            return -1;
+        }
+        
+        return unix_socket;
+    }
+    
+    //Otherwise it is host:port over TCP
+    size_t delimiter_index = address.find_last_of(':');
+    if (delimiter_index == std::string::npos)
+        return -1;
+    
+    std::string host = address.substr(0, delimiter_index);
+    std::string port = address.substr(delimiter_index + 1);
+    
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = (listen) ? AI_PASSIVE : 0;
+    
+    addrinfo* addresses = NULL;
+    if (getaddrinfo((host.empty()) ? NULL : host.c_str(), port.c_str(), &hints, &addresses) != 0)
+        return -1;
+    
+    int tcp_socket = -1;
+    
+    for (addrinfo* current = addresses ; current && tcp_socket < 0 ; current = current->ai_next) {
+        
+        tcp_socket = socket(current->ai_family, current->ai_socktype, current->ai_protocol);
+        if (tcp_socket < 0)
+            continue;
+        
+        int enable = 1;
+        if (listen)
+            setsockopt(tcp_socket, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+        
+        int result = (listen) ?
+        bind(tcp_socket, current->ai_addr, current->ai_addrlen) :
+        connect(tcp_socket, current->ai_addr, current->ai_addrlen);
+        
+        if (result != 0 || (listen && ::listen(tcp_socket, SOMAXCONN) != 0)) {
+            
+            close(tcp_socket);
+            tcp_socket = -1;
+        }
+    }
+    
+    freeaddrinfo(addresses);
+    return tcp_socket;
+}
+
+#pragma mark - Connection
+
+Connection::Connection(int socket) :
+m_socket(socket) {
+    
+    //The messages are request and reply, they should not wait for more to come
+    int enable = 1;
+    setsockopt(m_socket, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+}
+
+Connection::~Connection() {
+    close(m_socket);
+}
+
+std::unique_ptr<Connection> Connection::Connect(const std::string& address) {
+    
+    for (size_t attempt = 0 ; attempt < kConnectAttempts ; attempt++) {
+        
+        int connected_socket = OpenSocket(address, false);
+        
+        if (connected_socket >= 0)
+            return std::unique_ptr<Connection>(new Connection(connected_socket));
+        
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    
+    return std::unique_ptr<Connection>();
+}
+
+bool Connection::Send(Message type, uint32_t step, const void* payload, size_t bytes) {
+    
+    MessageHeader header = { static_cast<uint32_t>(type), step, bytes };
+    
+    const char* parts[] = { reinterpret_cast<const char*>(&header), static_cast<const char*>(payload) };
+    size_t sizes[] = { sizeof(header), bytes };
+    
+    for (size_t part = 0 ; part < 2 ; part++) {
+        
+        for (size_t sent = 0 ; sent < sizes[part] ; ) {
+            
+            //A closed connection should fail the call, not end the process
+            ssize_t result = send(m_socket, parts[part] + sent, sizes[part] - sent, MSG_NOSIGNAL);
+            
+            if (result < 0 && errno == EINTR)
+                continue;
+            
+            if (result <= 0)
+                return false;
+            
+            sent += result;
+        }
+    }
+    
+    return true;
+}
+
+bool Connection::Receive(Message& type, uint32_t& step, std::vector<char>& payload, size_t max_bytes) {
+    
+    MessageHeader header;
+    char* parts[] = { reinterpret_cast<char*>(&header), NULL };
+    size_t sizes[] = { sizeof(header), 0 };
+    
+    for (size_t part = 0 ; part < 2 ; part++) {
+        
+        //The size of the payload is known once the header arrived, and is not trusted
+        if (part == 1) {
+            
+            if (header.bytes > max_bytes)
+                return false;
+            
+            payload.resize(header.bytes);
+            parts[1] = payload.data();
+            sizes[1] = header.bytes;
+        }
+        
+        for (size_t received = 0 ; received < sizes[part] ; ) {
+            
+            ssize_t result = recv(m_socket, parts[part] + received, sizes[part] - received, 0);
+            
+            if (result < 0 && errno == EINTR)
+                continue;
+            
+            if (result <= 0)
+                return false;
+            
+            received += result;
+        }
+    }
+    
+    type = static_cast<Message>(header.type);
+    step = header.step;
+    
+    return true;
+}
+
+#pragma mark - Listener
+
+Listener::Listener(const std::string& address) :
+m_socket(OpenSocket(address, true)) {
+    
+    if (m_socket >= 0 && address.compare(0, kUnixPrefix.size(), kUnixPrefix) == 0)
+        m_path = address.substr(kUnixPrefix.size());
+}
+
+Listener::~Listener() {
+    
+    if (m_socket >= 0)
+        close(m_socket);
+    
+    if (!m_path.empty())
+        unlink(m_path.c_str());
+}
+
+std::unique_ptr<Connection> Listener::Accept() {
+    
+    int accepted_socket = -1;
+    
+    do {
+        accepted_socket = accept(m_socket, NULL, NULL);
+    } while (accepted_socket < 0 && errno == EINTR);
+    
+    if (accepted_socket < 0)
+        return std::unique_ptr<Connection>();
+    
+    return std::unique_ptr<Connection>(new Connection(accepted_socket));
+}
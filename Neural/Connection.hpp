@@ -0,0 +1,140 @@
+//
+//  Connection.hpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#ifndef Connection_hpp
+#define Connection_hpp
+#include "Definitions.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdint.h>
+NAMESPACE_NEURAL_BEGIN
+
+/**
+ * A stream socket that exchanges whole messages, each a type, a step
+ * and a payload of bytes. The address is either "unix:<path>" for a
+ * Unix domain socket or "<host>:<port>" for TCP. The header and the
+ * payload are sent in the byte order of the machine, so both ends
+ * must share it.
+ */
+class Connection {
+public:
+    
+    enum class Message : uint32_t {
+        kShard,
+        kModel,
+        kPush,
+        kWeights,
+        kDone,
+        kEstimate,
+        kEstimates
+    };
+    
+    /**
+     * Connects to a listening address, trying again for a while so
+     * that the other side may start later.
+     *
+     * @param address   The address to connect to.
+     * @return The connection, or NULL if it could not be made.
+     */
+    static std::unique_ptr<Connection> Connect(const std::string& address);
+    
+    /**
+     * Sends a message.
+     *
+     * @param type      The type of the message.
+     * @param step      The step that the message belongs to.
+     * @param payload   The bytes of the message.
+     * @param bytes     The number of bytes.
+     * @return True if the whole message was sent.
+     */
+    bool Send(Message type, uint32_t step, const void* payload, size_t bytes);
+    
+    /**
+     * Waits for a whole message.
+     *
+     * @param type      Receives the type of the message.
+     * @param step      Receives the step that the message belongs to.
+     * @param payload   Receives the bytes of the message.
+     * @param max_bytes The largest payload that is accepted, a header of a
+     *                  larger one fails the call before anything is allocated.
+     * @return True if a whole message was received, false if the
+     *         connection was closed or failed, or the payload is too large.
+     */
+    bool Receive(Message& type, uint32_t& step, std::vector<char>& payload, size_t max_bytes = kMaxPayload);
+    
+    ///The largest payload that 'Receive' accepts by default, far above the size of a network
+    static const size_t kMaxPayload = static_cast<size_t>(1) << 30;
+    
+    /**
+     * Destructor.
+     */
+    ~Connection();
+    
+private:
+    
+    friend class Listener;
+    
+    /**
+     * Constructor.
+     *
+     * @param socket    The connected socket, which the connection closes.
+     */
+    Connection(int socket);
+    
+    ///Stores the socket
+    int m_socket;
+    
+};
+
+/**
+ * Accepts the connections to an address.
+ */
+class Listener {
+public:
+    
+    /**
+     * Constructor.
+     *
+     * @param address   The address to listen on, as in 'Connection'. An
+     *                  old Unix domain socket file at the path is removed,
+     *                  any other file makes listening fail.
+     */
+    Listener(const std::string& address);
+    
+    /**
+     * Returns true if the address could be listened on.
+     *
+     * @return The state of the listener.
+     */
+    bool Listening() const { return m_socket >= 0; }
+    
+    /**
+     * Waits for the next connection.
+     *
+     * @return The connection, or NULL if accepting failed.
+     */
+    std::unique_ptr<Connection> Accept();
+    
+    /**
+     * Destructor.
+     */
+    ~Listener();
+    
+private:
+    
+    ///Stores the listening socket
+    int m_socket;
+    
+    ///Stores the path of a Unix domain socket, to remove it at the end
+    std::string m_path;
+    
+};
+
+NAMESPACE_NEURAL_END
+#endif /* Connection_hpp */
@@ -10,12 +10,16 @@
 #define Data_hpp
 #include "Definitions.h"
 #include <vector>
+#include <stdint.h>
 NAMESPACE_NEURAL_BEGIN
 
 class Data {
 public:
     
     std::vector<double> content;
+    
+    ///The indices of the values that are 1 when the content is binary (only 0 or 1), empty otherwise
+    std::vector<uint32_t> active;
 };
 
 NAMESPACE_NEURAL_END
@@ -7,15 +7,61 @@
 //
 
 #include "DataIterator.hpp"
+#include "RecordFile.hpp"
 #include <fstream>
-#include <sstream>
 #include <algorithm>
 #include <iterator>
+#include <charconv>
+#include <string.h>
 
 using namespace neural;
 
+void neural::ParseRecord(const char* begin, const char* end, std::vector<double>& values) {
+    
+    values.clear();
+    
+    //Every value takes a digit and a ',' at the least, so the values never outgrow this
+    size_t most_values = (end - begin + 1) / 2;
+    
+    if (values.capacity() < most_values)
+        values.reserve(most_values);
+    
+    for (const char* position = begin ; position != end ; ) {
+        
+        int value;
+        std::from_chars_result result = std::from_chars(position, end, value);
+        
+        //The conversion stops at the ',' itself, so a value that is only digits needs no search
+        if (result.ec == std::errc() && (result.ptr == end || *result.ptr == ',')) {
+            
+            values.push_back(value);
+            position = result.ptr;
+        }
+        else {
+            
+            //Spaces, a '+' or anything after the digits (such as a '\r') are left to 'std::stoi'
+            const char* delimiter = static_cast<const char*>(memchr(position, ',', end - position));
+            const char* value_end = (delimiter) ? delimiter : end;
+            
+            values.push_back(std::stoi(std::string(position, value_end)));
+            position = value_end;
+        }
+        
+        //A ',' at the end of the record does not begin another value
+        if (position != end)
+            position++;
+    }
+}
+
 size_t neural::RecordsInFile(const std::string &file_path) {
     
+    //A binary record file has the count in it's header
+    if (RecordFile::Recognize(file_path)) {
+        
+        std::unique_ptr<RecordFile> records = RecordFile::Open(file_path);
+        return (records) ? records->Records() : 0;
+    }
+    
     std::ifstream myfile(file_path);
     
     // new lines will be skipped unless we stop it from happening:
@@ -35,13 +81,19 @@ public:
     
     void Next();
     
-    Data Value() const;
+    void Value(Data& data) const;
     
     bool Valid() const;
     
     
 private:
     
+    ///Stores the mapped binary record file, NULL when the input file is text
+    std::unique_ptr<RecordFile> m_records;
+    
+    ///Stores the index of the current record of the binary file
+    size_t m_index;
+    
     ///Stores the file stream that reads the input file
     std::fstream m_file_stream;
     
@@ -53,32 +105,42 @@ private:
 #pragma mark - Implementation
 
 DataIterator::Impl::Impl(const std::string& file_path) :
-m_file_stream(file_path) {
+m_index(0) {
+    
+    //Binary record files are mapped and read without parsing
+    if (RecordFile::Recognize(file_path)) {
+        
+        m_records = RecordFile::Open(file_path);
+        return;
+    }
+    
+    m_file_stream.open(file_path);
     
     //The iterator starts an the first position that has a value
     Next();
 }
 
 void DataIterator::Impl::Next() {
-    std::getline(m_file_stream, m_value);
+    
+    if (m_records)  m_index++;
+    else            std::getline(m_file_stream, m_value);
 }
 
-Data DataIterator::Impl::Value() const {
-    
-    Data data;
-    
-    std::string value;
-    std::stringstream string_stream(m_value);
+void DataIterator::Impl::Value(Data& data) const {
     
-    //Get every number seperated by ','
-    while (std::getline(string_stream, value, ','))
-        data.content.push_back(std::stoi(value));
+    data.active.clear();
     
-    return data;
+    if (m_records) {
+        
+        const uint8_t* record = m_records->Record(m_index);
+        data.content.assign(record, record + m_records->Width());
+    }
+    else
+        ParseRecord(m_value.data(), m_value.data() + m_value.size(), data.content);
 }
 
 bool DataIterator::Impl::Valid() const {
-    return !m_value.empty();
+    return (m_records) ? m_index < m_records->Records() : !m_value.empty();
 }
 
 #pragma mark - Data functions
@@ -90,7 +152,15 @@ m_pimpl(new Impl(file_path))
 DataIterator::~DataIterator() = default;
 
 Data DataIterator::Value() const {
-    return m_pimpl->Value();
+    
+    Data data;
+    m_pimpl->Value(data);
+    
+    return data;
+}
+
+void DataIterator::Value(Data& data) const {
+    m_pimpl->Value(data);
 }
 
 void DataIterator::Next() {
@@ -12,6 +12,7 @@
 #include "Data.hpp"
 #include <memory>
 #include <string>
+#include <vector>
 NAMESPACE_NEURAL_BEGIN
 
 /**
@@ -22,6 +23,18 @@ NAMESPACE_NEURAL_BEGIN
  */
 size_t RecordsInFile(const std::string& file_path);
 
+/**
+ * Parses the values of a record of a text file, seperated by ','. The
+ * values are the same as those of splitting the record at every ','
+ * and converting every part with 'std::stoi', including the exceptions
+ * of parts that are not numbers.
+ *
+ * @param begin     The beginning of the record.
+ * @param end       The end of the record.
+ * @param values    Receives the values, it's capacity is reused.
+ */
+void ParseRecord(const char* begin, const char* end, std::vector<double>& values);
+
 class DataIterator {
 public:
     
@@ -44,6 +57,15 @@ public:
      */
     Data Value() const;
     
+    /**
+     * Reads the value at the current position of the iterator into a
+     * given record, whose memory is reused, so that reading records one
+     * after the other does not allocate.
+     *
+     * @param data  Receives the data representation of the current position.
+     */
+    void Value(Data& data) const;
+    
     /**
      * Checks if the current position is valid.
      *
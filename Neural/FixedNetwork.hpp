@@ -0,0 +1,377 @@
+//
+//  FixedNetwork.hpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#ifndef FixedNetwork_hpp
+#define FixedNetwork_hpp
+#include "Definitions.h"
+#include "Activation.hpp"
+#include "AlignedAllocator.hpp"
+#include "Perceptron.hpp"
+#include "Kernels.hpp"
+#include "Data.hpp"
+#include <array>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <memory>
+#include <algorithm>
+#include <charconv>
+NAMESPACE_NEURAL_BEGIN
+
+/**
+ * A layer whose sizes are known at compile time. The weights are laid
+ * out as in 'Layer', a row per perceptron (or per input if the layer is
+ * input major) that is padded to a cache line, so that every row
+ * starts aligned.
+ */
+template <typename Scalar, size_t Inputs, size_t Outputs, bool InputMajor>
+struct FixedLayer {
+    
+    ///The distance between the beginning of two rows of weights
+    static constexpr size_t kStride = AlignedStride<Scalar>(InputMajor ? Outputs : Inputs);
+    
+    ///The number of rows of weights
+    static constexpr size_t kRows = InputMajor ? Inputs : Outputs;
+    
+    ///The weights, a padded row per perceptron (or per input)
+    alignas(NEURAL_ALIGNMENT) std::array<Scalar, kRows * kStride> weights;
+    
+    ///The bias of every perceptron
+    alignas(NEURAL_ALIGNMENT) std::array<Scalar, Outputs> biases;
+    
+    ///The activation function of the layer
+    ActivationType activation;
+    
+    ///True to use the fast approximation of the sigmoid
+    bool fast_activation;
+    
+    /**
+     * Calculates the outputs of the layer.
+     *
+     * @param input     The input, 'Inputs' values.
+     * @param output    Receives the outputs.
+     */
+    void Feed(const Scalar* input, Scalar* output) const {
+        
+        //The same kernels and order of sums as 'Layer::Feed', so the results are identical
+        const Kernels<Scalar>& kernels = ActiveKernels<Scalar>();
+        
+        if (InputMajor) {
+            
+            std::copy(biases.begin(), biases.end(), output);
+            
+            for (size_t column = 0 ; column < Inputs ; column++)
+                if (input[column] != 0.0)
+                    kernels.axpy(input[column], weights.data() + column * kStride, output, Outputs);
+        }
+        else {
+            
+            for (size_t row = 0 ; row < Outputs ; row++)
+                output[row] = kernels.dot(weights.data() + row * kStride, input, Inputs) + biases[row];
+        }
+        
+        Activate(output);
+    }
+    
+    /**
+     * Calculates the outputs of the layer for a binary input.
+     *
+     * @param active    The indices of the inputs that are set.
+     * @param count     The number of set inputs.
+     * @param output    Receives the outputs.
+     */
+    void FeedSparse(const uint32_t* active, size_t count, Scalar* output) const {
+        
+        //The rows of the set inputs, added in the same order as 'Layer::FeedSparse'
+        if (InputMajor) {
+            
+            const Kernels<Scalar>& kernels = ActiveKernels<Scalar>();
+            std::copy(biases.begin(), biases.end(), output);
+            
+            for (size_t index = 0 ; index < count ; index++)
+                kernels.axpy(1.0, weights.data() + active[index] * kStride, output, Outputs);
+            
+            Activate(output);
+            return;
+        }
+        
+        for (size_t row = 0 ; row < Outputs ; row++) {
+            
+            const Scalar* weights_row = weights.data() + row * kStride;
+            Scalar sum = biases[row];
+            
+            for (size_t index = 0 ; index < count ; index++)
+                sum += weights_row[active[index]];
+            
+            output[row] = sum;
+        }
+        
+        Activate(output);
+    }
+    
+    /**
+     * Applies the activation function on the outputs of the layer.
+     *
+     * @param output    The outputs, which are replaced by their activations.
+     */
+    void Activate(Scalar* output) const {
+        
+        if (activation == ActivationType::kSigmoid && fast_activation)
+            ActiveKernels<Scalar>().fast_sigmoid(output, output, Outputs);
+        else
+            neural::Activate(activation, output, Outputs);
+    }
+    
+    /**
+     * Reads the layer in the form that 'Layer::Serialize' writes, after
+     * the line of the size (and activation) of the layer.
+     *
+     * @param serialized    The stream to read from.
+     * @return True if the layer had the sizes of the template.
+     */
+    bool Deserialize(std::istream& serialized) {
+        
+        std::string read_line;
+        
+        if (!std::getline(serialized, read_line) || read_line.empty())
+            return false;
+        
+        //The activation follows the size, layers from before it was saved are sigmoid
+        size_t separator = read_line.find(' ');
+        activation = ActivationType::kSigmoid;
+        
+        if (separator != std::string::npos && !ActivationFromName(read_line.substr(separator + 1), activation))
+            return false;
+        
+        fast_activation = false;
+        
+        //A size that is not a number is a mismatch as well, not an error
+        const char* size_end = read_line.data() + std::min(separator, read_line.size());
+        size_t size = 0;
+        std::from_chars_result result = std::from_chars(read_line.data(), size_end, size);
+        
+        if (result.ec != std::errc() || result.ptr != size_end || size != Outputs)
+            return false;
+        
+        //The padding stays zero, the learning constant is of no use here
+        weights.fill(0);
+        Scalar learning_constant;
+        std::array<Scalar, Inputs> perceptron_weights;
+        
+        for (size_t row = 0 ; row < Outputs ; row++) {
+            
+            //A perceptron with another number of weights does not fit the topology
+            if (!std::getline(serialized, read_line) || !Perceptron<Scalar>(perceptron_weights.data(), Inputs, biases[row], learning_constant).Deserialize(read_line))
+                return false;
+            
+            for (size_t column = 0 ; column < Inputs ; column++)
+                weights[(InputMajor) ? column * kStride + row : row * kStride + column] = perceptron_weights[column];
+        }
+        
+        return true;
+    }
+};
+
+/**
+ * The layers of a fixed network, the first one followed by the rest.
+ * Only the first layer may be input major, as in 'BasicNetwork'.
+ */
+template <typename Scalar, bool InputMajor, size_t Inputs, size_t... Sizes>
+struct FixedLayers;
+
+template <typename Scalar, bool InputMajor, size_t Inputs, size_t Outputs, size_t... Sizes>
+struct FixedLayers<Scalar, InputMajor, Inputs, Outputs, Sizes...> {
+    
+    typedef FixedLayers<Scalar, false, Outputs, Sizes...> Next;
+    
+    ///The number of outputs of the last layer
+    static constexpr size_t kOutputs = Next::kOutputs;
+    
+    ///The layer
+    FixedLayer<Scalar, Inputs, Outputs, InputMajor> layer;
+    
+    ///The layers after it
+    Next next;
+    
+    /**
+     * Calculates the outputs of the last layer. The outputs of every
+     * layer are kept on the stack.
+     *
+     * @param input     The input of the first layer.
+     * @param results   Receives the outputs of the last layer.
+     */
+    void Feed(const Scalar* input, Scalar* results) const {
+        
+        alignas(NEURAL_ALIGNMENT) std::array<Scalar, AlignedStride<Scalar>(Outputs)> outputs = { };
+        
+        layer.Feed(input, outputs.data());
+        next.Feed(outputs.data(), results);
+    }
+    
+    /**
+     * Calculates the outputs of the last layer for a binary input.
+     *
+     * @param active    The indices of the inputs that are set.
+     * @param count     The number of set inputs.
+     * @param results   Receives the outputs of the last layer.
+     */
+    void FeedSparse(const uint32_t* active, size_t count, Scalar* results) const {
+        
+        alignas(NEURAL_ALIGNMENT) std::array<Scalar, AlignedStride<Scalar>(Outputs)> outputs = { };
+        
+        layer.FeedSparse(active, count, outputs.data());
+        next.Feed(outputs.data(), results);
+    }
+    
+    /**
+     * Chooses between the exact sigmoid and a fast approximation.
+     *
+     * @param fast  True to use the approximation.
+     */
+    void SetFastActivation(bool fast) {
+        
+        layer.fast_activation = fast;
+        next.SetFastActivation(fast);
+    }
+    
+    /**
+     * Reads the layers in the form that 'BasicNetwork::Serialize' writes.
+     *
+     * @param serialized    The stream to read from.
+     * @return True if the layers had the sizes of the template.
+     */
+    bool Deserialize(std::istream& serialized) {
+        return layer.Deserialize(serialized) && next.Deserialize(serialized);
+    }
+};
+
+template <typename Scalar, bool InputMajor, size_t Inputs>
+struct FixedLayers<Scalar, InputMajor, Inputs> {
+    
+    ///The number of outputs of the last layer
+    static constexpr size_t kOutputs = Inputs;
+    
+    void Feed(const Scalar* input, Scalar* results) const { std::copy(input, input + Inputs, results); }
+    
+    void SetFastActivation(bool /*fast*/) { }
+    
+    /**
+     * Checks that there are no more layers to read.
+     *
+     * @param serialized    The stream to read from.
+     * @return True if the stream has no more layers.
+     */
+    bool Deserialize(std::istream& serialized) {
+        
+        std::string read_line;
+        return !std::getline(serialized, read_line) || read_line.empty();
+    }
+};
+
+/**
+ * A network whose layer sizes are compile time constants: the number
+ * of inputs, followed by the number of perceptrons of every layer. The
+ * loops over the weights have known bounds, the weights are held in
+ * place instead of on the heap, and the intermediate results of a
+ * record live on the stack, so estimating allocates nothing and any
+ * number of threads may estimate at once. The first layer is input
+ * major, so that a binary record only adds the rows of it's set values.
+ *
+ * A fixed network only estimates. It is loaded from the form that
+ * 'BasicNetwork::Serialize' writes, and the sizes must match.
+ */
+template <typename Scalar, size_t... Sizes>
+class BasicFixedNetwork {
+    
+    static_assert(sizeof...(Sizes) >= 2, "A network needs the number of inputs and at least one layer");
+    
+public:
+    
+    ///The number of outputs of the network
+    static constexpr size_t kOutputs = FixedLayers<Scalar, true, Sizes...>::kOutputs;
+    
+    /**
+     * Loads a network that was serialized by 'BasicNetwork::Serialize'.
+     * The network is too large for the stack, so it is always created
+     * on the heap.
+     *
+     * @param serialized    The serialized form of the network.
+     * @return The network, or NULL if the sizes of the serialized
+     *         network are not those of the template.
+     */
+    static std::unique_ptr<BasicFixedNetwork> Load(const std::string& serialized) {
+        
+        std::unique_ptr<BasicFixedNetwork> network(new BasicFixedNetwork());
+        std::istringstream stream(serialized);
+        
+        if (!network->m_layers.Deserialize(stream))
+            network.reset();
+        
+        return network;
+    }
+    
+    /**
+     * Returns the number of inputs, followed by the number of
+     * perceptrons of every layer.
+     *
+     * @return The sizes.
+     */
+    static std::vector<size_t> LayerSizes() { return { Sizes... }; }
+    
+    /**
+     * Chooses between the exact sigmoid (the default) and a fast
+     * approximation in every layer of the network.
+     *
+     * @param fast  True to use the approximation.
+     */
+    void SetFastActivation(bool fast) { m_layers.SetFastActivation(fast); }
+    
+    /**
+     * Gets a data to process and returns the result. Records that list
+     * their set values in 'Data::active' only sum the weights of those
+     * values in the first layer.
+     *
+     * @param data      The data to process.
+     * @param results   Receives the last layer's results.
+     */
+    void Feed(const Data& data, std::array<Scalar, kOutputs>& results) const {
+        
+        if (!data.active.empty()) {
+            
+            m_layers.FeedSparse(data.active.data(), data.active.size(), results.data());
+            return;
+        }
+        
+        alignas(NEURAL_ALIGNMENT) std::array<Scalar, AlignedStride<Scalar>(kInputs)> input = { };
+        std::copy(data.content.begin(), data.content.begin() + kInputs, input.begin());
+        
+        m_layers.Feed(input.data(), results.data());
+    }
+    
+private:
+    
+    BasicFixedNetwork() { }
+    
+    ///The number of inputs of the network
+    static constexpr size_t kInputs = std::array<size_t, sizeof...(Sizes)>{ { Sizes... } }[0];
+    
+    ///Stores the layers
+    FixedLayers<Scalar, true, Sizes...> m_layers;
+    
+};
+
+///A fixed network of doubles
+template <size_t... Sizes>
+using FixedNetwork = BasicFixedNetwork<double, Sizes...>;
+
+///A fixed network of floats
+template <size_t... Sizes>
+using FloatFixedNetwork = BasicFixedNetwork<float, Sizes...>;
+
+NAMESPACE_NEURAL_END
+#endif /* FixedNetwork_hpp */
@@ -0,0 +1,313 @@
+//
+//  InferenceServer.cpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#include "InferenceServer.hpp"
+#include "OperationalNetwork.hpp"
+#include "ModelHandle.hpp"
+#include "Connection.hpp"
+#include "Data.hpp"
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <iterator>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+using namespace neural;
+
+///The number of seconds between two reports of the statistics
+static const std::chrono::seconds kReportInterval(5);
+
+///The most records that a single request may hold, a larger one ends the connection
+static const size_t kMaxRecordsPerRequest = 4096;
+
+/**
+ * Implementation.
+ */
+class InferenceServer::Impl {
+public:
+    
+    /**
+     * Constructor.
+     *
+     * @param model         The network to estimate with.
+     * @param address       The address to listen on.
+     * @param batch_size    The number of records that runs a batch at once.
+     * @param max_wait      The longest time in microseconds that a request waits for others.
+     */
+    Impl(const ModelHandle& model, const std::string& address, size_t batch_size, size_t max_wait);
+    
+    /**
+     * Serves the clients until the process ends.
+     *
+     * @param log   Flag that indicates to print the statistics to consule.
+     * @return False if the address could not be listened on.
+     */
+    bool Run(bool log);
+    
+private:
+    
+    /**
+     * A request of a client that waits for it's estimations.
+     */
+    struct Request {
+        
+        ///The records to estimate
+        std::vector<Data> records;
+        
+        ///The estimation of every record
+        std::vector<double> results;
+        
+        ///The time in which the request was received
+        std::chrono::steady_clock::time_point arrival;
+        
+        ///True once the results are ready
+        bool answered;
+    };
+    
+    /**
+     * Receives the requests of a client and replies with the estimations,
+     * until the client leaves. Runs on a thread per client.
+     *
+     * @param connection    The connection to the client.
+     */
+    void Serve(std::unique_ptr<Connection> connection);
+    
+    /**
+     * Gathers the waiting requests into batches and estimates them.
+     * Runs on a thread of it's own, the only reader of the network.
+     *
+     * @param log   Flag that indicates to print the statistics to consule.
+     */
+    void Estimate(bool log);
+    
+    ///Stores the network
+    const ModelHandle& m_model;
+    
+    ///Stores the address to listen on
+    std::string m_address;
+    
+    ///Stores the number of records that runs a batch at once
+    size_t m_batch_size;
+    
+    ///Stores the longest time that a request waits for others
+    std::chrono::microseconds m_max_wait;
+    
+    ///Stores the number of values of every record, which every version of the network takes
+    size_t m_inputs;
+    
+    ///Stores the requests that wait for a batch, oldest first
+    std::deque<Request*> m_requests;
+    
+    ///Stores the number of records of the waiting requests
+    size_t m_queued_records;
+    
+    ///Guards the waiting requests and the answers
+    std::mutex m_mutex;
+    
+    ///Wakes the batching thread when a request arrives
+    std::condition_variable m_arrived;
+    
+    ///Wakes the clients when their requests are answered
+    std::condition_variable m_answered;
+    
+};
+
+#pragma mark - Implementation
+
+InferenceServer::Impl::Impl(const ModelHandle& model, const std::string& address, size_t batch_size, size_t max_wait) :
+m_model(model),
+m_address(address),
+m_batch_size(std::max<size_t>(batch_size, 1)),
+m_max_wait(max_wait),
+m_inputs(model.Read(0)->Inputs()),
+m_queued_records(0)
+{ }
+
+bool InferenceServer::Impl::Run(bool log) {
+    
+    Listener listener(m_address);
+    
+    if (!listener.Listening())
+        return false;
+    
+    if (log)
+        std::cout
+        << "serving on " << m_address << " in batches of up to " << m_batch_size << " records, "
+        << "waiting at most " << m_max_wait.count() << " microseconds\n" << std::flush;
+    
+    std::thread(&InferenceServer::Impl::Estimate, this, log).detach();
+    
+    while (true) {
+        
+        std::unique_ptr<Connection> connection = listener.Accept();
+        
+        if (connection)
+            std::thread(&InferenceServer::Impl::Serve, this, std::move(connection)).detach();
+    }
+}
+
+void InferenceServer::Impl::Serve(std::unique_ptr<Connection> connection) {
+    
+    Request request;
+    std::vector<char> payload;
+    Connection::Message type;
+    uint32_t records;
+    
+    size_t record_bytes = m_inputs * sizeof(double);
+    
+    //A client that sends anything but whole records of the network's inputs is dropped
+    while (connection->Receive(type, records, payload, kMaxRecordsPerRequest * record_bytes) && type == Connection::Message::kEstimate) {
+        
+        request.arrival = std::chrono::steady_clock::now();
+        
+        if (records == 0 || records > kMaxRecordsPerRequest || payload.size() != records * record_bytes)
+            return;
+        
+        const double* contents = reinterpret_cast<const double*>(payload.data());
+        
+        request.records.resize(records);
+        request.answered = false;
+        
+        for (size_t record = 0 ; record < records ; record++)
+            request.records[record].content.assign(contents + record * m_inputs, contents + (record + 1) * m_inputs);
+        
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            
+            m_requests.push_back(&request);
+            m_queued_records += records;
+            m_arrived.notify_one();
+            
+            m_answered.wait(lock, [&request]() { return request.answered; });
+        }
+        
+        if (!connection->Send(Connection::Message::kEstimates, records, request.results.data(), request.results.size() * sizeof(double)))
+            return;
+    }
+}
+
+void InferenceServer::Impl::Estimate(bool log) {
+    
+    std::vector<Request*> batch;
+    std::vector<Data> records;
+    std::vector<double> results;
+    
+    //The statistics since the last report
+    std::vector<double> latencies;
+    size_t served_records = 0;
+    size_t batches = 0;
+    size_t version = 0;
+    auto report_start = std::chrono::steady_clock::now();
+    
+    if (log) { std::cout << std::fixed << std::setprecision(3); }
+    
+    while (true) {
+        
+        batch.clear();
+        records.clear();
+        
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            
+            //An idle server still wakes up to report
+            m_arrived.wait_until(lock, report_start + kReportInterval, [this]() { return !m_requests.empty(); });
+            
+            if (!m_requests.empty()) {
+                
+                //The batch fills up, or the oldest request waited long enough
+                m_arrived.wait_until(lock, m_requests.front()->arrival + m_max_wait, [this]() { return m_queued_records >= m_batch_size; });
+                
+                //Whole requests, oldest first, a request larger than a batch runs alone
+                while (!m_requests.empty() && (batch.empty() || records.size() + m_requests.front()->records.size() <= m_batch_size)) {
+                    
+                    Request* request = m_requests.front();
+                    m_requests.pop_front();
+                    
+                    records.insert(records.end(),
+                                   std::make_move_iterator(request->records.begin()),
+                                   std::make_move_iterator(request->records.end()));
+                    
+                    batch.push_back(request);
+                }
+                
+                m_queued_records -= records.size();
+            }
+        }
+        
+        if (!batch.empty()) {
+            
+            //A newer version may be published meanwhile, the batch keeps the one it started with
+            ModelHandle::Snapshot network = m_model.Read(0);
+            network->EstimateBatch(records).swap(results);
+            version = network.Version();
+            
+            auto answered = std::chrono::steady_clock::now();
+            
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                
+                for (size_t request = 0, offset = 0 ; request < batch.size() ; request++) {
+                    
+                    size_t count = batch[request]->records.size();
+                    
+                    batch[request]->results.assign(results.begin() + offset, results.begin() + offset + count);
+                    batch[request]->answered = true;
+                    
+                    std::chrono::duration<double> latency = answered - batch[request]->arrival;
+                    latencies.push_back(latency.count());
+                    offset += count;
+                }
+                
+                m_answered.notify_all();
+            }
+            
+            served_records += records.size();
+            batches++;
+        }
+        
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - report_start;
+        
+        if (elapsed < kReportInterval)
+            continue;
+        
+        if (log && !latencies.empty()) {
+            
+            std::sort(latencies.begin(), latencies.end());
+            
+            std::cout
+            << latencies.size() << " requests (" << served_records << " records) in " << batches << " batches:\t"
+            << latencies.size() / elapsed.count() << " requests/sec\t"
+            << served_records / elapsed.count() << " records/sec\t"
+            << "latency p50 " << latencies[(latencies.size() - 1) / 2] * 1000 << " ms\t"
+            << "p99 " << latencies[(latencies.size() - 1) * 99 / 100] * 1000 << " ms\t"
+            << "version " << version << '\n' << std::flush;
+        }
+        
+        latencies.clear();
+        served_records = 0;
+        batches = 0;
+        report_start = std::chrono::steady_clock::now();
+    }
+}
+
+#pragma mark - InferenceServer functions
+
+InferenceServer::InferenceServer(const ModelHandle& model, const std::string& address, size_t batch_size, size_t max_wait) :
+m_pimpl(new Impl(model, address, batch_size, max_wait))
+{ }
+
+InferenceServer::~InferenceServer() { };
+
+bool InferenceServer::Run(bool log) {
+    return m_pimpl->Run(log);
+}
@@ -0,0 +1,75 @@
+//
+//  InferenceServer.hpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#ifndef InferenceServer_hpp
+#define InferenceServer_hpp
+#include "Definitions.h"
+#include <string>
+#include <memory>
+NAMESPACE_NEURAL_BEGIN
+class ModelHandle;
+
+/**
+ * Serves the estimations of a loaded network to clients (see
+ * 'LoadGenerator') that connect to an address, so that the network is
+ * read once instead of on every run. The network may be replaced
+ * through it's handle while the server runs, every batch runs on the
+ * version that is current when the batch starts. A client sends a request of one
+ * or more records ('Connection::Message::kEstimate', the step holds the
+ * number of records and the payload their values as doubles) and
+ * receives the estimation of every record in a 'kEstimates' reply.
+ *
+ * The requests of all the clients are gathered into micro-batches: a
+ * batch runs once it has 'batch_size' records, or once it's oldest
+ * request waited 'max_wait' microseconds, whichever comes first. A
+ * longer wait makes larger batches, which run faster per record, at
+ * the cost of the latency of requests that come when the server is idle.
+ */
+class InferenceServer {
+public:
+    
+    /**
+     * Constructor.
+     *
+     * @param model         The network to estimate with. The server reads it
+     *                      as reader 0, and it's versions must not be used
+     *                      by anything else while the server runs.
+     * @param address       The address to listen on, "unix:<path>" or "<host>:<port>".
+     * @param batch_size    The number of records that runs a batch at once.
+     * @param max_wait      The longest time in microseconds that a request waits for others.
+     */
+    InferenceServer(const ModelHandle& model,
+                    const std::string& address,
+                    size_t batch_size = 64,
+                    size_t max_wait = 1000);
+    
+    /**
+     * Serves the clients until the process ends. Every few seconds in
+     * which requests arrived, the throughput and the 50th and 99th
+     * percentiles of the latency (from the arrival of a request until
+     * it's reply is ready) are printed.
+     *
+     * @param log   Flag that indicates to print the statistics to consule.
+     * @return False if the address could not be listened on.
+     */
+    bool Run(bool log = true);
+    
+    /**
+     * Destructor.
+     */
+    ~InferenceServer();
+    
+private:
+    
+    class Impl;
+    std::unique_ptr<Impl> m_pimpl;
+    
+};
+
+NAMESPACE_NEURAL_END
+#endif /* InferenceServer_hpp */
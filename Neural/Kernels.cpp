@@ -0,0 +1,158 @@
+//
+//  Kernels.cpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#include "Kernels.hpp"
+#include <stdlib.h>
+#include <string>
+
+using namespace neural;
+
+template <typename Scalar>
+static Scalar ScalarDot(const Scalar* a, const Scalar* b, size_t count) {
+    
+    Scalar sum = 0.0;
+    
+    for (size_t index = 0 ; index < count ; index++)
+        sum += a[index] * b[index];
+    
+    return sum;
+}
+
+template <typename Scalar>
+static void ScalarAxpy(Scalar alpha, const Scalar* x, Scalar* y, size_t count) {
+    
+    for (size_t index = 0 ; index < count ; index++)
+        y[index] += alpha * x[index];
+}
+
+template <typename Scalar>
+static void ScalarSigmoidDelta(const Scalar* outputs, const Scalar* errors, Scalar* deltas, size_t count) {
+    
+    for (size_t index = 0 ; index < count ; index++)
+        deltas[index] = outputs[index] * (1.0 - outputs[index]) * errors[index];
+}
+
+static int32_t ScalarQuantizedDot(const uint8_t* a, const int8_t* b, size_t count) {
+    
+    int32_t sum = 0;
+    
+    for (size_t index = 0 ; index < count ; index++)
+        sum += a[index] * b[index];
+    
+    return sum;
+}
+
+template <typename Scalar>
+static void ScalarFastSigmoid(const Scalar* values, Scalar* outputs, size_t count) {
+    
+    for (size_t index = 0 ; index < count ; index++)
+        outputs[index] = FastSigmoid(values[index]);
+}
+
+/**
+ * Picks the widest kernels that the host supports.
+ *
+ * @return The kernels to use.
+ */
+template <typename Scalar>
+static const Kernels<Scalar>& SelectKernels() {
+    
+    const char* forced = getenv("NEURAL_KERNELS");
+    std::string requested = (forced) ? forced : "";
+    
+    if (requested == "scalar")
+        return ScalarKernels<Scalar>();
+
+#if NEURAL_X86
+    
+    __builtin_cpu_init();
+    
+    bool avx512 = __builtin_cpu_supports("avx512f");
+    bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    
+    if (requested == "sse2")                    return SSE2Kernels<Scalar>();
+    if (requested == "avx2" && avx2)            return AVX2Kernels<Scalar>();
+    if (requested == "avx512" && avx512)        return AVX512Kernels<Scalar>();
+    
+    if (avx512)     return AVX512Kernels<Scalar>();
+    if (avx2)       return AVX2Kernels<Scalar>();
+    
+    return SSE2Kernels<Scalar>();
+
+#else
+    
+    return ScalarKernels<Scalar>();
+
+#endif
+}
+
+/**
+ * Picks the widest quantized kernels that the host supports.
+ *
+ * @return The kernels to use.
+ */
+static const QuantizedKernels& SelectQuantizedKernels() {
+    
+    const char* forced = getenv("NEURAL_KERNELS");
+    std::string requested = (forced) ? forced : "";
+    
+    //There are no SSE2 integer kernels, 'pmaddubsw' arrived with SSSE3
+    if (requested == "scalar" || requested == "sse2")
+        return ScalarQuantizedKernels();
+
+#if NEURAL_X86
+    
+    __builtin_cpu_init();
+    
+    bool vnni = __builtin_cpu_supports("avx512vnni") && __builtin_cpu_supports("avx512bw");
+    bool avx2 = __builtin_cpu_supports("avx2");
+    
+    if (requested == "avx2" && avx2)            return AVX2QuantizedKernels();
+    if (requested == "avx512" && vnni)          return AVX512QuantizedKernels();
+    
+    if (vnni)       return AVX512QuantizedKernels();
+    if (avx2)       return AVX2QuantizedKernels();
+
+#endif
+    
+    return ScalarQuantizedKernels();
+}
+
+#pragma mark - Kernel functions
+
+template <typename Scalar>
+const Kernels<Scalar>& neural::ScalarKernels() {
+    
+    static const Kernels<Scalar> kernels = { ScalarDot<Scalar>, ScalarAxpy<Scalar>, ScalarSigmoidDelta<Scalar>, ScalarFastSigmoid<Scalar>, "scalar" };
+    return kernels;
+}
+
+template <typename Scalar>
+const Kernels<Scalar>& neural::ActiveKernels() {
+    
+    //Chosen only once, the first time that it is needed
+    static const Kernels<Scalar>& kernels = SelectKernels<Scalar>();
+    return kernels;
+}
+
+template const Kernels<double>& neural::ScalarKernels<double>();
+template const Kernels<float>& neural::ScalarKernels<float>();
+template const Kernels<double>& neural::ActiveKernels<double>();
+template const Kernels<float>& neural::ActiveKernels<float>();
+
+const QuantizedKernels& neural::ScalarQuantizedKernels() {
+    
+    static const QuantizedKernels kernels = { ScalarQuantizedDot, "scalar" };
+    return kernels;
+}
+
+const QuantizedKernels& neural::ActiveQuantizedKernels() {
+    
+    static const QuantizedKernels& kernels = SelectQuantizedKernels();
+    return kernels;
+}
@@ -0,0 +1,191 @@
+//
+//  Kernels.hpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#ifndef Kernels_hpp
+#define Kernels_hpp
+#include "Definitions.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+NAMESPACE_NEURAL_BEGIN
+
+#if defined(__x86_64__) || defined(__i386__)
+#define NEURAL_X86 1
+#else
+#define NEURAL_X86 0
+#endif
+
+/**
+ * The numeric loops that the network spends it's time in.
+ * Every instruction set has it's own table of kernels, and
+ * the widest one that the host supports is chosen once at
+ * startup, so a single binary runs at full width everywhere.
+ * There is a table per scalar type (float and double).
+ */
+template <typename Scalar>
+struct Kernels {
+    
+    ///Returns the sum of a[i] * b[i]
+    Scalar (*dot)(const Scalar* a, const Scalar* b, size_t count);
+    
+    ///Performs y[i] += alpha * x[i]
+    void (*axpy)(Scalar alpha, const Scalar* x, Scalar* y, size_t count);
+    
+    ///Performs deltas[i] = outputs[i] * (1 - outputs[i]) * errors[i] (the sigmoid derivative)
+    void (*sigmoid_delta)(const Scalar* outputs, const Scalar* errors, Scalar* deltas, size_t count);
+    
+    ///Performs outputs[i] = FastSigmoid(values[i]), may be done in place
+    void (*fast_sigmoid)(const Scalar* values, Scalar* outputs, size_t count);
+    
+    ///The name of the instruction set
+    const char* name;
+};
+
+/**
+ * Returns 2 to the power of an integer by building the exponent
+ * bits directly. The power must be within the normal range.
+ *
+ * @param power     The power of 2.
+ * @return The result.
+ */
+inline double Power2(double power) {
+    
+    uint64_t bits = static_cast<uint64_t>(static_cast<int64_t>(power) + 1023) << 52;
+    double result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+inline float Power2(float power) {
+    
+    uint32_t bits = static_cast<uint32_t>(static_cast<int32_t>(power) + 127) << 23;
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+/**
+ * Approximates the sigmoid without calling libm. exp(-x) is split to
+ * 2^n * e^r, where |r| <= ln(2) / 2, and e^r is a degree 6 polynomial.
+ * The maximum absolute error from the exact sigmoid is 4e-8 for
+ * doubles and 1e-7 for floats (about the same as libm's expf). The
+ * vectorized 'fast_sigmoid' kernels follow the same steps and stay
+ * within the same bounds.
+ *
+ * @param value     The value to activate.
+ * @return The sigmoid of the value.
+ */
+template <typename Scalar>
+inline Scalar FastSigmoid(Scalar value) {
+    
+    //The sigmoid is flat beyond this range, and 2^n stays normal
+    Scalar exponent = -value;
+    exponent = (exponent > 80) ? 80 : (exponent < -80) ? -80 : exponent;
+    
+    Scalar power = floor(exponent * static_cast<Scalar>(1.44269504088896341) + static_cast<Scalar>(0.5));
+    
+    //Subtracting ln(2) in two parts keeps the remainder accurate
+    Scalar remainder = exponent - power * static_cast<Scalar>(0.693145751953125);
+    remainder = remainder - power * static_cast<Scalar>(1.42860682030941723212e-6);
+    
+    Scalar polynomial = static_cast<Scalar>(1.0 / 720);
+    polynomial = polynomial * remainder + static_cast<Scalar>(1.0 / 120);
+    polynomial = polynomial * remainder + static_cast<Scalar>(1.0 / 24);
+    polynomial = polynomial * remainder + static_cast<Scalar>(1.0 / 6);
+    polynomial = polynomial * remainder + static_cast<Scalar>(0.5);
+    polynomial = polynomial * remainder + 1;
+    polynomial = polynomial * remainder + 1;
+    
+    return 1 / (1 + polynomial * Power2(power));
+}
+
+/**
+ * Returns the kernels that match the host's instruction set.
+ * The choice can be forced with the NEURAL_KERNELS environment
+ * variable (scalar, sse2, avx2 or avx512), which is useful to
+ * compare the results of the vectorized path to the scalar one.
+ *
+ * @return The kernels to use.
+ */
+template <typename Scalar>
+const Kernels<Scalar>& ActiveKernels();
+
+/**
+ * Returns the portable kernels that every host can run.
+ *
+ * @return The scalar kernels.
+ */
+template <typename Scalar>
+const Kernels<Scalar>& ScalarKernels();
+
+#if NEURAL_X86
+
+///Returns the SSE2 kernels
+template <typename Scalar>
+const Kernels<Scalar>& SSE2Kernels();
+
+///Returns the AVX2 + FMA kernels
+template <typename Scalar>
+const Kernels<Scalar>& AVX2Kernels();
+
+///Returns the AVX-512 kernels
+template <typename Scalar>
+const Kernels<Scalar>& AVX512Kernels();
+
+template <> const Kernels<double>& SSE2Kernels<double>();
+template <> const Kernels<float>& SSE2Kernels<float>();
+template <> const Kernels<double>& AVX2Kernels<double>();
+template <> const Kernels<float>& AVX2Kernels<float>();
+template <> const Kernels<double>& AVX512Kernels<double>();
+template <> const Kernels<float>& AVX512Kernels<float>();
+
+#endif
+
+/**
+ * The integer loops of a quantized network. The activations are
+ * unsigned 7 bit values (0 to 127) and the weights are signed 8 bit
+ * values (-127 to 127), so that the sum of two adjacent products
+ * always fits in 16 bits (which 'pmaddubsw' relies on).
+ */
+struct QuantizedKernels {
+    
+    ///Returns the sum of a[i] * b[i]
+    int32_t (*dot)(const uint8_t* a, const int8_t* b, size_t count);
+    
+    ///The name of the instruction set
+    const char* name;
+};
+
+/**
+ * Returns the quantized kernels that match the host's instruction
+ * set. NEURAL_KERNELS is respected the same as in 'ActiveKernels'.
+ *
+ * @return The kernels to use.
+ */
+const QuantizedKernels& ActiveQuantizedKernels();
+
+/**
+ * Returns the portable quantized kernels that every host can run.
+ *
+ * @return The scalar kernels.
+ */
+const QuantizedKernels& ScalarQuantizedKernels();
+
+#if NEURAL_X86
+
+///Returns the AVX2 quantized kernels
+const QuantizedKernels& AVX2QuantizedKernels();
+
+///Returns the AVX-512 VNNI quantized kernels
+const QuantizedKernels& AVX512QuantizedKernels();
+
+#endif
+
+NAMESPACE_NEURAL_END
+#endif /* Kernels_hpp */
@@ -0,0 +1,566 @@
+//
+//  KernelsX86.cpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#include "Kernels.hpp"
+
+#if NEURAL_X86
+#include <immintrin.h>
+
+/*
+ * Every function is compiled for it's own instruction set via the
+ * target attribute, so that the rest of the program can be built
+ * without any -march flag and still run on older hosts.
+ */
+#define NEURAL_SSE2     __attribute__((target("sse2")))
+#define NEURAL_AVX2     __attribute__((target("avx2,fma")))
+#define NEURAL_AVX512   __attribute__((target("avx512f")))
+#define NEURAL_VNNI     __attribute__((target("avx512f,avx512bw,avx512vnni")))
+
+using namespace neural;
+
+#pragma mark - SSE2
+
+NEURAL_SSE2 static double SSE2Dot(const double* a, const double* b, size_t count) {
+    
+    __m128d first = _mm_setzero_pd();
+    __m128d second = _mm_setzero_pd();
+    
+    size_t index = 0;
+    for ( ; index + 4 <= count ; index += 4) {
+        first = _mm_add_pd(first, _mm_mul_pd(_mm_loadu_pd(a + index), _mm_loadu_pd(b + index)));
+        second = _mm_add_pd(second, _mm_mul_pd(_mm_loadu_pd(a + index + 2), _mm_loadu_pd(b + index + 2)));
+    }
+    
+    first = _mm_add_pd(first, second);
+    
+    double lanes[2];
+    _mm_storeu_pd(lanes, first);
+    double sum = lanes[0] + lanes[1];
+    
+    for ( ; index < count ; index++)
+        sum += a[index] * b[index];
+    
+    return sum;
+}
+
+NEURAL_SSE2 static void SSE2Axpy(double alpha, const double* x, double* y, size_t count) {
+    
+    __m128d factor = _mm_set1_pd(alpha);
+    
+    size_t index = 0;
+    for ( ; index + 2 <= count ; index += 2)
+        _mm_storeu_pd(y + index, _mm_add_pd(_mm_loadu_pd(y + index), _mm_mul_pd(factor, _mm_loadu_pd(x + index))));
+    
+    for ( ; index < count ; index++)
+        y[index] += alpha * x[index];
+}
+
+NEURAL_SSE2 static void SSE2SigmoidDelta(const double* outputs, const double* errors, double* deltas, size_t count) {
+    
+    __m128d one = _mm_set1_pd(1.0);
+    
+    size_t index = 0;
+    for ( ; index + 2 <= count ; index += 2) {
+        __m128d output = _mm_loadu_pd(outputs + index);
+        __m128d derivative = _mm_mul_pd(output, _mm_sub_pd(one, output));
+        _mm_storeu_pd(deltas + index, _mm_mul_pd(derivative, _mm_loadu_pd(errors + index)));
+    }
+    
+    for ( ; index < count ; index++)
+        deltas[index] = outputs[index] * (1.0 - outputs[index]) * errors[index];
+}
+
+NEURAL_SSE2 static float SSE2Dot(const float* a, const float* b, size_t count) {
+    
+    __m128 first = _mm_setzero_ps();
+    __m128 second = _mm_setzero_ps();
+    
+    size_t index = 0;
+    for ( ; index + 8 <= count ; index += 8) {
+        first = _mm_add_ps(first, _mm_mul_ps(_mm_loadu_ps(a + index), _mm_loadu_ps(b + index)));
+        second = _mm_add_ps(second, _mm_mul_ps(_mm_loadu_ps(a + index + 4), _mm_loadu_ps(b + index + 4)));
+    }
+    
+    first = _mm_add_ps(first, second);
+    
+    float lanes[4];
+    _mm_storeu_ps(lanes, first);
+    float sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    
+    for ( ; index < count ; index++)
+        sum += a[index] * b[index];
+    
+    return sum;
+}
+
+NEURAL_SSE2 static void SSE2Axpy(float alpha, const float* x, float* y, size_t count) {
+    
+    __m128 factor = _mm_set1_ps(alpha);
+    
+    size_t index = 0;
+    for ( ; index + 4 <= count ; index += 4)
+        _mm_storeu_ps(y + index, _mm_add_ps(_mm_loadu_ps(y + index), _mm_mul_ps(factor, _mm_loadu_ps(x + index))));
+    
+    for ( ; index < count ; index++)
+        y[index] += alpha * x[index];
+}
+
+NEURAL_SSE2 static void SSE2SigmoidDelta(const float* outputs, const float* errors, float* deltas, size_t count) {
+    
+    __m128 one = _mm_set1_ps(1.0f);
+    
+    size_t index = 0;
+    for ( ; index + 4 <= count ; index += 4) {
+        __m128 output = _mm_loadu_ps(outputs + index);
+        __m128 derivative = _mm_mul_ps(output, _mm_sub_ps(one, output));
+        _mm_storeu_ps(deltas + index, _mm_mul_ps(derivative, _mm_loadu_ps(errors + index)));
+    }
+    
+    for ( ; index < count ; index++)
+        deltas[index] = outputs[index] * (1.0f - outputs[index]) * errors[index];
+}
+
+#pragma mark - AVX2
+
+NEURAL_AVX2 static double AVX2Dot(const double* a, const double* b, size_t count) {
+    
+    __m256d first = _mm256_setzero_pd();
+    __m256d second = _mm256_setzero_pd();
+    __m256d third = _mm256_setzero_pd();
+    __m256d fourth = _mm256_setzero_pd();
+    
+    //Four independent accumulators hide the latency of the fused multiply-add
+    size_t index = 0;
+    for ( ; index + 16 <= count ; index += 16) {
+        first = _mm256_fmadd_pd(_mm256_loadu_pd(a + index), _mm256_loadu_pd(b + index), first);
+        second = _mm256_fmadd_pd(_mm256_loadu_pd(a + index + 4), _mm256_loadu_pd(b + index + 4), second);
+        third = _mm256_fmadd_pd(_mm256_loadu_pd(a + index + 8), _mm256_loadu_pd(b + index + 8), third);
+        fourth = _mm256_fmadd_pd(_mm256_loadu_pd(a + index + 12), _mm256_loadu_pd(b + index + 12), fourth);
+    }
+    
+    for ( ; index + 4 <= count ; index += 4)
+        first = _mm256_fmadd_pd(_mm256_loadu_pd(a + index), _mm256_loadu_pd(b + index), first);
+    
+    first = _mm256_add_pd(_mm256_add_pd(first, second), _mm256_add_pd(third, fourth));
+    
+    __m128d half = _mm_add_pd(_mm256_castpd256_pd128(first), _mm256_extractf128_pd(first, 1));
+    double sum = _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+    
+    for ( ; index < count ; index++)
+        sum += a[index] * b[index];
+    
+    return sum;
+}
+
+NEURAL_AVX2 static void AVX2Axpy(double alpha, const double* x, double* y, size_t count) {
+    
+    __m256d factor = _mm256_set1_pd(alpha);
+    
+    size_t index = 0;
+    for ( ; index + 4 <= count ; index += 4)
+        _mm256_storeu_pd(y + index, _mm256_fmadd_pd(factor, _mm256_loadu_pd(x + index), _mm256_loadu_pd(y + index)));
+    
+    for ( ; index < count ; index++)
+        y[index] += alpha * x[index];
+}
+
+NEURAL_AVX2 static void AVX2SigmoidDelta(const double* outputs, const double* errors, double* deltas, size_t count) {
+    
+    __m256d one = _mm256_set1_pd(1.0);
+    
+    size_t index = 0;
+    for ( ; index + 4 <= count ; index += 4) {
+        __m256d output = _mm256_loadu_pd(outputs + index);
+        __m256d derivative = _mm256_mul_pd(output, _mm256_sub_pd(one, output));
+        _mm256_storeu_pd(deltas + index, _mm256_mul_pd(derivative, _mm256_loadu_pd(errors + index)));
+    }
+    
+    for ( ; index < count ; index++)
+        deltas[index] = outputs[index] * (1.0 - outputs[index]) * errors[index];
+}
+
+NEURAL_AVX2 static float AVX2Dot(const float* a, const float* b, size_t count) {
+    
+    __m256 first = _mm256_setzero_ps();
+    __m256 second = _mm256_setzero_ps();
+    __m256 third = _mm256_setzero_ps();
+    __m256 fourth = _mm256_setzero_ps();
+    
+    size_t index = 0;
+    for ( ; index + 32 <= count ; index += 32) {
+        first = _mm256_fmadd_ps(_mm256_loadu_ps(a + index), _mm256_loadu_ps(b + index), first);
+        second = _mm256_fmadd_ps(_mm256_loadu_ps(a + index + 8), _mm256_loadu_ps(b + index + 8), second);
+        third = _mm256_fmadd_ps(_mm256_loadu_ps(a + index + 16), _mm256_loadu_ps(b + index + 16), third);
+        fourth = _mm256_fmadd_ps(_mm256_loadu_ps(a + index + 24), _mm256_loadu_ps(b + index + 24), fourth);
+    }
+    
+    for ( ; index + 8 <= count ; index += 8)
+        first = _mm256_fmadd_ps(_mm256_loadu_ps(a + index), _mm256_loadu_ps(b + index), first);
+    
+    first = _mm256_add_ps(_mm256_add_ps(first, second), _mm256_add_ps(third, fourth));
+    
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(first), _mm256_extractf128_ps(first, 1));
+    half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+    float sum = _mm_cvtss_f32(_mm_add_ss(half, _mm_movehdup_ps(half)));
+    
+    for ( ; index < count ; index++)
+        sum += a[index] * b[index];
+    
+    return sum;
+}
+
+NEURAL_AVX2 static void AVX2Axpy(float alpha, const float* x, float* y, size_t count) {
+    
+    __m256 factor = _mm256_set1_ps(alpha);
+    
+    size_t index = 0;
+    for ( ; index + 8 <= count ; index += 8)
+        _mm256_storeu_ps(y + index, _mm256_fmadd_ps(factor, _mm256_loadu_ps(x + index), _mm256_loadu_ps(y + index)));
+    
+    for ( ; index < count ; index++)
+        y[index] += alpha * x[index];
+}
+
+NEURAL_AVX2 static void AVX2SigmoidDelta(const float* outputs, const float* errors, float* deltas, size_t count) {
+    
+    __m256 one = _mm256_set1_ps(1.0f);
+    
+    size_t index = 0;
+    for ( ; index + 8 <= count ; index += 8) {
+        __m256 output = _mm256_loadu_ps(outputs + index);
+        __m256 derivative = _mm256_mul_ps(output, _mm256_sub_ps(one, output));
+        _mm256_storeu_ps(deltas + index, _mm256_mul_ps(derivative, _mm256_loadu_ps(errors + index)));
+    }
+    
+    for ( ; index < count ; index++)
+        deltas[index] = outputs[index] * (1.0f - outputs[index]) * errors[index];
+}
+
+#pragma mark - AVX-512
+
+NEURAL_AVX512 static double AVX512Dot(const double* a, const double* b, size_t count) {
+    
+    __m512d first = _mm512_setzero_pd();
+    __m512d second = _mm512_setzero_pd();
+    
+    size_t index = 0;
+    for ( ; index + 16 <= count ; index += 16) {
+        first = _mm512_fmadd_pd(_mm512_loadu_pd(a + index), _mm512_loadu_pd(b + index), first);
+        second = _mm512_fmadd_pd(_mm512_loadu_pd(a + index + 8), _mm512_loadu_pd(b + index + 8), second);
+    }
+    
+    //The remainder is handled with a masked load instead of a scalar loop
+    for ( ; index < count ; index += 8) {
+        __mmask8 mask = (count - index >= 8) ? 0xFF : static_cast<__mmask8>((1u << (count - index)) - 1);
+        first = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, a + index), _mm512_maskz_loadu_pd(mask, b + index), first);
+    }
+    
+    return _mm512_reduce_add_pd(_mm512_add_pd(first, second));
+}
+
+NEURAL_AVX512 static void AVX512Axpy(double alpha, const double* x, double* y, size_t count) {
+    
+    __m512d factor = _mm512_set1_pd(alpha);
+    
+    for (size_t index = 0 ; index < count ; index += 8) {
+        __mmask8 mask = (count - index >= 8) ? 0xFF : static_cast<__mmask8>((1u << (count - index)) - 1);
+        __m512d result = _mm512_fmadd_pd(factor, _mm512_maskz_loadu_pd(mask, x + index), _mm512_maskz_loadu_pd(mask, y + index));
+        _mm512_mask_storeu_pd(y + index, mask, result);
+    }
+}
+
+NEURAL_AVX512 static void AVX512SigmoidDelta(const double* outputs, const double* errors, double* deltas, size_t count) {
+    
+    __m512d one = _mm512_set1_pd(1.0);
+    
+    for (size_t index = 0 ; index < count ; index += 8) {
+        __mmask8 mask = (count - index >= 8) ? 0xFF : static_cast<__mmask8>((1u << (count - index)) - 1);
+        __m512d output = _mm512_maskz_loadu_pd(mask, outputs + index);
+        __m512d derivative = _mm512_mul_pd(output, _mm512_sub_pd(one, output));
+        _mm512_mask_storeu_pd(deltas + index, mask, _mm512_mul_pd(derivative, _mm512_maskz_loadu_pd(mask, errors + index)));
+    }
+}
+
+NEURAL_AVX512 static float AVX512Dot(const float* a, const float* b, size_t count) {
+    
+    __m512 first = _mm512_setzero_ps();
+    __m512 second = _mm512_setzero_ps();
+    
+    size_t index = 0;
+    for ( ; index + 32 <= count ; index += 32) {
+        first = _mm512_fmadd_ps(_mm512_loadu_ps(a + index), _mm512_loadu_ps(b + index), first);
+        second = _mm512_fmadd_ps(_mm512_loadu_ps(a + index + 16), _mm512_loadu_ps(b + index + 16), second);
+    }
+    
+    for ( ; index < count ; index += 16) {
+        __mmask16 mask = (count - index >= 16) ? 0xFFFF : static_cast<__mmask16>((1u << (count - index)) - 1);
+        first = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a + index), _mm512_maskz_loadu_ps(mask, b + index), first);
+    }
+    
+    return _mm512_reduce_add_ps(_mm512_add_ps(first, second));
+}
+
+NEURAL_AVX512 static void AVX512Axpy(float alpha, const float* x, float* y, size_t count) {
+    
+    __m512 factor = _mm512_set1_ps(alpha);
+    
+    for (size_t index = 0 ; index < count ; index += 16) {
+        __mmask16 mask = (count - index >= 16) ? 0xFFFF : static_cast<__mmask16>((1u << (count - index)) - 1);
+        __m512 result = _mm512_fmadd_ps(factor, _mm512_maskz_loadu_ps(mask, x + index), _mm512_maskz_loadu_ps(mask, y + index));
+        _mm512_mask_storeu_ps(y + index, mask, result);
+    }
+}
+
+NEURAL_AVX512 static void AVX512SigmoidDelta(const float* outputs, const float* errors, float* deltas, size_t count) {
+    
+    __m512 one = _mm512_set1_ps(1.0f);
+    
+    for (size_t index = 0 ; index < count ; index += 16) {
+        __mmask16 mask = (count - index >= 16) ? 0xFFFF : static_cast<__mmask16>((1u << (count - index)) - 1);
+        __m512 output = _mm512_maskz_loadu_ps(mask, outputs + index);
+        __m512 derivative = _mm512_mul_ps(output, _mm512_sub_ps(one, output));
+        _mm512_mask_storeu_ps(deltas + index, mask, _mm512_mul_ps(derivative, _mm512_maskz_loadu_ps(mask, errors + index)));
+    }
+}
+
+#pragma mark - Fast sigmoid
+
+template <typename Scalar>
+NEURAL_SSE2 static void SSE2FastSigmoid(const Scalar* values, Scalar* outputs, size_t count) {
+    
+    //SSE2 can not round or convert doubles well, so the scalar steps are used
+    for (size_t index = 0 ; index < count ; index++)
+        outputs[index] = FastSigmoid(values[index]);
+}
+
+NEURAL_AVX2 static void AVX2FastSigmoid(const double* values, double* outputs, size_t count) {
+    
+    const __m256d limit = _mm256_set1_pd(80.0);
+    const __m256d one = _mm256_set1_pd(1.0);
+    
+    size_t index = 0;
+    for ( ; index + 4 <= count ; index += 4) {
+        
+        __m256d exponent = _mm256_sub_pd(_mm256_setzero_pd(), _mm256_loadu_pd(values + index));
+        exponent = _mm256_min_pd(_mm256_max_pd(exponent, _mm256_sub_pd(_mm256_setzero_pd(), limit)), limit);
+        
+        __m256d power = _mm256_floor_pd(_mm256_fmadd_pd(exponent, _mm256_set1_pd(1.44269504088896341), _mm256_set1_pd(0.5)));
+        __m256d remainder = _mm256_fnmadd_pd(power, _mm256_set1_pd(0.693145751953125), exponent);
+        remainder = _mm256_fnmadd_pd(power, _mm256_set1_pd(1.42860682030941723212e-6), remainder);
+        
+        __m256d polynomial = _mm256_set1_pd(1.0 / 720);
+        polynomial = _mm256_fmadd_pd(polynomial, remainder, _mm256_set1_pd(1.0 / 120));
+        polynomial = _mm256_fmadd_pd(polynomial, remainder, _mm256_set1_pd(1.0 / 24));
+        polynomial = _mm256_fmadd_pd(polynomial, remainder, _mm256_set1_pd(1.0 / 6));
+        polynomial = _mm256_fmadd_pd(polynomial, remainder, _mm256_set1_pd(0.5));
+        polynomial = _mm256_fmadd_pd(polynomial, remainder, one);
+        polynomial = _mm256_fmadd_pd(polynomial, remainder, one);
+        
+        //2^n is built directly in the exponent bits
+        __m256i bits = _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(power));
+        bits = _mm256_slli_epi64(_mm256_add_epi64(bits, _mm256_set1_epi64x(1023)), 52);
+        __m256d scale = _mm256_castsi256_pd(bits);
+        
+        _mm256_storeu_pd(outputs + index, _mm256_div_pd(one, _mm256_fmadd_pd(polynomial, scale, one)));
+    }
+    
+    for ( ; index < count ; index++)
+        outputs[index] = FastSigmoid(values[index]);
+}
+
+NEURAL_AVX2 static void AVX2FastSigmoid(const float* values, float* outputs, size_t count) {
+    
+    const __m256 limit = _mm256_set1_ps(80.0f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    
+    size_t index = 0;
+    for ( ; index + 8 <= count ; index += 8) {
+        
+        __m256 exponent = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(values + index));
+        exponent = _mm256_min_ps(_mm256_max_ps(exponent, _mm256_sub_ps(_mm256_setzero_ps(), limit)), limit);
+        
+        __m256 power = _mm256_floor_ps(_mm256_fmadd_ps(exponent, _mm256_set1_ps(1.44269504088896341f), _mm256_set1_ps(0.5f)));
+        __m256 remainder = _mm256_fnmadd_ps(power, _mm256_set1_ps(0.693145751953125f), exponent);
+        remainder = _mm256_fnmadd_ps(power, _mm256_set1_ps(1.42860682030941723212e-6f), remainder);
+        
+        __m256 polynomial = _mm256_set1_ps(1.0f / 720);
+        polynomial = _mm256_fmadd_ps(polynomial, remainder, _mm256_set1_ps(1.0f / 120));
+        polynomial = _mm256_fmadd_ps(polynomial, remainder, _mm256_set1_ps(1.0f / 24));
+        polynomial = _mm256_fmadd_ps(polynomial, remainder, _mm256_set1_ps(1.0f / 6));
+        polynomial = _mm256_fmadd_ps(polynomial, remainder, _mm256_set1_ps(0.5f));
+        polynomial = _mm256_fmadd_ps(polynomial, remainder, one);
+        polynomial = _mm256_fmadd_ps(polynomial, remainder, one);
+        
+        //2^n is built directly in the exponent bits
+        __m256i bits = _mm256_cvtps_epi32(power);
+        bits = _mm256_slli_epi32(_mm256_add_epi32(bits, _mm256_set1_epi32(127)), 23);
+        __m256 scale = _mm256_castsi256_ps(bits);
+        
+        _mm256_storeu_ps(outputs + index, _mm256_div_ps(one, _mm256_fmadd_ps(polynomial, scale, one)));
+    }
+    
+    for ( ; index < count ; index++)
+        outputs[index] = FastSigmoid(values[index]);
+}
+
+NEURAL_AVX512 static void AVX512FastSigmoid(const double* values, double* outputs, size_t count) {
+    
+    const __m512d limit = _mm512_set1_pd(80.0);
+    const __m512d one = _mm512_set1_pd(1.0);
+    
+    for (size_t index = 0 ; index < count ; index += 8) {
+        
+        __mmask8 mask = (count - index >= 8) ? 0xFF : static_cast<__mmask8>((1u << (count - index)) - 1);
+        
+        __m512d exponent = _mm512_sub_pd(_mm512_setzero_pd(), _mm512_maskz_loadu_pd(mask, values + index));
+        exponent = _mm512_min_pd(_mm512_max_pd(exponent, _mm512_sub_pd(_mm512_setzero_pd(), limit)), limit);
+        
+        __m512d power = _mm512_roundscale_pd(_mm512_fmadd_pd(exponent, _mm512_set1_pd(1.44269504088896341), _mm512_set1_pd(0.5)), _MM_FROUND_TO_NEG_INF);
+        __m512d remainder = _mm512_fnmadd_pd(power, _mm512_set1_pd(0.693145751953125), exponent);
+        remainder = _mm512_fnmadd_pd(power, _mm512_set1_pd(1.42860682030941723212e-6), remainder);
+        
+        __m512d polynomial = _mm512_set1_pd(1.0 / 720);
+        polynomial = _mm512_fmadd_pd(polynomial, remainder, _mm512_set1_pd(1.0 / 120));
+        polynomial = _mm512_fmadd_pd(polynomial, remainder, _mm512_set1_pd(1.0 / 24));
+        polynomial = _mm512_fmadd_pd(polynomial, remainder, _mm512_set1_pd(1.0 / 6));
+        polynomial = _mm512_fmadd_pd(polynomial, remainder, _mm512_set1_pd(0.5));
+        polynomial = _mm512_fmadd_pd(polynomial, remainder, one);
+        polynomial = _mm512_fmadd_pd(polynomial, remainder, one);
+        
+        //Multiplies by 2^n without building the bits
+        __m512d denominator = _mm512_add_pd(_mm512_scalef_pd(polynomial, power), one);
+        _mm512_mask_storeu_pd(outputs + index, mask, _mm512_div_pd(one, denominator));
+    }
+}
+
+NEURAL_AVX512 static void AVX512FastSigmoid(const float* values, float* outputs, size_t count) {
+    
+    const __m512 limit = _mm512_set1_ps(80.0f);
+    const __m512 one = _mm512_set1_ps(1.0f);
+    
+    for (size_t index = 0 ; index < count ; index += 16) {
+        
+        __mmask16 mask = (count - index >= 16) ? 0xFFFF : static_cast<__mmask16>((1u << (count - index)) - 1);
+        
+        __m512 exponent = _mm512_sub_ps(_mm512_setzero_ps(), _mm512_maskz_loadu_ps(mask, values + index));
+        exponent = _mm512_min_ps(_mm512_max_ps(exponent, _mm512_sub_ps(_mm512_setzero_ps(), limit)), limit);
+        
+        __m512 power = _mm512_roundscale_ps(_mm512_fmadd_ps(exponent, _mm512_set1_ps(1.44269504088896341f), _mm512_set1_ps(0.5f)), _MM_FROUND_TO_NEG_INF);
+        __m512 remainder = _mm512_fnmadd_ps(power, _mm512_set1_ps(0.693145751953125f), exponent);
+        remainder = _mm512_fnmadd_ps(power, _mm512_set1_ps(1.42860682030941723212e-6f), remainder);
+        
+        __m512 polynomial = _mm512_set1_ps(1.0f / 720);
+        polynomial = _mm512_fmadd_ps(polynomial, remainder, _mm512_set1_ps(1.0f / 120));
+        polynomial = _mm512_fmadd_ps(polynomial, remainder, _mm512_set1_ps(1.0f / 24));
+        polynomial = _mm512_fmadd_ps(polynomial, remainder, _mm512_set1_ps(1.0f / 6));
+        polynomial = _mm512_fmadd_ps(polynomial, remainder, _mm512_set1_ps(0.5f));
+        polynomial = _mm512_fmadd_ps(polynomial, remainder, one);
+        polynomial = _mm512_fmadd_ps(polynomial, remainder, one);
+        
+        //Multiplies by 2^n without building the bits
+        __m512 denominator = _mm512_add_ps(_mm512_scalef_ps(polynomial, power), one);
+        _mm512_mask_storeu_ps(outputs + index, mask, _mm512_div_ps(one, denominator));
+    }
+}
+
+#pragma mark - Quantized
+
+NEURAL_AVX2 static int32_t AVX2QuantizedDot(const uint8_t* a, const int8_t* b, size_t count) {
+    
+    __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+    
+    //Multiplies 32 pairs of bytes into 16 sums of pairs, which are widened to 8 sums of four
+    size_t index = 0;
+    for ( ; index + 32 <= count ; index += 32) {
+        __m256i products = _mm256_maddubs_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + index)),
+                                                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + index)));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+    }
+    
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    int32_t total = _mm_cvtsi128_si32(half);
+    
+    for ( ; index < count ; index++)
+        total += a[index] * b[index];
+    
+    return total;
+}
+
+NEURAL_VNNI static int32_t AVX512QuantizedDot(const uint8_t* a, const int8_t* b, size_t count) {
+    
+    __m512i sum = _mm512_setzero_si512();
+    
+    //A single instruction multiplies 64 pairs of bytes and adds them by fours into the sums
+    for (size_t index = 0 ; index < count ; index += 64) {
+        __mmask64 mask = (count - index >= 64) ? ~0ULL : (1ULL << (count - index)) - 1;
+        sum = _mm512_dpbusd_epi32(sum, _mm512_maskz_loadu_epi8(mask, a + index), _mm512_maskz_loadu_epi8(mask, b + index));
+    }
+    
+    return _mm512_reduce_add_epi32(sum);
+}
+
+#pragma mark - Kernel tables
+
+template <>
+const Kernels<double>& neural::SSE2Kernels<double>() {
+    
+    static const Kernels<double> kernels = { SSE2Dot, SSE2Axpy, SSE2SigmoidDelta, SSE2FastSigmoid<double>, "sse2" };
+    return kernels;
+}
+
+template <>
+const Kernels<float>& neural::SSE2Kernels<float>() {
+    
+    static const Kernels<float> kernels = { SSE2Dot, SSE2Axpy, SSE2SigmoidDelta, SSE2FastSigmoid<float>, "sse2" };
+    return kernels;
+}
+
+template <>
+const Kernels<double>& neural::AVX2Kernels<double>() {
+    
+    static const Kernels<double> kernels = { AVX2Dot, AVX2Axpy, AVX2SigmoidDelta, AVX2FastSigmoid, "avx2" };
+    return kernels;
+}
+
+template <>
+const Kernels<float>& neural::AVX2Kernels<float>() {
+    
+    static const Kernels<float> kernels = { AVX2Dot, AVX2Axpy, AVX2SigmoidDelta, AVX2FastSigmoid, "avx2" };
+    return kernels;
+}
+
+template <>
+const Kernels<double>& neural::AVX512Kernels<double>() {
+    
+    static const Kernels<double> kernels = { AVX512Dot, AVX512Axpy, AVX512SigmoidDelta, AVX512FastSigmoid, "avx512" };
+    return kernels;
+}
+
+template <>
+const Kernels<float>& neural::AVX512Kernels<float>() {
+    
+    static const Kernels<float> kernels = { AVX512Dot, AVX512Axpy, AVX512SigmoidDelta, AVX512FastSigmoid, "avx512" };
+    return kernels;
+}
+
+const QuantizedKernels& neural::AVX2QuantizedKernels() {
+    
+    static const QuantizedKernels kernels = { AVX2QuantizedDot, "avx2" };
+    return kernels;
+}
+
+const QuantizedKernels& neural::AVX512QuantizedKernels() {
+    
+    static const QuantizedKernels kernels = { AVX512QuantizedDot, "avx512vnni" };
+    return kernels;
+}
+
+#endif
@@ -0,0 +1,591 @@
+//
+//  Layer.cpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#include "Layer.hpp"
+#include "RandomGenerator.hpp"
+#include "Kernels.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <charconv>
+#include <atomic>
+#include <math.h>
+
+using namespace neural;
+
+/**
+ * Multiplies a row-major matrix by a vector and adds the bias.
+ *
+ * @param matrix    The matrix, with 'rows' rows that are 'stride' apart.
+ * @param rows      Number of rows in the matrix.
+ * @param columns   Number of columns (valid values in every row).
+ * @param stride    The distance between the beginning of two rows.
+ * @param input     The vector, must have 'columns' values.
+ * @param bias      The bias per row.
+ * @param output    Receives a value per row.
+ */
+template <typename Scalar>
+static void MatrixVector(const Scalar* matrix,
+                         size_t rows,
+                         size_t columns,
+                         size_t stride,
+                         const Scalar* input,
+                         const Scalar* bias,
+                         Scalar* output) {
+    
+    const Kernels<Scalar>& kernels = ActiveKernels<Scalar>();
+        
+    for (size_t row = 0 ; row < rows ; row++)
+        output[row] = kernels.dot(matrix + row * stride, input, columns) + bias[row];
+}
+
+/**
+ * Returns the number of rows of a matrix that fit together in the
+ * cache, so that a block of rows can be reused by a whole batch.
+ *
+ * @param stride    The distance between the beginning of two rows.
+ * @return The number of rows in a block.
+ */
+template <typename Scalar>
+static size_t RowsPerBlock(size_t stride) {
+    
+    //Aim for half of a typical L2 cache
+    const size_t block_bytes = 128 * 1024;
+    size_t rows = block_bytes / (stride * sizeof(Scalar) + 1);
+    
+    return (rows) ? rows : 1;
+}
+
+///The number of multiplications below which a layer is not split between threads
+static const size_t kParallelWork = 1 << 15;
+
+#pragma mark - Layer functions
+
+/**
+ * Returns the range of the starting weights of a layer. The sigmoid
+ * keeps the original range, while the others are scaled by the number
+ * of inputs so that their outputs do not grow from layer to layer.
+ *
+ * @param activation    The activation function of the layer.
+ * @param perceptrons   Number of perceptrons in the layer.
+ * @param connections   Number of inputs that every perceptron has.
+ * @return The limit of the weights on either side of zero.
+ */
+static double WeightsLimit(ActivationType activation, size_t perceptrons, size_t connections) {
+    
+    switch (activation) {
+        case ActivationType::kSigmoid:      return 1.0;
+        case ActivationType::kReLU:
+        case ActivationType::kLeakyReLU:    return sqrt(6.0 / std::max<size_t>(connections, 1));
+        case ActivationType::kTanh:         return sqrt(6.0 / std::max<size_t>(connections + perceptrons, 1));
+    }
+    
+    return 1.0;
+}
+
+template <typename Scalar>
+Layer<Scalar>::Layer(size_t perceptrons, size_t connections, Scalar learning_constant, Scalar bias, ActivationType activation) :
+m_size(perceptrons),
+m_connections(connections),
+m_stride(AlignedStride<Scalar>(connections)),
+m_input_major(false),
+m_pool(NULL),
+m_activation(activation),
+m_fast_activation(false),
+m_weights(perceptrons * m_stride, 0.0),
+m_biases(perceptrons, bias),
+m_learning_constant(learning_constant) {
+    
+    double limit = WeightsLimit(activation, perceptrons, connections);
+    RandomGenerator generator(-limit, limit);
+    
+    //Fill the weights with random numbers in the range, the padding stays zero
+    for (size_t row = 0 ; row < m_size ; row++)
+        for (size_t column = 0 ; column < m_connections ; column++)
+            m_weights[row * m_stride + column] = generator.Random();
+}
+
+template <typename Scalar>
+bool Layer<Scalar>::Deserialize(const char*& serialized, const char* end, Layer& layer, ThreadPool* pool) {
+    
+    const char* line_end = std::find(serialized, end, '\n');
+    
+    //The activation follows the size, layers from before it was saved are sigmoid
+    const char* separator = std::find(serialized, line_end, ' ');
+    ActivationType activation = ActivationType::kSigmoid;
+    
+    size_t size = 0;
+    std::from_chars_result result = std::from_chars(serialized, separator, size);
+    
+    if (result.ec != std::errc() || result.ptr != separator)
+        return false;
+    
+    if (separator != line_end && !ActivationFromName(std::string(separator + 1, line_end), activation))
+        return false;
+    
+    //Every perceptron takes a line of it's own, so a size beyond the bytes left is not allocated
+    if (size == 0 || size > static_cast<size_t>(end - line_end))
+        return false;
+    
+    //Only the beginnings of the lines are found, the perceptrons are parsed where they are
+    std::vector<const char*> perceptrons(size);
+    
+    for (size_t index = 0 ; index < size ; index++) {
+        
+        if (line_end == end)
+            return false;
+        
+        serialized = line_end + 1;
+        perceptrons[index] = serialized;
+        line_end = std::find(serialized, end, '\n');
+    }
+    
+    serialized = (line_end != end) ? line_end + 1 : end;
+    
+    //Every weight takes at least a byte, which bounds the rows before they are allocated
+    size_t connections = 0;
+    
+    if (!Perceptron<Scalar>::WeightsCount(perceptrons.front(), end, connections) ||
+        connections == 0 || connections > static_cast<size_t>(end - perceptrons.front()) / size)
+        return false;
+    
+    size_t stride = AlignedStride<Scalar>(connections);
+    AlignedBuffer<Scalar> weights(size * stride, 0.0);
+    AlignedBuffer<Scalar> biases(size, 0.0);
+    Scalar learning_constant = 0.0;
+    std::atomic<bool> valid(true);
+    
+    //Every perceptron loads directly into it's row, so the rows can be split between threads
+    auto load = [&](size_t begin, size_t last) {
+        
+        Scalar other_learning_constant;
+        
+        //The perceptrons share the learning constant, the last one's is kept
+        for (size_t index = begin ; index < last ; index++) {
+            
+            const char* perceptron_end = Perceptron<Scalar>(weights.data() + index * stride,
+                                                            connections,
+                                                            biases[index],
+                                                            (index + 1 == size) ? learning_constant : other_learning_constant).Deserialize(perceptrons[index], end);
+            
+            //The weights have to fill the line, and every line has to have as many
+            if (!perceptron_end || (perceptron_end != end && *perceptron_end != '\n'))
+                valid = false;
+        }
+    };
+    
+    if (pool && pool->Threads() > 1)    pool->Run(size, 1, load);
+    else                                load(0, size);
+    
+    if (!valid)
+        return false;
+    
+    layer = Layer<Scalar>(size, connections, false, activation, learning_constant, std::move(weights), std::move(biases));
+    
+    return true;
+}
+
+template <typename Scalar>
+Layer<Scalar>::Layer(size_t perceptrons, size_t connections, bool input_major, ActivationType activation, Scalar learning_constant, AlignedBuffer<Scalar> weights, AlignedBuffer<Scalar> biases) :
+m_size(perceptrons),
+m_connections(connections),
+m_stride(AlignedStride<Scalar>((input_major) ? perceptrons : connections)),
+m_input_major(input_major),
+m_pool(NULL),
+m_activation(activation),
+m_fast_activation(false),
+m_weights(std::move(weights)),
+m_biases(std::move(biases)),
+m_learning_constant(learning_constant)
+{ }
+
+template <typename Scalar>
+void Layer<Scalar>::Feed(const Scalar* input, Scalar* output) const {
+    
+    Parallel(m_size, m_size * m_connections, [this, input, output](size_t begin, size_t end) {
+        
+        if (m_input_major) {
+        
+            const Kernels<Scalar>& kernels = ActiveKernels<Scalar>();
+            std::copy(m_biases.begin() + begin, m_biases.begin() + end, output + begin);
+    
+            //Only the rows of the inputs that are not zero contribute, every thread adds it's own columns
+            for (size_t connection = 0 ; connection < m_connections ; connection++)
+                if (input[connection] != 0.0)
+                    kernels.axpy(input[connection], m_weights.data() + connection * m_stride + begin, output + begin, end - begin);
+        }
+        else
+            MatrixVector(m_weights.data() + begin * m_stride, end - begin, m_connections, m_stride, input, m_biases.data() + begin, output + begin);
+        
+        Activate(output + begin, end - begin);
+    });
+}
+
+template <typename Scalar>
+void Layer<Scalar>::FeedSparse(const uint32_t* active, size_t count, Scalar* output) const {
+    
+    Parallel(m_size, m_size * count, [this, active, count, output](size_t begin, size_t end) {
+    
+        std::copy(m_biases.begin() + begin, m_biases.begin() + end, output + begin);
+        
+        if (m_input_major) {
+        
+            const Kernels<Scalar>& kernels = ActiveKernels<Scalar>();
+        
+            //The sum of the rows (the weights) of the set inputs
+            for (size_t index = 0 ; index < count ; index++)
+                kernels.axpy(1.0, m_weights.data() + active[index] * m_stride + begin, output + begin, end - begin);
+        }
+        else {
+            
+            for (size_t row = begin ; row < end ; row++) {
+            
+                const Scalar* weights = m_weights.data() + row * m_stride;
+                
+                for (size_t index = 0 ; index < count ; index++)
+                    output[row] += weights[active[index]];
+            }
+        }
+    
+        Activate(output + begin, end - begin);
+    });
+}
+
+template <typename Scalar>
+void Layer<Scalar>::Train(const Scalar* deltas, const Scalar* omicron) {
+    
+    Parallel(m_size, m_size * m_connections, [this, deltas, omicron](size_t begin, size_t end) {
+        
+        if (m_input_major) {
+        
+            const Kernels<Scalar>& kernels = ActiveKernels<Scalar>();
+        
+            for (size_t connection = 0 ; connection < m_connections ; connection++)
+                if (omicron[connection] != 0.0)
+                    kernels.axpy(-m_learning_constant * omicron[connection], deltas + begin, m_weights.data() + connection * m_stride + begin, end - begin);
+        
+            kernels.axpy(-m_learning_constant, deltas + begin, m_biases.data() + begin, end - begin);
+        }
+        else {
+            
+            for (size_t index = begin ; index < end ; index++)
+                At(index).Train(deltas[index], omicron);
+        }
+    });
+}
+
+template <typename Scalar>
+void Layer<Scalar>::TrainSparse(const Scalar* deltas, const uint32_t* active, size_t count) {
+    
+    Parallel(m_size, m_size * count, [this, deltas, active, count](size_t begin, size_t end) {
+    
+        const Kernels<Scalar>& kernels = ActiveKernels<Scalar>();
+        
+        if (m_input_major) {
+        
+            //Only the rows of the set inputs change
+            for (size_t index = 0 ; index < count ; index++)
+                kernels.axpy(-m_learning_constant, deltas + begin, m_weights.data() + active[index] * m_stride + begin, end - begin);
+        }
+        else {
+            
+            for (size_t row = begin ; row < end ; row++) {
+            
+                Scalar* weights = m_weights.data() + row * m_stride;
+                
+                for (size_t index = 0 ; index < count ; index++)
+                    weights[active[index]] += -m_learning_constant * deltas[row];
+            }
+        }
+    
+        kernels.axpy(-m_learning_constant, deltas + begin, m_biases.data() + begin, end - begin);
+    });
+}
+
+template <typename Scalar>
+void Layer<Scalar>::FeedBatch(const Scalar* inputs, size_t count, Scalar* outputs) const {
+    
+    if (m_input_major) {
+        
+        for (size_t record = 0 ; record < count ; record++)
+            Feed(inputs + record * m_connections, outputs + record * m_size);
+        
+        return;
+    }
+    
+    Parallel(m_size, count * m_size * m_connections, [this, inputs, count, outputs](size_t begin, size_t end) {
+    
+        const Kernels<Scalar>& kernels = ActiveKernels<Scalar>();
+        const size_t block = RowsPerBlock<Scalar>(m_stride);
+        
+        //Every block of weights stays in the cache while the whole batch passes through it
+        for (size_t first_row = begin ; first_row < end ; first_row += block) {
+        
+            size_t last_row = std::min(first_row + block, end);
+            
+            for (size_t record = 0 ; record < count ; record++) {
+            
+                const Scalar* input = inputs + record * m_connections;
+                Scalar* output = outputs + record * m_size;
+                
+                for (size_t row = first_row ; row < last_row ; row++)
+                    output[row] = kernels.dot(m_weights.data() + row * m_stride, input, m_connections) + m_biases[row];
+            }
+        }
+    
+        for (size_t record = 0 ; record < count ; record++)
+            Activate(outputs + record * m_size + begin, end - begin);
+    });
+}
+
+template <typename Scalar>
+void Layer<Scalar>::BackPropogate(const Scalar* deltas, Scalar* errors) const {
+    
+    //Every thread owns a range of the errors
+    Parallel(m_connections, m_size * m_connections, [this, deltas, errors](size_t begin, size_t end) {
+    
+        const Kernels<Scalar>& kernels = ActiveKernels<Scalar>();
+        
+        if (m_input_major) {
+        
+            //A row per input, so every error is a contiguous dot product
+            for (size_t connection = begin ; connection < end ; connection++)
+                errors[connection] = kernels.dot(deltas, m_weights.data() + connection * m_stride, m_size);
+    
+            return;
+        }
+    
+        //Enough columns for the block of errors to stay in the L1 cache
+        const size_t block = 1024;
+    
+        std::fill(errors + begin, errors + end, 0.0);
+        
+        /*
+         * Instead of walking down a column for every error, every row is added
+         * to the errors weighted by it's delta. The errors are split to blocks of
+         * columns so that they stay in the cache while all the rows pass by.
+         */
+        for (size_t first_column = begin ; first_column < end ; first_column += block) {
+        
+            size_t columns = std::min(block, end - first_column);
+            
+            for (size_t row = 0 ; row < m_size ; row++)
+                if (deltas[row] != 0.0)
+                    kernels.axpy(deltas[row], m_weights.data() + row * m_stride + first_column, errors + first_column, columns);
+        }
+    });
+}
+
+template <typename Scalar>
+void Layer<Scalar>::BackPropogateBatch(const Scalar* deltas, size_t count, Scalar* errors) const {
+    
+    //Every thread owns a range of the errors of every record
+    Parallel(m_connections, count * m_size * m_connections, [this, deltas, count, errors](size_t begin, size_t end) {
+    
+        const Kernels<Scalar>& kernels = ActiveKernels<Scalar>();
+        const size_t block = RowsPerBlock<Scalar>(m_stride);
+        
+        if (m_input_major) {
+            
+            //Every error is the dot product of the deltas with the row of an input
+            for (size_t record = 0 ; record < count ; record++)
+                for (size_t connection = begin ; connection < end ; connection++)
+                    errors[record * m_connections + connection] = kernels.dot(deltas + record * m_size,
+                                                                               m_weights.data() + connection * m_stride,
+                                                                               m_size);
+            
+            return;
+        }
+        
+        for (size_t record = 0 ; record < count ; record++)
+            std::fill(errors + record * m_connections + begin, errors + record * m_connections + end, 0.0);
+        
+        //The error of a record is the sum of the rows weighted by the record's deltas
+        for (size_t first_row = 0 ; first_row < m_size ; first_row += block) {
+    
+            size_t last_row = std::min(first_row + block, m_size);
+    
+            for (size_t record = 0 ; record < count ; record++) {
+        
+                const Scalar* delta = deltas + record * m_size;
+                Scalar* error = errors + record * m_connections;
+        
+                for (size_t row = first_row ; row < last_row ; row++)
+                    kernels.axpy(delta[row], m_weights.data() + row * m_stride + begin, error + begin, end - begin);
+            }
+        }
+    });
+}
+
+template <typename Scalar>
+void Layer<Scalar>::Gradient(const Scalar* deltas, const Scalar* omicrons, size_t count, Scalar* weights, Scalar* biases, bool accumulate) const {
+    
+    const Kernels<Scalar>& kernels = ActiveKernels<Scalar>();
+    
+    //The padding is summed as well, so that it stays zero once it is applied
+    if (!accumulate) {
+        
+        std::fill(weights, weights + m_weights.size(), 0.0);
+        std::fill(biases, biases + m_size, 0.0);
+    }
+    
+    if (m_input_major) {
+        
+        //Inputs that are zero leave their row at zero
+        for (size_t connection = 0 ; connection < m_connections ; connection++) {
+            
+            Scalar* row = weights + connection * m_stride;
+            
+            for (size_t record = 0 ; record < count ; record++) {
+                
+                Scalar omicron = omicrons[record * m_connections + connection];
+                if (omicron != 0.0)
+                    kernels.axpy(omicron, deltas + record * m_size, row, m_size);
+            }
+        }
+    }
+    else {
+        
+        //A row of sums stays in the cache while it accumulates the whole batch
+        for (size_t perceptron = 0 ; perceptron < m_size ; perceptron++) {
+            
+            Scalar* row = weights + perceptron * m_stride;
+            
+            for (size_t record = 0 ; record < count ; record++)
+                kernels.axpy(deltas[record * m_size + perceptron], omicrons + record * m_connections, row, m_connections);
+        }
+    }
+    
+    for (size_t record = 0 ; record < count ; record++)
+        kernels.axpy(1.0, deltas + record * m_size, biases, m_size);
+}
+
+template <typename Scalar>
+void Layer<Scalar>::ApplyWeightsGradient(const Scalar* weights, size_t count, size_t begin, size_t end) {
+    ActiveKernels<Scalar>().axpy(-m_learning_constant / count, weights + begin, m_weights.data() + begin, end - begin);
+}
+
+template <typename Scalar>
+void Layer<Scalar>::ApplyBiasesGradient(const Scalar* biases, size_t count) {
+    ActiveKernels<Scalar>().axpy(-m_learning_constant / count, biases, m_biases.data(), m_size);
+}
+
+template <typename Scalar>
+void Layer<Scalar>::ExportParameters(double* parameters) const {
+    
+    for (size_t perceptron = 0 ; perceptron < m_size ; perceptron++) {
+        
+        for (size_t connection = 0 ; connection < m_connections ; connection++)
+            *parameters++ = Weight(perceptron, connection);
+        
+        *parameters++ = m_biases[perceptron];
+    }
+}
+
+template <typename Scalar>
+void Layer<Scalar>::ImportParameters(const double* parameters) {
+    
+    for (size_t perceptron = 0 ; perceptron < m_size ; perceptron++) {
+        
+        for (size_t connection = 0 ; connection < m_connections ; connection++) {
+            
+            size_t index = (m_input_major) ? connection * m_stride + perceptron : perceptron * m_stride + connection;
+            m_weights[index] = static_cast<Scalar>(*parameters++);
+        }
+        
+        m_biases[perceptron] = static_cast<Scalar>(*parameters++);
+    }
+}
+
+template <typename Scalar>
+Perceptron<Scalar> Layer<Scalar>::At(size_t index) {
+    return Perceptron<Scalar>(m_weights.data() + index * m_stride, m_connections, m_biases[index], m_learning_constant);
+}
+
+template <typename Scalar>
+void Layer<Scalar>::Activate(Scalar* values, size_t count) const {
+    
+    if (m_activation == ActivationType::kSigmoid && m_fast_activation)
+        ActiveKernels<Scalar>().fast_sigmoid(values, values, count);
+    else
+        neural::Activate(m_activation, values, count);
+}
+
+template <typename Scalar>
+void Layer<Scalar>::Derive(const Scalar* outputs, const Scalar* errors, Scalar* deltas, size_t count) const {
+    
+    switch (m_activation) {
+        case ActivationType::kSigmoid:      ActiveKernels<Scalar>().sigmoid_delta(outputs, errors, deltas, count);     break;
+        case ActivationType::kReLU:         DeriveAll<ReLUActivation>(outputs, errors, deltas, count);                 break;
+        case ActivationType::kLeakyReLU:    DeriveAll<LeakyReLUActivation>(outputs, errors, deltas, count);            break;
+        case ActivationType::kTanh:         DeriveAll<TanhActivation>(outputs, errors, deltas, count);                 break;
+    }
+}
+
+template <typename Scalar>
+template <typename Task>
+void Layer<Scalar>::Parallel(size_t count, size_t work, const Task& task) const {
+    
+    //Small layers are done before the other threads would wake up
+    if (m_pool && m_pool->Threads() > 1 && work >= kParallelWork)
+        m_pool->Run(count, NEURAL_ALIGNMENT / sizeof(Scalar), task);
+    else
+        task(0, count);
+}
+
+template <typename Scalar>
+void Layer<Scalar>::SetInputMajor(bool input_major) {
+    
+    if (input_major == m_input_major)
+        return;
+    
+    //The rows become the columns
+    size_t rows = (input_major) ? m_connections : m_size;
+    size_t columns = (input_major) ? m_size : m_connections;
+    size_t stride = AlignedStride<Scalar>(columns);
+    
+    AlignedVector<Scalar> weights(rows * stride, 0.0);
+    
+    for (size_t row = 0 ; row < rows ; row++)
+        for (size_t column = 0 ; column < columns ; column++)
+            weights[row * stride + column] = m_weights[column * m_stride + row];
+    
+    m_weights = AlignedBuffer<Scalar>(std::move(weights));
+    m_stride = stride;
+    m_input_major = input_major;
+}
+
+template <typename Scalar>
+std::string Layer<Scalar>::Serialize() const {
+    
+    std::string serialized;
+    
+    //The views are only used for reading
+    Layer<Scalar>& layer = const_cast<Layer<Scalar>&>(*this);
+    
+    //Perceptrons are always serialized by row, so an input major layer gathers them first
+    std::vector<Scalar> row(m_connections);
+    Scalar learning_constant = m_learning_constant;
+    
+    for (size_t index = 0 ; index < m_size ; index++) {
+        
+        if (m_input_major) {
+            
+            for (size_t connection = 0 ; connection < m_connections ; connection++)
+                row[connection] = Weight(index, connection);
+            
+            serialized += Perceptron<Scalar>(row.data(), m_connections, layer.m_biases[index], learning_constant).Serialize() + '\n';
+        }
+        else
+            serialized += layer.At(index).Serialize() + '\n';
+    }
+    
+    return serialized;
+}
+
+template class neural::Layer<double>;
+template class neural::Layer<float>;
@@ -0,0 +1,424 @@
+//
+//  Layer.hpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#ifndef Layer_hpp
+#define Layer_hpp
+#include "Definitions.h"
+#include "AlignedAllocator.hpp"
+#include "Perceptron.hpp"
+#include "Activation.hpp"
+#include <string>
+#include <vector>
+#include <stdint.h>
+NAMESPACE_NEURAL_BEGIN
+class ThreadPool;
+
+/**
+ * A layer holds the weights of all of it's perceptrons in a
+ * single row-major matrix (one padded row per perceptron) and
+ * their biases in a single vector. This allows processing a
+ * whole layer as one matrix-vector product that streams through
+ * contiguous memory.
+ *
+ * A layer that receives sparse input can instead be stored input
+ * major (one padded row per input, the transpose of the above), so
+ * that an input of zero skips a whole contiguous row of weights.
+ */
+template <typename Scalar>
+class Layer {
+public:
+    
+    /**
+     * Constructor.
+     *
+     * @param perceptrons           Number of perceptrons in the layer.
+     * @param connections           Number of inputs that every perceptron has.
+     * @param learning_constant     The learning rate for weights adjustments.
+     * @param bias                  The starting bias of every perceptron.
+     * @param activation            The activation function of the perceptrons.
+     */
+    Layer(size_t perceptrons,
+          size_t connections,
+          Scalar learning_constant = 0.01,
+          Scalar bias = 1.0,
+          ActivationType activation = ActivationType::kSigmoid);
+    
+    /**
+     * Reads a layer in the form that a network serializes it: a line
+     * with the number of perceptrons (and the activation, if it is not
+     * the sigmoid), followed by a line per perceptron. The buffer is
+     * read in place, in a single pass.
+     *
+     * @param serialized    The beginning of the layer, moved past it.
+     * @param end           The end of the buffer.
+     * @param layer         Receives the layer.
+     * @param pool          The threads that share the perceptrons, or NULL.
+     * @return True if the layer was read, false if it's size or
+     *         activation could not be, a perceptron's line is missing or
+     *         malformed, or the perceptrons differ in their number of
+     *         weights.
+     */
+    static bool Deserialize(const char*& serialized, const char* end, Layer& layer, ThreadPool* pool = NULL);
+    
+    /**
+     * Constructor. The layer uses the given weights and biases as they
+     * are, which lets it run straight from the pages of a mapped file.
+     * The weights must be laid out as 'Weights' returns them.
+     *
+     * @param perceptrons           Number of perceptrons in the layer.
+     * @param connections           Number of inputs that every perceptron has.
+     * @param input_major           True if the weights are stored as a row per input.
+     * @param activation            The activation function of the perceptrons.
+     * @param learning_constant     The learning rate for weights adjustments.
+     * @param weights               The padded rows of weights.
+     * @param biases                The bias of every perceptron.
+     */
+    Layer(size_t perceptrons,
+          size_t connections,
+          bool input_major,
+          ActivationType activation,
+          Scalar learning_constant,
+          AlignedBuffer<Scalar> weights,
+          AlignedBuffer<Scalar> biases);
+    
+    /**
+     * Calculates the output of every perceptron in the layer.
+     *
+     * @param input     The input to the layer, must have 'Connections()' values.
+     * @param output    Receives the result, must have room for 'Size()' values.
+     */
+    void Feed(const Scalar* input, Scalar* output) const;
+    
+    /**
+     * Calculates the output of every perceptron in the layer for a binary
+     * input, given as the indices of the inputs that are 1 (all the others
+     * are 0). The result is the sum of the weights of the set inputs only.
+     *
+     * @param active    The indices of the inputs that are set.
+     * @param count     The number of indices.
+     * @param output    Receives the result, must have room for 'Size()' values.
+     */
+    void FeedSparse(const uint32_t* active, size_t count, Scalar* output) const;
+    
+    /**
+     * Trains all the perceptrons of the layer according to their deltas
+     * and the omicron (output) of the previous layer.
+     *
+     * @param deltas    The delta of every perceptron in the layer.
+     * @param omicron   The omicron (output) of the previous layer.
+     */
+    void Train(const Scalar* deltas, const Scalar* omicron);
+    
+    /**
+     * Trains all the perceptrons of the layer for a binary input, given
+     * as the indices of the inputs that are 1. Only the weights of the
+     * set inputs change.
+     *
+     * @param deltas    The delta of every perceptron in the layer.
+     * @param active    The indices of the inputs that are set.
+     * @param count     The number of indices.
+     */
+    void TrainSparse(const Scalar* deltas, const uint32_t* active, size_t count);
+    
+    /**
+     * Calculates the output of every perceptron in the layer for a batch
+     * of inputs at once (a matrix-matrix product). Every weight is loaded
+     * once per block of the batch instead of once per record.
+     *
+     * @param inputs    The inputs, 'count' rows of 'Connections()' values.
+     * @param count     The number of records in the batch.
+     * @param outputs   Receives 'count' rows of 'Size()' values.
+     */
+    void FeedBatch(const Scalar* inputs, size_t count, Scalar* outputs) const;
+    
+    /**
+     * Propogates the deltas of the layer through it's weights, giving the
+     * error of every input (the transposed weights times the deltas). The
+     * weights are read row after row, so the memory is walked contiguously.
+     *
+     * @param deltas    The delta of every perceptron in the layer.
+     * @param errors    Receives the error of every input, must have room for 'Connections()' values.
+     */
+    void BackPropogate(const Scalar* deltas, Scalar* errors) const;
+    
+    /**
+     * Propogates the deltas of a batch through the weights of the layer,
+     * giving the error of every input of every record (deltas * weights).
+     *
+     * @param deltas    The deltas, 'count' rows of 'Size()' values.
+     * @param count     The number of records in the batch.
+     * @param errors    Receives 'count' rows of 'Connections()' values.
+     */
+    void BackPropogateBatch(const Scalar* deltas, size_t count, Scalar* errors) const;
+    
+    /**
+     * Sums the updates that every record in the batch would make to the
+     * weights and biases, without applying them. The sums of several
+     * batches can be added together before they are applied.
+     *
+     * @param deltas        The deltas, 'count' rows of 'Size()' values.
+     * @param omicrons      The inputs that produced the deltas, 'count' rows of 'Connections()' values.
+     * @param count         The number of records in the batch, may be 0.
+     * @param weights       Receives the sums for the weights, laid out as the weights ('GradientSize()' values).
+     * @param biases        Receives the sums for the biases, 'Size()' values.
+     * @param accumulate    True to add to the sums that are already there instead of replacing them.
+     */
+    void Gradient(const Scalar* deltas, const Scalar* omicrons, size_t count, Scalar* weights, Scalar* biases, bool accumulate = false) const;
+    
+    /**
+     * Applies a part of the sums of 'Gradient' to the weights, as the
+     * average of the updates of all the records that were summed.
+     *
+     * @param weights   The sums for the weights.
+     * @param count     The number of records that were summed.
+     * @param begin     The first value of the part.
+     * @param end       The end of the part, at most 'GradientSize()'.
+     */
+    void ApplyWeightsGradient(const Scalar* weights, size_t count, size_t begin, size_t end);
+    
+    /**
+     * Applies the sums of 'Gradient' to the biases, as the average
+     * of the updates of all the records that were summed.
+     *
+     * @param biases    The sums for the biases.
+     * @param count     The number of records that were summed.
+     */
+    void ApplyBiasesGradient(const Scalar* biases, size_t count);
+    
+    /**
+     * Returns the number of values in the sums of the weights.
+     *
+     * @return The size of the weights, including the padding of the rows.
+     */
+    size_t GradientSize() const { return m_weights.size(); }
+    
+    /**
+     * Returns the number of weights and biases, without the padding.
+     *
+     * @return The number of parameters.
+     */
+    size_t Parameters() const { return m_size * (m_connections + 1); }
+    
+    /**
+     * Copies the weights and biases in the order of 'Serialize', the
+     * weights of every perceptron followed by it's bias.
+     *
+     * @param parameters    Receives 'Parameters()' values.
+     */
+    void ExportParameters(double* parameters) const;
+    
+    /**
+     * Replaces the weights and biases, in the order of 'ExportParameters'.
+     *
+     * @param parameters    The 'Parameters()' values.
+     */
+    void ImportParameters(const double* parameters);
+    
+    /**
+     * Returns a view of the perceptron at the given index.
+     * Only available when the layer is not input major.
+     *
+     * @param index     The index of the perceptron.
+     * @return The perceptron at the index.
+     */
+    Perceptron<Scalar> At(size_t index);
+    
+    /**
+     * Returns the weight that connects a perceptron to an input.
+     *
+     * @param perceptron    The index of the perceptron.
+     * @param connection    The index of the input.
+     * @return The weight value.
+     */
+    Scalar Weight(size_t perceptron, size_t connection) const {
+        return (m_input_major) ? m_weights[connection * m_stride + perceptron] : m_weights[perceptron * m_stride + connection];
+    }
+    
+    /**
+     * Returns the bias of a perceptron.
+     *
+     * @param perceptron    The index of the perceptron.
+     * @return The bias value.
+     */
+    Scalar Bias(size_t perceptron) const { return m_biases[perceptron]; }
+    
+    /**
+     * Returns the weights as they are stored, 'GradientSize()' values
+     * in rows of 'Stride()' values (a row per perceptron, or per input
+     * if the layer is input major).
+     *
+     * @return The weights.
+     */
+    const Scalar* Weights() const { return m_weights.data(); }
+    
+    /**
+     * Returns the bias of every perceptron.
+     *
+     * @return 'Size()' biases.
+     */
+    const Scalar* Biases() const { return m_biases.data(); }
+    
+    /**
+     * Returns the distance between the beginning of two rows of weights.
+     *
+     * @return The stride.
+     */
+    size_t Stride() const { return m_stride; }
+    
+    /**
+     * Returns the learning rate for weights adjustments.
+     *
+     * @return The learning constant.
+     */
+    Scalar LearningConstant() const { return m_learning_constant; }
+    
+    /**
+     * Applies the derivative of the activation function to the errors
+     * of the outputs, giving the delta of every perceptron.
+     *
+     * @param outputs   The outputs of the layer.
+     * @param errors    The errors of the outputs.
+     * @param deltas    Receives the deltas.
+     * @param count     The number of values (a multiple of 'Size()' for a batch).
+     */
+    void Derive(const Scalar* outputs, const Scalar* errors, Scalar* deltas, size_t count) const;
+    
+    /**
+     * Changes the layout of the weights between perceptron major (the
+     * default) and input major, which suits sparse input.
+     *
+     * @param input_major   True to store a row per input.
+     */
+    void SetInputMajor(bool input_major);
+    
+    /**
+     * Returns true if the weights are stored as a row per input.
+     *
+     * @return The layout of the weights.
+     */
+    bool InputMajor() const { return m_input_major; }
+    
+    /**
+     * Splits the work of the layer between the threads of a pool, by
+     * perceptrons (or by inputs when the errors are propogated), which
+     * gives the same results as a single thread. Layers that are too
+     * small to be worth the synchronization still run on one thread.
+     *
+     * @param pool  The pool to use, which must outlive it's use by the layer,
+     *              or NULL to run on the calling thread only.
+     */
+    void SetThreadPool(ThreadPool* pool) { m_pool = pool; }
+    
+    /**
+     * Changes the activation function of the perceptrons.
+     *
+     * @param activation    The activation function.
+     */
+    void SetActivation(ActivationType activation) { m_activation = activation; }
+    
+    /**
+     * Returns the activation function of the perceptrons.
+     *
+     * @return The activation function.
+     */
+    ActivationType Activation() const { return m_activation; }
+    
+    /**
+     * Chooses between the exact sigmoid (the default) and the fast
+     * approximation of 'FastSigmoid', which is applied to the whole
+     * layer at once by the vectorized kernels. Only affects a layer
+     * whose activation is the sigmoid.
+     *
+     * @param fast  True to use the approximation.
+     */
+    void SetFastActivation(bool fast) { m_fast_activation = fast; }
+    
+    /**
+     * Returns the number of perceptrons in the layer.
+     *
+     * @return Number of perceptrons.
+     */
+    size_t Size() const { return m_size; }
+    
+    /**
+     * Returns the number of inputs that every perceptron has.
+     *
+     * @return Number of connections.
+     */
+    size_t Connections() const { return m_connections; }
+    
+    /**
+     * Returns the memory that the weights and biases occupy.
+     *
+     * @return The size in bytes.
+     */
+    size_t Bytes() const { return (m_weights.size() + m_biases.size()) * sizeof(Scalar); }
+    
+    /**
+     * Outputs the layer into a format that can later
+     * be loaded to recreate the setup and weights.
+     *
+     * @return The serialized version of the layer, a perceptron per line.
+     */
+    std::string Serialize() const;
+    
+private:
+    
+    /**
+     * Applies the activation function to the sums of the perceptrons.
+     *
+     * @param values    The sums, which are replaced by the activations.
+     * @param count     The number of values.
+     */
+    void Activate(Scalar* values, size_t count) const;
+    
+    /**
+     * Calls 'task(begin, end)' on parts of the range [0, count), in
+     * the threads of the pool if the work is large enough.
+     *
+     * @param count     The size of the range.
+     * @param work      The number of multiplications in the whole range.
+     * @param task      The work to do on a part.
+     */
+    template <typename Task>
+    void Parallel(size_t count, size_t work, const Task& task) const;
+    
+    ///Stores the number of perceptrons (rows)
+    size_t m_size;
+    
+    ///Stores the number of inputs (columns)
+    size_t m_connections;
+    
+    ///Stores the distance between rows, padded to a cache line
+    size_t m_stride;
+    
+    ///Stores true if every row holds the weights of an input (instead of a perceptron)
+    bool m_input_major;
+    
+    ///Stores the threads that share the work, or NULL
+    ThreadPool* m_pool;
+    
+    ///Stores the activation function of the perceptrons
+    ActivationType m_activation;
+    
+    ///Stores true if the activation is approximated
+    bool m_fast_activation;
+    
+    ///Stores the weights of all perceptrons, row after row
+    AlignedBuffer<Scalar> m_weights;
+    
+    ///Stores the bias of every perceptron
+    AlignedBuffer<Scalar> m_biases;
+    
+    ///Stores the learning constant that is shared by the perceptrons
+    Scalar m_learning_constant;
+    
+};
+
+NAMESPACE_NEURAL_END
+#endif /* Layer_hpp */
@@ -0,0 +1,172 @@
+//
+//  LoadGenerator.cpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#include "LoadGenerator.hpp"
+#include "Connection.hpp"
+#include "DataIterator.hpp"
+#include "Data.hpp"
+#include <thread>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <string.h>
+
+using namespace neural;
+
+/**
+ * Implementation.
+ */
+class LoadGenerator::Impl {
+public:
+    
+    /**
+     * Constructor.
+     *
+     * @param address   The address of the server.
+     */
+    Impl(const std::string& address) : m_address(address) { }
+    
+    /**
+     * Sends all the records of a file from several clients at once.
+     *
+     * @param data_file_path    The path to the data file.
+     * @param clients           The number of clients.
+     * @param batch_size        The number of records of every request.
+     * @param results           Receives the estimation of every record.
+     * @param log               Flag that indicates to print the statistics.
+     * @return True if every request was answered.
+     */
+    bool Run(const std::string& data_file_path, size_t clients, size_t batch_size, std::vector<double>& results, bool log);
+    
+private:
+    
+    /**
+     * Sends the requests of a single client, every 'clients' request
+     * starting from the client's index. Runs on a thread per client.
+     *
+     * @param client        The index of the client.
+     * @param clients       The number of clients.
+     * @param records       The records of the file.
+     * @param batch_size    The number of records of every request.
+     * @param results       Receives the estimation of every record of the client.
+     * @param latencies     Receives the latency of every request of the client, in seconds.
+     * @return True if every request of the client was answered.
+     */
+    bool Send(size_t client, size_t clients, const std::vector<Data>& records, size_t batch_size, std::vector<double>& results, std::vector<double>& latencies) const;
+    
+    ///Stores the address of the server
+    std::string m_address;
+    
+};
+
+#pragma mark - Implementation
+
+bool LoadGenerator::Impl::Run(const std::string& data_file_path, size_t clients, size_t batch_size, std::vector<double>& results, bool log) {
+    
+    clients = std::max<size_t>(clients, 1);
+    batch_size = std::max<size_t>(batch_size, 1);
+    
+    //The file is read ahead, so that only the requests are measured
+    std::vector<Data> records;
+    
+    for (DataIterator data(data_file_path) ; data.Valid() ; data.Next())
+        records.push_back(data.Value());
+    
+    results.assign(records.size(), 0.0);
+    
+    std::vector<std::vector<double> > latencies(clients);
+    std::vector<char> succeeded(clients, false);
+    std::vector<std::thread> threads;
+    
+    auto start = std::chrono::steady_clock::now();
+    
+    for (size_t client = 0 ; client < clients ; client++)
+        threads.push_back(std::thread([this, client, clients, batch_size, &records, &results, &latencies, &succeeded]() {
+            succeeded[client] = Send(client, clients, records, batch_size, results, latencies[client]);
+        }));
+    
+    for (size_t client = 0 ; client < clients ; client++)
+        threads[client].join();
+    
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    
+    std::vector<double> all_latencies;
+    
+    for (size_t client = 0 ; client < clients ; client++)
+        all_latencies.insert(all_latencies.end(), latencies[client].begin(), latencies[client].end());
+    
+    if (log && !all_latencies.empty()) {
+        
+        std::sort(all_latencies.begin(), all_latencies.end());
+        
+        std::cout
+        << std::fixed << std::setprecision(3)
+        << all_latencies.size() << " requests (" << records.size() << " records) from " << clients << " clients in " << elapsed.count() << " seconds:\t"
+        << all_latencies.size() / elapsed.count() << " requests/sec\t"
+        << records.size() / elapsed.count() << " records/sec\t"
+        << "latency p50 " << all_latencies[(all_latencies.size() - 1) / 2] * 1000 << " ms\t"
+        << "p99 " << all_latencies[(all_latencies.size() - 1) * 99 / 100] * 1000 << " ms\n";
+    }
+    
+    return std::find(succeeded.begin(), succeeded.end(), false) == succeeded.end();
+}
+
+bool LoadGenerator::Impl::Send(size_t client, size_t clients, const std::vector<Data>& records, size_t batch_size, std::vector<double>& results, std::vector<double>& latencies) const {
+    
+    std::unique_ptr<Connection> connection = Connection::Connect(m_address);
+    
+    if (!connection)
+        return false;
+    
+    std::vector<double> payload;
+    std::vector<char> reply;
+    Connection::Message type;
+    uint32_t count;
+    
+    size_t requests = (records.size() + batch_size - 1) / batch_size;
+    
+    for (size_t request = client ; request < requests ; request += clients) {
+        
+        size_t first = request * batch_size;
+        size_t last = std::min(first + batch_size, records.size());
+        
+        payload.clear();
+        
+        for (size_t record = first ; record < last ; record++)
+            payload.insert(payload.end(), records[record].content.begin(), records[record].content.end());
+        
+        auto start = std::chrono::steady_clock::now();
+        
+        if (!connection->Send(Connection::Message::kEstimate, static_cast<uint32_t>(last - first), payload.data(), payload.size() * sizeof(double)) ||
+            !connection->Receive(type, count, reply) ||
+            type != Connection::Message::kEstimates ||
+            reply.size() != (last - first) * sizeof(double))
+            return false;
+        
+        std::chrono::duration<double> latency = std::chrono::steady_clock::now() - start;
+        latencies.push_back(latency.count());
+        
+        //Every request has it's own part of the results
+        memcpy(results.data() + first, reply.data(), reply.size());
+    }
+    
+    return true;
+}
+
+#pragma mark - LoadGenerator functions
+
+LoadGenerator::LoadGenerator(const std::string& address) :
+m_pimpl(new Impl(address))
+{ }
+
+LoadGenerator::~LoadGenerator() { };
+
+bool LoadGenerator::Run(const std::string& data_file_path, size_t clients, size_t batch_size, std::vector<double>& results, bool log) {
+    return m_pimpl->Run(data_file_path, clients, batch_size, results, log);
+}
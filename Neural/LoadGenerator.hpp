@@ -0,0 +1,63 @@
+//
+//  LoadGenerator.hpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#ifndef LoadGenerator_hpp
+#define LoadGenerator_hpp
+#include "Definitions.h"
+#include <string>
+#include <vector>
+#include <memory>
+NAMESPACE_NEURAL_BEGIN
+
+/**
+ * Sends the records of a file to an 'InferenceServer' from several
+ * clients at once, each waiting for the reply to a request before it
+ * sends the next one, and measures the latency of the requests.
+ */
+class LoadGenerator {
+public:
+    
+    /**
+     * Constructor.
+     *
+     * @param address   The address of the server, "unix:<path>" or "<host>:<port>".
+     */
+    LoadGenerator(const std::string& address);
+    
+    /**
+     * Sends all the records of a file, in requests of 'batch_size'
+     * records that are shared between the clients, and prints the
+     * throughput and the 50th and 99th percentiles of the latency.
+     *
+     * @param data_file_path    The path to the file containing the pixel data.
+     * @param clients           The number of clients that send requests at once.
+     * @param batch_size        The number of records of every request.
+     * @param results           Receives the estimation of every record, in the order of the file.
+     * @param log               Flag that indicates to print the statistics to consule.
+     * @return True if every request was answered.
+     */
+    bool Run(const std::string& data_file_path,
+             size_t clients,
+             size_t batch_size,
+             std::vector<double>& results,
+             bool log = true);
+    
+    /**
+     * Destructor.
+     */
+    ~LoadGenerator();
+    
+private:
+    
+    class Impl;
+    std::unique_ptr<Impl> m_pimpl;
+    
+};
+
+NAMESPACE_NEURAL_END
+#endif /* LoadGenerator_hpp */
@@ -0,0 +1,439 @@
+//
+//  ModelFile.cpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#include "ModelFile.hpp"
+#include "Layer.hpp"
+#include "AlignedAllocator.hpp"
+#include <fstream>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace neural;
+
+///The string that every binary model begins with
+static const char kMagic[8] = { 'N', 'E', 'U', 'R', 'A', 'L', 'B', 'M' };
+
+///Written in the byte order of the host, a file from a host of the other order reads it reversed
+static const uint32_t kByteOrder = 0x01020304;
+
+///The version of the format, changed whenever the layout changes
+static const uint32_t kVersion = 1;
+
+/**
+ * The header of the file, a cache line.
+ */
+struct Header {
+    
+    ///The magic string
+    char magic[8];
+    
+    ///The byte order of the host that wrote the file
+    uint32_t byte_order;
+    
+    ///The version of the format
+    uint32_t version;
+    
+    ///The type of the network, as 'OperationalNetwork::Type'
+    uint32_t type;
+    
+    ///The size of the scalar type of the weights in bytes
+    uint32_t scalar_size;
+    
+    ///The number of networks
+    uint32_t networks;
+    
+    ///The number of layers in every network
+    uint32_t layers;
+    
+    ///The size of the whole file in bytes
+    uint64_t bytes;
+    
+    ///The checksum of everything after the header
+    uint64_t checksum;
+    
+    uint8_t reserved[16];
+};
+
+/**
+ * An entry of the table of layers, which follows the header.
+ */
+struct LayerEntry {
+    
+    ///The number of perceptrons
+    uint32_t size;
+    
+    ///The number of inputs of every perceptron
+    uint32_t connections;
+    
+    ///The distance between the beginning of two rows of weights
+    uint32_t stride;
+    
+    ///1 if the weights are stored as a row per input
+    uint32_t input_major;
+    
+    ///The activation function, as 'ActivationType'
+    uint32_t activation;
+    
+    uint32_t reserved;
+    
+    ///The learning constant of the perceptrons
+    double learning_constant;
+    
+    ///The offset of the weights from the beginning of the file
+    uint64_t weights;
+    
+    ///The offset of the biases from the beginning of the file
+    uint64_t biases;
+};
+
+static_assert(sizeof(Header) == NEURAL_ALIGNMENT, "The header must be a cache line");
+
+/**
+ * Returns the FNV-1a hash of the bytes.
+ *
+ * @param bytes     The bytes to hash.
+ * @param count     The number of bytes.
+ * @return The hash.
+ */
+static uint64_t Checksum(const char* bytes, size_t count) {
+    
+    uint64_t hash = 14695981039346656037ULL;
+    
+    for (size_t index = 0 ; index < count ; index++) {
+        
+        hash ^= static_cast<uint8_t>(bytes[index]);
+        hash *= 1099511628211ULL;
+    }
+    
+    return hash;
+}
+
+/**
+ * Returns the offset rounded up to a cache line.
+ *
+ * @param offset    The offset.
+ * @return The aligned offset.
+ */
+static uint64_t Align(uint64_t offset) {
+    return (offset + NEURAL_ALIGNMENT - 1) / NEURAL_ALIGNMENT * NEURAL_ALIGNMENT;
+}
+
+/**
+ * Implementation.
+ */
+class ModelFile::Impl {
+public:
+    
+    /**
+     * Constructor.
+     */
+    Impl();
+    
+    /**
+     * Maps the file and validates it.
+     *
+     * @param path  The path to the file.
+     * @return True if the file is a valid model.
+     */
+    bool Map(const std::string& path);
+    
+    /**
+     * Returns the header of the file.
+     *
+     * @return The header.
+     */
+    const Header& FileHeader() const { return *reinterpret_cast<const Header*>(m_data); }
+    
+    /**
+     * Returns the entry of a layer.
+     *
+     * @param index     The index of the layer, over all the networks.
+     * @return The entry.
+     */
+    const LayerEntry& Entry(size_t index) const { return reinterpret_cast<const LayerEntry*>(m_data + sizeof(Header))[index]; }
+    
+    /**
+     * Returns the mapped bytes at an offset.
+     *
+     * @param offset    The offset from the beginning of the file.
+     * @return The bytes.
+     */
+    char* At(uint64_t offset) const { return m_data + offset; }
+    
+    /**
+     * Destructor.
+     */
+    ~Impl();
+    
+private:
+    
+    /**
+     * Checks that the table of layers describes networks that can be
+     * built from the file.
+     *
+     * @return True if the table is valid.
+     */
+    bool ValidTable() const;
+    
+    ///Stores the mapped file, NULL until it is mapped
+    char* m_data;
+    
+    ///Stores the size of the mapping
+    size_t m_size;
+    
+};
+
+#pragma mark - Implementation
+
+ModelFile::Impl::Impl() :
+m_data(NULL),
+m_size(0)
+{ }
+
+ModelFile::Impl::~Impl() {
+    
+    if (m_data)
+        munmap(m_data, m_size);
+}
+
+bool ModelFile::Impl::Map(const std::string& path) {
+    
+    int file = open(path.c_str(), O_RDONLY);
+    
+    if (file < 0)
+        return false;
+    
+    struct stat status;
+    
+    if (fstat(file, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(Header))) {
+        
+        close(file);
+        return false;
+    }
+    
+    /*
+     * A private mapping shares the pages of the page cache between all
+     * the processes that map the file, and is copied page by page only
+     * where a process writes to it. The mapping stays valid after the
+     * file is closed, or replaced by a rename.
+     */
+    void* mapping = mmap(NULL, status.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+    close(file);
+    
+    if (mapping == MAP_FAILED)
+        return false;
+    
+    m_data = static_cast<char*>(mapping);
+    m_size = status.st_size;
+    
+    const Header& header = FileHeader();
+    
+    if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+        header.byte_order != kByteOrder ||
+        header.version != kVersion ||
+        header.bytes != m_size ||
+        (header.scalar_size != sizeof(double) && header.scalar_size != sizeof(float)) ||
+        (header.type != static_cast<uint32_t>(OperationalNetwork::Type::kCombined) && header.type != static_cast<uint32_t>(OperationalNetwork::Type::kSeperated)) ||
+        header.networks == 0 || header.layers == 0)
+        return false;
+    
+    //The table must fit before the checksum reads past it
+    if (sizeof(Header) + static_cast<uint64_t>(header.networks) * header.layers * sizeof(LayerEntry) > m_size)
+        return false;
+    
+    return Checksum(m_data + sizeof(Header), m_size - sizeof(Header)) == header.checksum && ValidTable();
+}
+
+bool ModelFile::Impl::ValidTable() const {
+    
+    const Header& header = FileHeader();
+    
+    for (size_t network = 0 ; network < header.networks ; network++) {
+        
+        for (size_t layer = 0 ; layer < header.layers ; layer++) {
+            
+            const LayerEntry& entry = Entry(network * header.layers + layer);
+            
+            //Every layer takes the outputs of the one before it
+            if (layer > 0 && entry.connections != Entry(network * header.layers + layer - 1).size)
+                return false;
+            
+            size_t rows = (entry.input_major) ? entry.connections : entry.size;
+            size_t columns = (entry.input_major) ? entry.size : entry.connections;
+            size_t per_line = NEURAL_ALIGNMENT / header.scalar_size;
+            uint64_t weights_bytes = static_cast<uint64_t>(rows) * entry.stride * header.scalar_size;
+            uint64_t biases_bytes = static_cast<uint64_t>(entry.size) * header.scalar_size;
+            
+            if (entry.size == 0 || entry.connections == 0 ||
+                entry.stride != (columns + per_line - 1) / per_line * per_line ||
+                entry.activation > static_cast<uint32_t>(ActivationType::kTanh) ||
+                entry.weights % NEURAL_ALIGNMENT != 0 || entry.biases % NEURAL_ALIGNMENT != 0 ||
+                entry.weights > m_size || weights_bytes > m_size - entry.weights ||
+                entry.biases > m_size || biases_bytes > m_size - entry.biases)
+                return false;
+        }
+    }
+    
+    return true;
+}
+
+#pragma mark - ModelFile functions
+
+ModelFile::ModelFile() :
+m_pimpl(new Impl())
+{ }
+
+ModelFile::~ModelFile() { };
+
+bool ModelFile::Recognize(const std::string& path) {
+    
+    char magic[sizeof(kMagic)];
+    std::ifstream file(path, std::ios::binary);
+    
+    return file.read(magic, sizeof(magic)) && memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+std::shared_ptr<ModelFile> ModelFile::Open(const std::string& path) {
+    
+    std::shared_ptr<ModelFile> file(new ModelFile());
+    
+    if (!file->m_pimpl->Map(path))
+        file.reset();
+    
+    return file;
+}
+
+OperationalNetwork::Type ModelFile::Type() const {
+    return static_cast<OperationalNetwork::Type>(m_pimpl->FileHeader().type);
+}
+
+OperationalNetwork::Precision ModelFile::Precision() const {
+    return (m_pimpl->FileHeader().scalar_size == sizeof(float)) ? OperationalNetwork::Precision::kFloat : OperationalNetwork::Precision::kDouble;
+}
+
+template <typename Scalar>
+std::vector<std::unique_ptr<BasicNetwork<Scalar> > > ModelFile::Networks() {
+    
+    const Header& header = m_pimpl->FileHeader();
+    std::vector<std::unique_ptr<BasicNetwork<Scalar> > > networks;
+    
+    if (header.scalar_size != sizeof(Scalar))
+        return networks;
+    
+    //Every layer keeps the whole file mapped
+    std::shared_ptr<const void> owner = shared_from_this();
+    
+    for (size_t network = 0 ; network < header.networks ; network++) {
+        
+        std::vector<Layer<Scalar> > layers;
+        layers.reserve(header.layers);
+        
+        for (size_t layer = 0 ; layer < header.layers ; layer++) {
+            
+            const LayerEntry& entry = m_pimpl->Entry(network * header.layers + layer);
+            size_t rows = (entry.input_major) ? entry.connections : entry.size;
+            
+            AlignedBuffer<Scalar> weights(reinterpret_cast<Scalar*>(m_pimpl->At(entry.weights)), rows * entry.stride, owner);
+            AlignedBuffer<Scalar> biases(reinterpret_cast<Scalar*>(m_pimpl->At(entry.biases)), entry.size, owner);
+            
+            layers.push_back(Layer<Scalar>(entry.size,
+                                           entry.connections,
+                                           entry.input_major != 0,
+                                           static_cast<ActivationType>(entry.activation),
+                                           static_cast<Scalar>(entry.learning_constant),
+                                           std::move(weights),
+                                           std::move(biases)));
+        }
+        
+        networks.push_back(std::unique_ptr<BasicNetwork<Scalar> >(new BasicNetwork<Scalar>(std::move(layers))));
+    }
+    
+    return networks;
+}
+
+template <typename Scalar>
+bool ModelFile::Write(std::ostream& output, OperationalNetwork::Type type, const std::vector<const BasicNetwork<Scalar>*>& networks) {
+    
+    std::vector<std::vector<const Layer<Scalar>*> > layers;
+    
+    for (size_t network = 0 ; network < networks.size() ; network++) {
+        
+        layers.push_back(networks[network]->Layers());
+        
+        if (layers.back().size() != layers.front().size())
+            return false;
+    }
+    
+    if (layers.empty())
+        return false;
+    
+    //The table, then the weights and biases of every layer on a cache line each
+    uint64_t offset = Align(sizeof(Header) + networks.size() * layers.front().size() * sizeof(LayerEntry));
+    std::vector<LayerEntry> table;
+    
+    for (size_t network = 0 ; network < layers.size() ; network++) {
+        
+        for (size_t layer = 0 ; layer < layers[network].size() ; layer++) {
+            
+            const Layer<Scalar>& source = *layers[network][layer];
+            LayerEntry entry = { };
+            
+            entry.size = static_cast<uint32_t>(source.Size());
+            entry.connections = static_cast<uint32_t>(source.Connections());
+            entry.stride = static_cast<uint32_t>(source.Stride());
+            entry.input_major = source.InputMajor() ? 1 : 0;
+            entry.activation = static_cast<uint32_t>(source.Activation());
+            entry.learning_constant = source.LearningConstant();
+            entry.weights = offset;
+            offset = Align(offset + source.GradientSize() * sizeof(Scalar));
+            entry.biases = offset;
+            offset = Align(offset + source.Size() * sizeof(Scalar));
+            
+            table.push_back(entry);
+        }
+    }
+    
+    std::vector<char> file(offset, 0);
+    Header header = { };
+    
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.byte_order = kByteOrder;
+    header.version = kVersion;
+    header.type = static_cast<uint32_t>(type);
+    header.scalar_size = sizeof(Scalar);
+    header.networks = static_cast<uint32_t>(layers.size());
+    header.layers = static_cast<uint32_t>(layers.front().size());
+    header.bytes = offset;
+    
+    memcpy(file.data() + sizeof(Header), table.data(), table.size() * sizeof(LayerEntry));
+    
+    for (size_t network = 0, index = 0 ; network < layers.size() ; network++) {
+        
+        for (size_t layer = 0 ; layer < layers[network].size() ; layer++, index++) {
+            
+            const Layer<Scalar>& source = *layers[network][layer];
+            
+            memcpy(file.data() + table[index].weights, source.Weights(), source.GradientSize() * sizeof(Scalar));
+            memcpy(file.data() + table[index].biases, source.Biases(), source.Size() * sizeof(Scalar));
+        }
+    }
+    
+    header.checksum = Checksum(file.data() + sizeof(Header), file.size() - sizeof(Header));
+    memcpy(file.data(), &header, sizeof(Header));
+    
+    return static_cast<bool>(output.write(file.data(), file.size()));
+}
+
+template std::vector<std::unique_ptr<BasicNetwork<double> > > ModelFile::Networks<double>();
+template std::vector<std::unique_ptr<BasicNetwork<float> > > ModelFile::Networks<float>();
+template bool ModelFile::Write<double>(std::ostream&, OperationalNetwork::Type, const std::vector<const BasicNetwork<double>*>&);
+template bool ModelFile::Write<float>(std::ostream&, OperationalNetwork::Type, const std::vector<const BasicNetwork<float>*>&);
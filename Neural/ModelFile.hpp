@@ -0,0 +1,107 @@
+//
+//  ModelFile.hpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#ifndef ModelFile_hpp
+#define ModelFile_hpp
+#include "Definitions.h"
+#include "OperationalNetwork.hpp"
+#include "Network.hpp"
+#include <string>
+#include <vector>
+#include <memory>
+#include <ostream>
+NAMESPACE_NEURAL_BEGIN
+
+/**
+ * A network saved in the binary form, mapped into memory.
+ *
+ * The file begins with a header of a cache line: a magic string, the
+ * byte order and version of the format, the type of the network, the
+ * size of it's scalar type, the number of networks (10 for the
+ * seperated type) and of layers in each, and a checksum of everything
+ * after the header. A table follows with the sizes, layout, activation
+ * and learning constant of every layer, and the offsets of it's
+ * weights and biases. The weights of every layer are a single block
+ * that is laid out exactly as 'Layer' stores them, on a cache line
+ * boundary, so that the layers use the mapped pages as they are.
+ *
+ * The file is mapped privately, so every process that loads the same
+ * file shares the physical pages. A network that trains after it was
+ * loaded gets a private copy of only the pages that it changes.
+ */
+class ModelFile : public std::enable_shared_from_this<ModelFile> {
+public:
+    
+    /**
+     * Returns true if the file begins as a binary model.
+     *
+     * @param path  The path to the file.
+     * @return True if the file has the magic string of the format.
+     */
+    static bool Recognize(const std::string& path);
+    
+    /**
+     * Maps a binary model and validates it's header, table and checksum.
+     *
+     * @param path  The path to the file.
+     * @return The mapped file, or NULL if it could not be mapped or is
+     *         not a valid model.
+     */
+    static std::shared_ptr<ModelFile> Open(const std::string& path);
+    
+    /**
+     * Writes networks in the binary form.
+     *
+     * @param output    The stream to write to.
+     * @param type      The type of the network.
+     * @param networks  The networks, all of the same depth.
+     * @return True if the file was written.
+     */
+    template <typename Scalar>
+    static bool Write(std::ostream& output, OperationalNetwork::Type type, const std::vector<const BasicNetwork<Scalar>*>& networks);
+    
+    /**
+     * Returns the type of the network in the file.
+     *
+     * @return The type.
+     */
+    OperationalNetwork::Type Type() const;
+    
+    /**
+     * Returns the precision of the weights in the file.
+     *
+     * @return The precision.
+     */
+    OperationalNetwork::Precision Precision() const;
+    
+    /**
+     * Creates the networks of the file, whose layers use the mapped
+     * weights and keep the file mapped for as long as they exist.
+     * The scalar type must be that of 'Precision()'.
+     *
+     * @return The networks, by order.
+     */
+    template <typename Scalar>
+    std::vector<std::unique_ptr<BasicNetwork<Scalar> > > Networks();
+    
+    /**
+     * Destructor. Unmaps the file.
+     */
+    ~ModelFile();
+    
+private:
+    
+    ModelFile();
+    
+    class Impl;
+    std::unique_ptr<Impl> m_pimpl;
+    
+};
+
+NAMESPACE_NEURAL_END
+#endif /* ModelFile_hpp */
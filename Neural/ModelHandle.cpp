@@ -0,0 +1,229 @@
+//
+//  ModelHandle.cpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#include "ModelHandle.hpp"
+#include "OperationalNetwork.hpp"
+#include "AlignedAllocator.hpp"
+#include <vector>
+#include <mutex>
+#include <algorithm>
+
+using namespace neural;
+
+/**
+ * Implementation.
+ */
+class ModelHandle::Impl {
+public:
+    
+    /**
+     * Constructor.
+     *
+     * @param network   The first version of the network.
+     * @param readers   The number of threads that read the network.
+     */
+    Impl(std::unique_ptr<OperationalNetwork> network, size_t readers);
+    
+    /**
+     * Returns a snapshot of the current version.
+     *
+     * @param reader    The index of the calling reader.
+     * @return The snapshot.
+     */
+    Snapshot Read(size_t reader);
+    
+    /**
+     * Replaces the current version.
+     *
+     * @param network   The new version of the network.
+     * @return The number of the new version.
+     */
+    size_t Publish(std::unique_ptr<OperationalNetwork> network);
+    
+    /**
+     * Returns the number of the current version.
+     *
+     * @return The number of the version.
+     */
+    size_t Version() const { return m_version.load(std::memory_order_acquire); }
+    
+    /**
+     * Destructor.
+     */
+    ~Impl();
+    
+private:
+    
+    /**
+     * A version of the network.
+     */
+    struct Model {
+        
+        ///The network
+        std::unique_ptr<const OperationalNetwork> network;
+        
+        ///The number of the version
+        size_t number;
+        
+        ///The epoch in which the version was replaced, 0 while it is current
+        uint64_t retired;
+    };
+    
+    /**
+     * The mark of a reader, on a cache line of it's own so that the
+     * readers do not slow each other down.
+     */
+    struct alignas(NEURAL_ALIGNMENT) Mark {
+        
+        ///The epoch in which the reader took it's snapshot, 0 when it holds none
+        std::atomic<uint64_t> epoch;
+        
+        Mark() : epoch(0) { }
+    };
+    
+    /**
+     * Destroys the replaced versions that no reader can hold anymore.
+     * Must be called with the publishing lock held.
+     */
+    void Reclaim();
+    
+    ///Stores the current version
+    std::atomic<Model*> m_current;
+    
+    ///Stores the number of the current version, read without a snapshot
+    std::atomic<size_t> m_version;
+    
+    ///Stores the current epoch, which every 'Publish' advances
+    std::atomic<uint64_t> m_epoch;
+    
+    ///Stores the mark of every reader
+    AlignedVector<Mark> m_marks;
+    
+    ///Stores the replaced versions that may still be held
+    std::vector<Model*> m_retired;
+    
+    ///Guards the publishing of versions
+    std::mutex m_publish_mutex;
+    
+};
+
+#pragma mark - Implementation
+
+ModelHandle::Impl::Impl(std::unique_ptr<OperationalNetwork> network, size_t readers) :
+m_current(new Model{ std::move(network), 1, 0 }),
+m_version(1),
+m_epoch(1),
+m_marks(std::max<size_t>(readers, 1))
+{ }
+
+ModelHandle::Impl::~Impl() {
+    
+    for (size_t index = 0 ; index < m_retired.size() ; index++)
+        delete m_retired[index];
+    
+    delete m_current.load();
+}
+
+ModelHandle::Snapshot ModelHandle::Impl::Read(size_t reader) {
+    
+    std::atomic<uint64_t>& mark = m_marks[reader].epoch;
+    
+    /*
+     * The mark is set before the version is read. A writer that did not
+     * see the mark replaced the version before it was read, so the reader
+     * gets the new one. A writer that saw it keeps every version that was
+     * replaced after the marked epoch.
+     */
+    mark.store(m_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+    Model* version = m_current.load(std::memory_order_seq_cst);
+    
+    return Snapshot(version->network.get(), version->number, &mark);
+}
+
+size_t ModelHandle::Impl::Publish(std::unique_ptr<OperationalNetwork> network) {
+    
+    std::lock_guard<std::mutex> lock(m_publish_mutex);
+    
+    size_t number = m_version.load(std::memory_order_relaxed) + 1;
+    Model* old = m_current.exchange(new Model{ std::move(network), number, 0 }, std::memory_order_seq_cst);
+    m_version.store(number, std::memory_order_release);
+    
+    //Readers that mark the new epoch read the new version
+    old->retired = m_epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+    m_retired.push_back(old);
+    
+    Reclaim();
+    return number;
+}
+
+void ModelHandle::Impl::Reclaim() {
+    
+    //The oldest epoch that a reader is in, readers before it are done
+    uint64_t oldest = m_epoch.load(std::memory_order_seq_cst);
+    
+    for (size_t reader = 0, total = m_marks.size() ; reader < total ; reader++) {
+        
+        uint64_t epoch = m_marks[reader].epoch.load(std::memory_order_seq_cst);
+        
+        if (epoch != 0)
+            oldest = std::min(oldest, epoch);
+    }
+    
+    //A version that was replaced by the oldest epoch can not be held
+    auto reclaimed = std::partition(m_retired.begin(), m_retired.end(), [oldest](const Model* version) {
+        return version->retired > oldest;
+    });
+    
+    for (auto version = reclaimed ; version != m_retired.end() ; version++)
+        delete *version;
+    
+    m_retired.erase(reclaimed, m_retired.end());
+}
+
+#pragma mark - Snapshot functions
+
+ModelHandle::Snapshot::Snapshot(const OperationalNetwork* network, size_t version, std::atomic<uint64_t>* mark) :
+m_network(network),
+m_version(version),
+m_mark(mark)
+{ }
+
+ModelHandle::Snapshot::Snapshot(Snapshot&& other) :
+m_network(other.m_network),
+m_version(other.m_version),
+m_mark(other.m_mark) {
+    
+    other.m_mark = NULL;
+}
+
+ModelHandle::Snapshot::~Snapshot() {
+    
+    //Everything that the reader did with the version happens before the release
+    if (m_mark)
+        m_mark->store(0, std::memory_order_release);
+}
+
+#pragma mark - ModelHandle functions
+
+ModelHandle::ModelHandle(std::unique_ptr<OperationalNetwork> network, size_t readers) :
+m_pimpl(new Impl(std::move(network), readers))
+{ }
+
+ModelHandle::~ModelHandle() { };
+
+ModelHandle::Snapshot ModelHandle::Read(size_t reader) const {
+    return m_pimpl->Read(reader);
+}
+
+size_t ModelHandle::Publish(std::unique_ptr<OperationalNetwork> network) {
+    return m_pimpl->Publish(std::move(network));
+}
+
+size_t ModelHandle::Version() const {
+    return m_pimpl->Version();
+}
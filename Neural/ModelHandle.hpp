@@ -0,0 +1,149 @@
+//
+//  ModelHandle.hpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#ifndef ModelHandle_hpp
+#define ModelHandle_hpp
+#include "Definitions.h"
+#include <memory>
+#include <atomic>
+#include <stdint.h>
+NAMESPACE_NEURAL_BEGIN
+class OperationalNetwork;
+
+/**
+ * Holds the current version of a network that is read by several
+ * threads while another thread replaces it (read-copy-update). A
+ * reader takes a snapshot of the current version without locks and
+ * in a fixed number of steps, no matter what the other threads do, and
+ * uses it for as long as it holds the snapshot. 'Publish' switches the
+ * readers to a new version at once, and the old version is destroyed
+ * once the last snapshot of it is released.
+ *
+ * Every reader thread has an index of it's own, which marks the
+ * version that it reads. The writer checks these marks to find the
+ * old versions that no reader can still hold.
+ */
+class ModelHandle {
+public:
+    
+    /**
+     * A version of the network as it was when it was read. The
+     * version stays alive at least until the snapshot is destroyed.
+     */
+    class Snapshot {
+    public:
+        
+        /**
+         * Constructor. Takes over the snapshot of another.
+         *
+         * @param other     The snapshot to take over.
+         */
+        Snapshot(Snapshot&& other);
+        
+        /**
+         * Destructor. Releases the version.
+         */
+        ~Snapshot();
+        
+        /**
+         * Returns the network of the version.
+         *
+         * @return The network.
+         */
+        const OperationalNetwork& operator*() const { return *m_network; }
+        
+        /**
+         * Returns the network of the version.
+         *
+         * @return The network.
+         */
+        const OperationalNetwork* operator->() const { return m_network; }
+        
+        /**
+         * Returns the number of the version, starting with 1.
+         *
+         * @return The number of the version.
+         */
+        size_t Version() const { return m_version; }
+        
+    private:
+        
+        friend class ModelHandle;
+        
+        /**
+         * Constructor.
+         *
+         * @param network   The network of the version.
+         * @param version   The number of the version.
+         * @param mark      The mark of the reader, cleared on release.
+         */
+        Snapshot(const OperationalNetwork* network, size_t version, std::atomic<uint64_t>* mark);
+        
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        
+        ///Stores the network of the version
+        const OperationalNetwork* m_network;
+        
+        ///Stores the number of the version
+        size_t m_version;
+        
+        ///Stores the mark of the reader, NULL once taken over
+        std::atomic<uint64_t>* m_mark;
+        
+    };
+    
+    /**
+     * Constructor.
+     *
+     * @param network   The first version of the network.
+     * @param readers   The number of threads that read the network.
+     */
+    ModelHandle(std::unique_ptr<OperationalNetwork> network, size_t readers);
+    
+    /**
+     * Returns a snapshot of the current version. A reader holds a single
+     * snapshot at a time, and must release it before it reads again.
+     *
+     * @param reader    The index of the calling reader, every thread must use it's own.
+     * @return The snapshot.
+     */
+    Snapshot Read(size_t reader) const;
+    
+    /**
+     * Replaces the current version, so that every 'Read' from now on
+     * returns the given network. The old versions that no reader holds
+     * anymore are destroyed on the calling thread, the rest on a later
+     * call. Calls from several threads are handled one at a time.
+     *
+     * @param network   The new version of the network.
+     * @return The number of the new version.
+     */
+    size_t Publish(std::unique_ptr<OperationalNetwork> network);
+    
+    /**
+     * Returns the number of the current version.
+     *
+     * @return The number of the version.
+     */
+    size_t Version() const;
+    
+    /**
+     * Destructor. No reader may hold a snapshot.
+     */
+    ~ModelHandle();
+    
+private:
+    
+    class Impl;
+    std::unique_ptr<Impl> m_pimpl;
+    
+};
+
+NAMESPACE_NEURAL_END
+#endif /* ModelHandle_hpp */
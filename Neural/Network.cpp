@@ -7,18 +7,28 @@
 //
 
 #include "Network.hpp"
-#include "Perceptron.hpp"
+#include "Layer.hpp"
 #include "Data.hpp"
+#include "Kernels.hpp"
+#include "Workspace.hpp"
+#include "ThreadPool.hpp"
+#include "SpscQueue.hpp"
+#include <chrono>
 #include <vector>
 #include <string>
 #include <sstream>
+#include <algorithm>
 
 using namespace neural;
 
+///The number of micro-batches that a batch is split into for every stage of a pipeline
+static const size_t kMicroBatchesPerStage = 4;
+
 /**
  * Implementation.
  */
-class Network::Impl {
+template <typename Scalar>
+class BasicNetwork<Scalar>::Impl {
 public:
     
     
@@ -26,53 +36,180 @@ public:
      * Constructor.
      *
      * @param perceptrons   Number of perceptrons in the starting layer.
+     * @param activation    The activation function of the layer.
      * @param previous      The previous network that the new one is connected to.
      */
-    Impl(size_t perceptrons, Network::Impl* previous = NULL);
+    Impl(size_t perceptrons, ActivationType activation, Impl* previous = NULL);
     
     /**
      * Constructor.
+     * Chains a network for the layer at the index and every layer after it.
      *
-     * @param The serialized string that was given from a network.
+     * @param layers        The layers, which are moved into the networks.
+     * @param index         The index of the layer of the new network.
+     * @param previous      The previous network that the new one is connected to.
      */
-    Impl(const std::string& serialized);
+    Impl(std::vector<Layer<Scalar> >& layers, size_t index, Impl* previous = NULL);
     
     /**
      * Adds a network to the last network in the chained networks.
      *
      * @param perceptrons   The number of perceptrons that the added network
      *                      will have.
+     * @param activation    The activation function of the added network.
+     */
+    void AddNetwork(size_t perceptrons, ActivationType activation);
+    
+    /**
+     * Sizes the buffers of the workspace to fit the network. Buffers
+     * that already fit are left as they are, so this does not allocate
+     * once the workspace has been used with the same network.
+     *
+     * @param workspace     The workspace to prepare.
+     * @param count         The number of records that will be processed at once.
+     * @param gradients     True to also size the sums of the updates.
+     */
+    void Prepare(Workspace<Scalar>& workspace, size_t count = 1, bool gradients = false) const;
+    
+    /**
+     * Declares if the data that is given to the network is binary.
+     *
+     * @param binary    True if the data is binary.
+     */
+    void SetBinaryInput(bool binary);
+    
+    /**
+     * Chooses between the exact sigmoid and a fast approximation
+     * in the network and the networks after it.
+     *
+     * @param fast  True to use the approximation.
+     */
+    void SetFastActivation(bool fast);
+    
+    /**
+     * Splits the work of the network and the networks after it
+     * between the threads of a pool.
+     *
+     * @param pool  The pool to use, or NULL.
+     */
+    void SetThreadPool(ThreadPool* pool);
+    
+    /**
+     * Returns the set values of a record if the layer can use them.
+     *
+     * @param data  The record.
+     * @return The set values, or NULL if the record should be read as is.
      */
-    void AddNetwork(size_t perceptrons);
+    const std::vector<uint32_t>* Active(const Data& data) const;
     
     /**
-     * Gets a data to process and returns the result.
+     * Gets results from a previous layer to continue calculating.
      *
-     * @param data  The data to process.
+     * @param input     The input of the layer.
+     * @param active    The set values of a binary input, or NULL.
+     * @param buffers   The buffers of the layer in the workspace.
      * @return A vector containing all of the last layer's results
      */
-    std::vector<double> Feed(const Data& data) const;
+    const std::vector<Scalar>& Feed(const Scalar* input, const std::vector<uint32_t>* active, typename Workspace<Scalar>::Buffers* buffers) const;
     
     /**
-     * Gets results from a previous run to continue calculating
+     * Processes a batch of records that were not read by any layer yet.
      *
-     * @param data  The data to process.
-     * @return A vector containing all of the layer's results
+     * @param data          The records to process.
+     * @param workspace     The workspace, prepared for the batch.
+     * @return A vector containing all of the last layer's results, a row per record.
      */
-    std::vector<double> Feed(const std::vector<double>& data) const;
-
+    const std::vector<Scalar>& FeedBatch(const std::vector<Data>& data, Workspace<Scalar>& workspace) const;
+    
     /**
-     * Trains the neural network to comply to a given result.
+     * Gets a batch of results from a previous layer to continue calculating.
      *
-     * @param data      The data to practice on.
+     * @param inputs    The inputs of the layer, a row per record.
+     * @param count     The number of records in the batch.
+     * @param buffers   The buffers of the layer in the workspace.
+     * @return A vector containing all of the last layer's results, a row per record.
+     */
+    const std::vector<Scalar>& FeedBatch(const Scalar* inputs, size_t count, typename Workspace<Scalar>::Buffers* buffers) const;
+    
+    /**
+     * Trains the neural network to comply to a given result. The
+     * activations of every layer are recorded once in the workspace
+     * and are then read by the back propogation.
+     *
+     * @param input     The input of the layer.
+     * @param active    The set values of a binary input, or NULL.
      * @param target    The values that the network should reach.
+     * @param buffers   The buffers of the layer in the workspace.
      */
-    void Train(const Data& data, const Data& target);
+    void Train(const Scalar* input, const std::vector<uint32_t>* active, const Data& target, typename Workspace<Scalar>::Buffers* buffers);
     
     /**
-     * Trains the neural network and returns the delta's that were created.
+     * Trains the neural network on a batch of records at once. The
+     * updates are summed and applied the same as in a pipeline, so the
+     * results do not depend on whether the network is pipelined.
+     *
+     * @param data          The records to practice on.
+     * @param targets       The values that the network should reach per record.
+     * @param workspace     The workspace to hold the batch.
      */
-    std::vector<double> Train(const std::vector<double>& data, const Data& target);
+    void TrainBatch(const std::vector<Data>& data, const std::vector<Data>& targets, Workspace<Scalar>& workspace);
+    
+    /**
+     * Trains the neural network on a batch of records that is split
+     * between the threads of a pool, with a single update at the end.
+     *
+     * @param data          The records to practice on.
+     * @param targets       The values that the network should reach per record.
+     * @param workspaces    A workspace per thread of the pool.
+     * @param pool          The threads that share the records.
+     */
+    void TrainBatch(const std::vector<Data>& data, const std::vector<Data>& targets, Workspace<Scalar>* workspaces, ThreadPool& pool);
+    
+    /**
+     * Finds the sums of the updates that a batch would make to the
+     * layer and the layers after it, without applying them. The errors
+     * of the layer's inputs are written to the previous layer's buffers.
+     *
+     * @param inputs    The inputs of the layer, a row per record.
+     * @param count     The number of records in the batch, may be 0.
+     * @param targets   The values that the network should reach, one per record.
+     * @param buffers   The buffers of the layer in the workspace.
+     */
+    void Gradients(const Scalar* inputs, size_t count, const Data* targets, typename Workspace<Scalar>::Buffers* buffers);
+    
+    /**
+     * Trains the neural network on a batch of records that flows through
+     * the stages of a pipeline in micro-batches (see 'SetPipelineStages').
+     *
+     * @param data          The records to practice on.
+     * @param targets       The values that the network should reach per record.
+     * @param pipeline      The stages of the pipeline.
+     */
+    void TrainBatch(const std::vector<Data>& data, const std::vector<Data>& targets, Pipeline& pipeline);
+    
+    /**
+     * Finds the deltas of the layer for some rows of a batch whose outputs
+     * (and errors, unless it is the output layer) are known, propogates
+     * them to the errors of the previous layer, and sums the updates.
+     *
+     * @param inputs        The inputs of the rows, a row per record.
+     * @param row           The first row.
+     * @param count         The number of rows.
+     * @param targets       The values that the network should reach, one per record of the batch.
+     * @param buffers       The buffers of the layer in the workspace.
+     * @param accumulate    True to add the updates to the sums that are already there.
+     */
+    void Backward(const Scalar* inputs, size_t row, size_t count, const Data* targets, typename Workspace<Scalar>::Buffers* buffers, bool accumulate);
+    
+    /**
+     * Splits the layer and the layers after it into contiguous stages
+     * of about the same work, every stage with at least one layer.
+     *
+     * @param stages    The number of stages, reduced to the number of layers.
+     * @return The index of the first layer of every stage, followed by
+     *         the number of layers.
+     */
+    std::vector<size_t> Partition(size_t stages) const;
     
     /**
      * Recieves the delta results from the next layer and
@@ -82,15 +219,7 @@ public:
      *
      * @param deltas    The delta results per each perceptron from the next layer.
      */
-    void BackPropogate(std::vector<double>& deltas);
-    
-    /**
-     * Return the result for the given data.
-     *
-     * @param data  The data to work on.
-     * @return The result from every perceptron.
-     */
-    std::vector<double> Sum(const std::vector<double>& data) const;
+    void BackPropogate(std::vector<Scalar>& deltas);
     
     /**
      * Outputs the network into a format that can later
@@ -101,6 +230,43 @@ public:
      */
     std::string Serialize() const;
     
+    /**
+     * Returns the memory that the weights and biases of the
+     * network and the networks after it occupy.
+     *
+     * @return The size in bytes.
+     */
+    size_t Bytes() const;
+    
+    /**
+     * Returns the number of weights and biases of the layer and the
+     * layers after it.
+     *
+     * @return The number of parameters.
+     */
+    size_t Parameters() const;
+    
+    /**
+     * Copies the weights and biases of the layer and the layers after it.
+     *
+     * @param parameters    Receives 'Parameters()' values.
+     */
+    void ExportParameters(double* parameters) const;
+    
+    /**
+     * Replaces the weights and biases of the layer and the layers after it.
+     *
+     * @param parameters    The 'Parameters()' values.
+     */
+    void ImportParameters(const double* parameters);
+    
+    /**
+     * Adds the layer of the network and the layers after it.
+     *
+     * @param layers    Receives the layers, by order.
+     */
+    void Layers(std::vector<const Layer<Scalar>*>& layers) const;
+    
     /**
      * Destructor.
      */
@@ -108,172 +274,555 @@ public:
     
 private:
     
-    ///Stores all the perceptrons in the network
-    std::vector<std::unique_ptr<Perceptron>> m_perceptrons;
+    ///Stores the weights of all the perceptrons in the network
+    Layer<Scalar> m_layer;
     
     ///Stores the next network to propogate signals to
-    Network::Impl* m_next;
+    Impl* m_next;
     
     ///Stores the previous network to back propogate errors to
-    Network::Impl* m_previous;
+    Impl* m_previous;
     
 };
 
+/**
+ * Returns the values of a record in the scalar type of the network.
+ * A network of doubles reads the record as is.
+ *
+ * @param data          The record.
+ * @param workspace     The workspace of the network.
+ * @return The values of the record.
+ */
+static const double* Input(const Data& data, Workspace<double>& /*workspace*/) {
+    return data.content.data();
+}
+
+/**
+ * Returns the values of a record in the scalar type of the network.
+ * Any other network converts the record into the workspace.
+ *
+ * @param data          The record.
+ * @param workspace     The workspace of the network.
+ * @return The values of the record.
+ */
+template <typename Scalar>
+static const Scalar* Input(const Data& data, Workspace<Scalar>& workspace) {
+    
+    workspace.inputs.assign(data.content.begin(), data.content.end());
+    return workspace.inputs.data();
+}
+
+/**
+ * Returns the learning constant of a layer. The sigmoid keeps the
+ * original rate, while the activations that are not bounded (or not
+ * flat at their ends) take far larger steps through deep networks
+ * and need a smaller one.
+ *
+ * @param activation    The activation function of the layer.
+ * @return The learning constant.
+ */
+static double LearningConstant(ActivationType activation) {
+    return (activation == ActivationType::kSigmoid) ? 0.25 : 0.005;
+}
+
+/**
+ * Returns the starting bias of a layer. A bias of 1 would keep every
+ * ReLU perceptron active at first, so only the sigmoid starts with it.
+ *
+ * @param activation    The activation function of the layer.
+ * @return The starting bias.
+ */
+static double StartingBias(ActivationType activation) {
+    return (activation == ActivationType::kSigmoid) ? 1.0 : 0.0;
+}
+
 #pragma mark - Implementation
 
-Network::Impl::Impl(size_t perceptrons, Network::Impl* previous) :
+template <typename Scalar>
+BasicNetwork<Scalar>::Impl::Impl(size_t perceptrons, ActivationType activation, Impl* previous) :
+//Have weight for every 'pixel' in the data or be able to process all the output from previous layer
+m_layer(perceptrons, (previous) ? previous->m_layer.Size() : 784, LearningConstant(activation), StartingBias(activation), activation),
+m_next(NULL),
+m_previous(previous)
+{ }
+
+template <typename Scalar>
+BasicNetwork<Scalar>::Impl::Impl(std::vector<Layer<Scalar> >& layers, size_t index, Impl* previous) :
+m_layer(std::move(layers[index])),
 m_next(NULL),
 m_previous(previous) {
     
+    if (index + 1 < layers.size())
+        m_next = new Impl(layers, index + 1, this);
+}
 
-    //Create the perceptrons that are going to handle the data
-    for (size_t index = 0 ; index < perceptrons ; index++) {
-        
-        //Have weight for every 'pixel' in the data or be able to process all the output from previous layer
-        size_t number_of_connections = (m_previous) ? m_previous->m_perceptrons.size() : 784;
-        
-        m_perceptrons.push_back(std::unique_ptr<Perceptron>(new Perceptron(number_of_connections, 0.25)));
-    }
+template <typename Scalar>
+BasicNetwork<Scalar>::Impl::~Impl() {
+    
+    //Propogate deletion across the linked networks
+    if (m_next)
+        delete m_next;
 }
 
-Network::Impl::Impl(const std::string& serialized) :
-m_next(NULL),
-m_previous(NULL) {
+template <typename Scalar>
+void BasicNetwork<Scalar>::Impl::AddNetwork(size_t perceptrons, ActivationType activation) {
     
-    //Deserialize the input manually for networks
-    std::stringstream string_stream(serialized);
+    if (m_next)     m_next->AddNetwork(perceptrons, activation);
+    else            m_next = new Impl(perceptrons, activation, this);
+}
+
+
+template <typename Scalar>
+void BasicNetwork<Scalar>::Impl::Prepare(Workspace<Scalar>& workspace, size_t count, bool gradients) const {
     
-    std::string read_line;
-    std::getline(string_stream, read_line);
-    size_t network_size = std::stoul(read_line);
+    size_t depth = 0;
+    for (const Impl* layer = this ; layer ; layer = layer->m_next)
+        depth++;
     
-    for (size_t index = 0 ; index < network_size ; index++) {
-        
-        std::getline(string_stream, read_line);
-        m_perceptrons.push_back(std::unique_ptr<Perceptron>(new Perceptron(read_line)));
-        
-    }
+    if (workspace.layers.size() != depth)
+        workspace.layers.resize(depth);
     
-    /*
-     * Cut the serialized string away and send the rest to the next network.
-     * A good implementation should use string iterators to avoid copying
-     * but not done since this is outside of the home work's scope.
-     */
-    std::string next_network = serialized.substr(string_stream.tellg());
+    typename Workspace<Scalar>::Buffers* buffers = workspace.layers.data();
     
-    if (!next_network.empty()) {
+    for (const Impl* layer = this ; layer ; layer = layer->m_next, buffers++) {
+        
+        size_t size = count * layer->m_layer.Size();
+        
+        buffers->outputs.resize(size);
+        buffers->deltas.resize(size);
+        buffers->errors.resize(size);
         
-        m_next = new Network::Impl(next_network);
-        m_next->m_previous = this;
+        if (gradients) {
+            
+            buffers->weights_gradient.resize(layer->m_layer.GradientSize());
+            buffers->biases_gradient.resize(layer->m_layer.Size());
+        }
     }
 }
 
-Network::Impl::~Impl() {
+template <typename Scalar>
+void BasicNetwork<Scalar>::Impl::SetBinaryInput(bool binary) {
     
-    //Propogate deletion across the linked networks
-    if (m_next)
-        delete m_next;
+    //Only the first layer sees the data, the rest see activations
+    m_layer.SetInputMajor(binary);
 }
 
-void Network::Impl::AddNetwork(size_t perceptrons) {
+template <typename Scalar>
+void BasicNetwork<Scalar>::Impl::SetFastActivation(bool fast) {
     
-    if (m_next)     m_next->AddNetwork(perceptrons);
-    else            m_next = new Impl(perceptrons, this);
+    m_layer.SetFastActivation(fast);
+    
+    if (m_next)
+        m_next->SetFastActivation(fast);
 }
 
+template <typename Scalar>
+void BasicNetwork<Scalar>::Impl::SetThreadPool(ThreadPool* pool) {
+    
+    m_layer.SetThreadPool(pool);
+    
+    if (m_next)
+        m_next->SetThreadPool(pool);
+}
 
-std::vector<double> Network::Impl::Feed(const Data& data) const {
-    return Feed(data.content);
+template <typename Scalar>
+const std::vector<uint32_t>* BasicNetwork<Scalar>::Impl::Active(const Data& data) const {
+    
+    //The set values are only worth it when the weights are laid by input
+    return (m_layer.InputMajor() && !data.active.empty()) ? &data.active : NULL;
 }
 
-std::vector<double> Network::Impl::Feed(const std::vector<double> &data) const {
+template <typename Scalar>
+const std::vector<Scalar>& BasicNetwork<Scalar>::Impl::Feed(const Scalar* input, const std::vector<uint32_t>* active, typename Workspace<Scalar>::Buffers* buffers) const {
     
     /*
      * This function is invoked from an outside call only on the first
      * layer. Thus, the input mush be a read from file. The contents must
      * be processed and then sent to the next layer.
      */
+    if (active)     m_layer.FeedSparse(active->data(), active->size(), buffers->outputs.data());
+    else            m_layer.Feed(input, buffers->outputs.data());
     
     if (m_next)
-        return m_next->Feed(Sum(data));
+        return m_next->Feed(buffers->outputs.data(), NULL, buffers + 1);
     
     //Otherwise return the original results
-    return Sum(data);
+    return buffers->outputs;
 }
 
-std::vector<double> Network::Impl::Train(const std::vector<double>& data, const neural::Data &target) {
+template <typename Scalar>
+const std::vector<Scalar>& BasicNetwork<Scalar>::Impl::FeedBatch(const std::vector<Data>& data, Workspace<Scalar>& workspace) const {
     
-    if (m_next) {
-        
-        //Hidden layer
-        std::vector<double> deltas = m_next->Train(Sum(data), target);
-        std::vector<double> current_deltas;
-        current_deltas.reserve(m_perceptrons.size());
+    size_t count = data.size();
+    size_t total = m_layer.Size();
+    typename Workspace<Scalar>::Buffers* buffers = workspace.layers.data();
+    
+    if (m_layer.InputMajor()) {
         
-        for (size_t index = 0, total = m_perceptrons.size() ; index < total ; index++) {
-            
-            double output = m_perceptrons[index]->Feed(data);
+        //Records that list their set values only add the rows of those values, a record at a time
+        for (size_t record = 0 ; record < count ; record++) {
             
-            //Find the sum of the deltas multiplied by their relative weights
-            double delta_sum = 0.0;
-            for (size_t delta_index = 0, delta_total = deltas.size(); delta_index < delta_total ; delta_index++)
-                delta_sum += deltas[delta_index] * m_next->m_perceptrons[delta_index]->m_weights[index];
+            const std::vector<uint32_t>* active = Active(data[record]);
+            Scalar* outputs = buffers->outputs.data() + record * total;
             
-            double delta = output * (1.0 - output) * delta_sum;
-            m_perceptrons[index]->Train(delta, data);
-            current_deltas.push_back(delta);
+            if (active)     m_layer.FeedSparse(active->data(), active->size(), outputs);
+            else            m_layer.Feed(Input(data[record], workspace), outputs);
         }
-   
-        return current_deltas;
+    }
+    else {
         
+        //Lay the records one after the other so that the batch is a single matrix
+        size_t connections = m_layer.Connections();
+        workspace.inputs.resize(count * connections);
+        
+        for (size_t record = 0 ; record < count ; record++)
+            std::copy(data[record].content.begin(),
+                      data[record].content.begin() + connections,
+                      workspace.inputs.begin() + record * connections);
+        
+        m_layer.FeedBatch(workspace.inputs.data(), count, buffers->outputs.data());
     }
-    else if (m_previous) {
+    
+    if (m_next)
+        return m_next->FeedBatch(buffers->outputs.data(), count, buffers + 1);
+    
+    return buffers->outputs;
+}
+
+template <typename Scalar>
+const std::vector<Scalar>& BasicNetwork<Scalar>::Impl::FeedBatch(const Scalar* inputs, size_t count, typename Workspace<Scalar>::Buffers* buffers) const {
+    
+    m_layer.FeedBatch(inputs, count, buffers->outputs.data());
+    
+    if (m_next)
+        return m_next->FeedBatch(buffers->outputs.data(), count, buffers + 1);
+    
+    return buffers->outputs;
+}
+
+template <typename Scalar>
+void BasicNetwork<Scalar>::Impl::Train(const Scalar* input, const std::vector<uint32_t>* active, const neural::Data &target, typename Workspace<Scalar>::Buffers* buffers) {
+    
+    //A network without layers to connect to does not train
+    if (!m_next && !m_previous)
+        return;
+    
+    size_t total = m_layer.Size();
+    Scalar* outputs = buffers->outputs.data();
+    Scalar* errors = buffers->errors.data();
+    
+    //The activations are calculated once and kept for the back propogation
+    if (active)     m_layer.FeedSparse(active->data(), active->size(), outputs);
+    else            m_layer.Feed(input, outputs);
+    
+    if (m_next) {
+        
+        //Hidden layer
+        m_next->Train(outputs, NULL, target, buffers + 1);
+        
+        //Find the sum of the deltas multiplied by their relative weights
+        m_next->m_layer.BackPropogate(buffers[1].deltas.data(), errors);
+    }
+    else {
         
         //Output layer
-        std::vector<double> deltas;
-        deltas.reserve(m_perceptrons.size());
+        for (size_t index = 0 ; index < total ; index++)
+            errors[index] = outputs[index] - target.content[index];
+    }
+    
+    //Apply the derivative of the activation on the whole layer at once
+    Scalar* deltas = buffers->deltas.data();
+    m_layer.Derive(outputs, errors, deltas, total);
+    
+    if (active)     m_layer.TrainSparse(deltas, active->data(), active->size());
+    else            m_layer.Train(deltas, input);
+}
+
+template <typename Scalar>
+void BasicNetwork<Scalar>::Impl::TrainBatch(const std::vector<Data>& data, const std::vector<Data>& targets, Workspace<Scalar>& workspace) {
+    
+    //A network without layers to connect to does not train (same as 'Train')
+    if (data.empty() || (!m_next && !m_previous))
+        return;
+    
+    size_t total = data.size();
+    Prepare(workspace, total, true);
+    
+    //Lay the records one after the other so that the batch is a single matrix
+    size_t connections = m_layer.Connections();
+    workspace.inputs.resize(total * connections);
+    
+    for (size_t record = 0 ; record < total ; record++)
+        std::copy(data[record].content.begin(),
+                  data[record].content.begin() + connections,
+                  workspace.inputs.begin() + record * connections);
+    
+    /*
+     * The updates of all the records are summed before any of them is
+     * applied, in the order of the records, as the micro-batches of a
+     * pipeline sum them. Adding every update into the weights on it's
+     * own would round differently.
+     */
+    Gradients(workspace.inputs.data(), total, targets.data(), workspace.layers.data());
+
+    typename Workspace<Scalar>::Buffers* buffers = workspace.layers.data();
+    
+    for (Impl* layer = this ; layer ; layer = layer->m_next, buffers++) {
+    
+        layer->m_layer.ApplyWeightsGradient(buffers->weights_gradient.data(), total, 0, layer->m_layer.GradientSize());
+        layer->m_layer.ApplyBiasesGradient(buffers->biases_gradient.data(), total);
+    }
+}
+
+template <typename Scalar>
+void BasicNetwork<Scalar>::Impl::TrainBatch(const std::vector<Data>& data, const std::vector<Data>& targets, Workspace<Scalar>* workspaces, ThreadPool& pool) {
+    
+    if (data.empty() || (!m_next && !m_previous))
+        return;
+    
+    size_t workers = pool.Threads();
+    size_t total = data.size();
+    size_t connections = m_layer.Connections();
+    
+    //Every thread sums the updates of a contiguous part of the batch into it's own workspace
+    pool.Run(workers, 1, [&](size_t begin, size_t end) {
         
-        for (size_t index = 0, total = m_perceptrons.size(); index < total ; index++) {
+        for (size_t worker = begin ; worker < end ; worker++) {
+            
+            Workspace<Scalar>& workspace = workspaces[worker];
+            size_t first = total * worker / workers;
+            size_t count = total * (worker + 1) / workers - first;
+            
+            Prepare(workspace, count, true);
+            workspace.inputs.resize(count * connections);
+            
+            for (size_t record = 0 ; record < count ; record++)
+                std::copy(data[first + record].content.begin(),
+                          data[first + record].content.begin() + connections,
+                          workspace.inputs.begin() + record * connections);
             
-            double output = m_perceptrons[index]->Feed(data);
-            double delta = output * (1.0 - output) * (output - target.content[index]);
-            m_perceptrons[index]->Train(delta, data);
-            deltas.push_back(delta);
+            Gradients(workspace.inputs.data(), count, targets.data() + first, workspace.layers.data());
         }
+    });
+    
+    /*
+     * The sums are added in a fixed tree (pairs, then pairs of pairs)
+     * that only depends on the number of threads, so the results are
+     * the same on every run. The threads split the weights between
+     * them, and every thread applies the part that it added.
+     */
+    size_t depth = 0;
+    for (Impl* layer = this ; layer ; layer = layer->m_next, depth++) {
+        
+        pool.Run(layer->m_layer.GradientSize(), NEURAL_ALIGNMENT / sizeof(Scalar), [&](size_t begin, size_t end) {
+            
+            const Kernels<Scalar>& kernels = ActiveKernels<Scalar>();
+            
+            for (size_t step = 1 ; step < workers ; step *= 2)
+                for (size_t worker = 0 ; worker + step < workers ; worker += 2 * step)
+                    kernels.axpy(1.0,
+                                 workspaces[worker + step].layers[depth].weights_gradient.data() + begin,
+                                 workspaces[worker].layers[depth].weights_gradient.data() + begin,
+                                 end - begin);
+            
+            layer->m_layer.ApplyWeightsGradient(workspaces[0].layers[depth].weights_gradient.data(), total, begin, end);
+        });
+        
+        //The biases are too few to be worth splitting
+        for (size_t step = 1 ; step < workers ; step *= 2)
+            for (size_t worker = 0 ; worker + step < workers ; worker += 2 * step)
+                ActiveKernels<Scalar>().axpy(1.0,
+                                             workspaces[worker + step].layers[depth].biases_gradient.data(),
+                                             workspaces[worker].layers[depth].biases_gradient.data(),
+                                             layer->m_layer.Size());
         
-        return deltas;
+        layer->m_layer.ApplyBiasesGradient(workspaces[0].layers[depth].biases_gradient.data(), total);
     }
+}
+
+template <typename Scalar>
+void BasicNetwork<Scalar>::Impl::Gradients(const Scalar* inputs, size_t count, const Data* targets, typename Workspace<Scalar>::Buffers* buffers) {
     
-    return { };
+    m_layer.FeedBatch(inputs, count, buffers->outputs.data());
+    
+    //Hidden layer, the next layer fills the errors
+    if (m_next)
+        m_next->Gradients(buffers->outputs.data(), count, targets, buffers + 1);
+    
+    Backward(inputs, 0, count, targets, buffers, false);
 }
 
-void Network::Impl::Train(const neural::Data &data, const neural::Data &target) {
-    Train(data.content, target);
+template <typename Scalar>
+void BasicNetwork<Scalar>::Impl::Backward(const Scalar* inputs, size_t row, size_t count, const Data* targets, typename Workspace<Scalar>::Buffers* buffers, bool accumulate) {
+    
+    size_t total = m_layer.Size();
+    Scalar* outputs = buffers->outputs.data() + row * total;
+    Scalar* errors = buffers->errors.data() + row * total;
+    Scalar* deltas = buffers->deltas.data() + row * total;
+    
+    //Output layer
+    if (!m_next)
+        for (size_t record = 0 ; record < count ; record++)
+            for (size_t index = 0 ; index < total ; index++)
+                errors[record * total + index] = outputs[record * total + index] - targets[row + record].content[index];
+    
+    m_layer.Derive(outputs, errors, deltas, count * total);
+    
+    if (m_previous)
+        m_layer.BackPropogateBatch(deltas, count, buffers[-1].errors.data() + row * m_layer.Connections());
+    
+    m_layer.Gradient(deltas, inputs, count, buffers->weights_gradient.data(), buffers->biases_gradient.data(), accumulate);
 }
 
-std::vector<double> Network::Impl::Sum(const std::vector<double>& data) const {
+template <typename Scalar>
+void BasicNetwork<Scalar>::Impl::TrainBatch(const std::vector<Data>& data, const std::vector<Data>& targets, Pipeline& pipeline) {
+    
+    if (data.empty() || (!m_next && !m_previous))
+        return;
+    
+    size_t total = data.size();
+    size_t stages = pipeline.boundaries.size() - 1;
+    size_t micro_batches = std::min(total, kMicroBatchesPerStage * stages);
+    size_t connections = m_layer.Connections();
+    Workspace<Scalar>& workspace = pipeline.workspace;
+    
+    //The whole batch stays in the workspace, every micro-batch is a range of it's rows
+    Prepare(workspace, total, true);
+    workspace.inputs.resize(total * connections);
     
-    std::vector<double> results;
-    results.reserve(m_perceptrons.size());
+    for (size_t record = 0 ; record < total ; record++)
+        std::copy(data[record].content.begin(),
+                  data[record].content.begin() + connections,
+                  workspace.inputs.begin() + record * connections);
     
-    //Calculate results for the input data
-    for (size_t index = 0, total = m_perceptrons.size() ; index < total ; index++)
-        results.push_back(m_perceptrons[index]->Feed(data));
+    std::vector<Impl*> layers;
+    for (Impl* layer = this ; layer ; layer = layer->m_next)
+        layers.push_back(layer);
     
-    return results;
+    typename Workspace<Scalar>::Buffers* buffers = workspace.layers.data();
+    const Scalar* inputs = workspace.inputs.data();
+    
+    //The inputs of a layer for the rows of a micro-batch
+    auto layer_inputs = [&](size_t layer, size_t row) {
+        return (layer == 0) ? inputs + row * connections : buffers[layer - 1].outputs.data() + row * layers[layer]->m_layer.Connections();
+    };
+    
+    auto start = std::chrono::steady_clock::now();
+    
+    //The pool has a thread per stage, so every stage runs on it's own
+    pipeline.pool.Run(stages, 1, [&](size_t begin, size_t end) {
+        
+        for (size_t stage = begin ; stage < end ; stage++) {
+            
+            size_t first = pipeline.boundaries[stage];
+            size_t last = pipeline.boundaries[stage + 1];
+            bool closing = (stage + 1 == stages);
+            std::chrono::duration<double> busy(0.0);
+            
+            //Forward, the last stage turns every micro-batch back right away
+            for (size_t micro_batch = 0 ; micro_batch < micro_batches ; micro_batch++) {
+                
+                size_t index = (stage > 0) ? pipeline.forward[stage - 1]->Pop() : micro_batch;
+                size_t row = total * index / micro_batches;
+                size_t count = total * (index + 1) / micro_batches - row;
+                auto working = std::chrono::steady_clock::now();
+                
+                for (size_t layer = first ; layer < last ; layer++)
+                    layers[layer]->m_layer.FeedBatch(layer_inputs(layer, row), count, buffers[layer].outputs.data() + row * layers[layer]->m_layer.Size());
+                
+                if (closing)
+                    for (size_t layer = last ; layer-- > first ; )
+                        layers[layer]->Backward(layer_inputs(layer, row), row, count, targets.data(), buffers + layer, index > 0);
+                
+                busy += std::chrono::steady_clock::now() - working;
+                
+                if (!closing)       pipeline.forward[stage]->Push(index);
+                else if (stage > 0) pipeline.backward[stage - 1]->Push(index);
+            }
+            
+            //Backward, in the same order, so the sums are added the same as without a pipeline
+            for (size_t micro_batch = 0 ; micro_batch < micro_batches && !closing ; micro_batch++) {
+                
+                size_t index = pipeline.backward[stage]->Pop();
+                size_t row = total * index / micro_batches;
+                size_t count = total * (index + 1) / micro_batches - row;
+                auto working = std::chrono::steady_clock::now();
+                
+                for (size_t layer = last ; layer-- > first ; )
+                    layers[layer]->Backward(layer_inputs(layer, row), row, count, targets.data(), buffers + layer, index > 0);
+                
+                busy += std::chrono::steady_clock::now() - working;
+                
+                if (stage > 0)
+                    pipeline.backward[stage - 1]->Push(index);
+            }
+            
+            //No micro-batch needs the weights of the stage anymore
+            auto working = std::chrono::steady_clock::now();
+            
+            for (size_t layer = first ; layer < last ; layer++) {
+                
+                Layer<Scalar>& current = layers[layer]->m_layer;
+                current.ApplyWeightsGradient(buffers[layer].weights_gradient.data(), total, 0, current.GradientSize());
+                current.ApplyBiasesGradient(buffers[layer].biases_gradient.data(), total);
+            }
+            
+            busy += std::chrono::steady_clock::now() - working;
+            pipeline.busy[stage] += busy.count();
+        }
+    });
+    
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    pipeline.seconds += elapsed.count();
 }
 
-std::string Network::Impl::Serialize() const {
+template <typename Scalar>
+std::vector<size_t> BasicNetwork<Scalar>::Impl::Partition(size_t stages) const {
+    
+    //The work of a layer is the number of it's weights
+    std::vector<size_t> work;
+    for (const Impl* layer = this ; layer ; layer = layer->m_next)
+        work.push_back(layer->m_layer.Size() * layer->m_layer.Connections());
+    
+    size_t depth = work.size();
+    size_t total = 0;
+    
+    for (size_t layer = 0 ; layer < depth ; layer++)
+        total += work[layer];
+    
+    stages = std::max<size_t>(std::min(stages, depth), 1);
+    
+    std::vector<size_t> boundaries(1, 0);
+    size_t sum = 0;
+    
+    //A stage ends once it reaches it's share, or when the layers that are left are needed one per stage
+    for (size_t layer = 0 ; layer + 1 < depth && boundaries.size() < stages ; layer++) {
+        
+        sum += work[layer];
+        
+        if (sum * stages >= total * boundaries.size() || depth - layer - 1 == stages - boundaries.size())
+            boundaries.push_back(layer + 1);
+    }
+    
+    boundaries.push_back(depth);
+    return boundaries;
+}
+
+template <typename Scalar>
+std::string BasicNetwork<Scalar>::Impl::Serialize() const {
     
     /*
      * The current network needs to be serialized before it's
      * next layer. In this way it is possible to deserialize 
      * according to construction order.
      */
-    std::string serialized = std::to_string(static_cast<unsigned long long>(m_perceptrons.size())) + '\n';
-    for (size_t index = 0, total = m_perceptrons.size() ; index < total ; index++) {
-        serialized += m_perceptrons[index]->Serialize() + '\n';
-    }
+    std::string serialized = std::to_string(static_cast<unsigned long long>(m_layer.Size()));
+    
+    //Sigmoid layers keep the original format
+    if (m_layer.Activation() != ActivationType::kSigmoid)
+        serialized += ' ' + ActivationName(m_layer.Activation());
+    
+    serialized += '\n' + m_layer.Serialize();
     
     //Add the next layer
     if (m_next)
@@ -282,30 +831,278 @@ std::string Network::Impl::Serialize() const {
     return serialized;
 }
 
+template <typename Scalar>
+size_t BasicNetwork<Scalar>::Impl::Bytes() const {
+    return m_layer.Bytes() + ((m_next) ? m_next->Bytes() : 0);
+}
+
+template <typename Scalar>
+size_t BasicNetwork<Scalar>::Impl::Parameters() const {
+    return m_layer.Parameters() + ((m_next) ? m_next->Parameters() : 0);
+}
+
+template <typename Scalar>
+void BasicNetwork<Scalar>::Impl::Layers(std::vector<const Layer<Scalar>*>& layers) const {
+    
+    layers.push_back(&m_layer);
+    
+    if (m_next)
+        m_next->Layers(layers);
+}
+
+template <typename Scalar>
+void BasicNetwork<Scalar>::Impl::ExportParameters(double* parameters) const {
+    
+    //Same order as 'Serialize', the layer before the next one
+    m_layer.ExportParameters(parameters);
+    
+    if (m_next)
+        m_next->ExportParameters(parameters + m_layer.Parameters());
+}
+
+template <typename Scalar>
+void BasicNetwork<Scalar>::Impl::ImportParameters(const double* parameters) {
+    
+    m_layer.ImportParameters(parameters);
+    
+    if (m_next)
+        m_next->ImportParameters(parameters + m_layer.Parameters());
+}
+
+#pragma mark - Pipeline
+
+/**
+ * The threads, queues and buffers of a pipelined network.
+ */
+template <typename Scalar>
+class BasicNetwork<Scalar>::Pipeline {
+public:
+    
+    /**
+     * Constructor.
+     *
+     * @param boundaries    The index of the first layer of every stage, followed by the number of layers.
+     */
+    Pipeline(const std::vector<size_t>& boundaries) :
+    pool(boundaries.size() - 1),
+    boundaries(boundaries),
+    busy(boundaries.size() - 1, 0.0),
+    seconds(0.0) {
+        
+        //A queue can hold all the micro-batches of a batch, so no stage waits for room
+        for (size_t stage = 0 ; stage + 1 < boundaries.size() ; stage++) {
+            
+            forward.push_back(std::unique_ptr<SpscQueue<size_t> >(new SpscQueue<size_t>(kMicroBatchesPerStage * busy.size())));
+            backward.push_back(std::unique_ptr<SpscQueue<size_t> >(new SpscQueue<size_t>(kMicroBatchesPerStage * busy.size())));
+        }
+    }
+    
+    ///Stores a thread per stage
+    ThreadPool pool;
+    
+    ///Stores the index of the first layer of every stage, followed by the number of layers
+    std::vector<size_t> boundaries;
+    
+    ///Stores the queues of the micro-batches that go from every stage to the next
+    std::vector<std::unique_ptr<SpscQueue<size_t> > > forward;
+    
+    ///Stores the queues of the micro-batches that go from the next stage back to every stage
+    std::vector<std::unique_ptr<SpscQueue<size_t> > > backward;
+    
+    ///Stores the time in which every stage worked
+    std::vector<double> busy;
+    
+    ///Stores the time of all the pipelined batches
+    double seconds;
+    
+    ///Stores the intermediate results of the whole batch
+    Workspace<Scalar> workspace;
+    
+};
+
 #pragma mark - Network functions
 
-Network::Network(size_t perceptrons) :
-m_pimpl(new Impl(perceptrons))
+template <typename Scalar>
+BasicNetwork<Scalar>::BasicNetwork(size_t perceptrons, ActivationType activation) :
+m_pimpl(new Impl(perceptrons, activation)),
+m_workspace(new Workspace<Scalar>())
 { }
 
-Network::Network(const std::string& serialized) :
-m_pimpl(new Impl(serialized))
+template <typename Scalar>
+std::unique_ptr<BasicNetwork<Scalar> > BasicNetwork<Scalar>::Deserialize(const char* serialized, const char* end, ThreadPool* pool) {
+
+    std::vector<Layer<Scalar> > layers;
+    
+    //Every layer reads on from where the previous one ended, until the end of the network
+    while (serialized != end && *serialized != '\n') {
+        
+        layers.push_back(Layer<Scalar>(0, 0));
+        
+        if (!Layer<Scalar>::Deserialize(serialized, end, layers.back(), pool))
+            return NULL;
+    }
+    
+    if (layers.empty())
+        return NULL;
+    
+    return std::unique_ptr<BasicNetwork<Scalar> >(new BasicNetwork<Scalar>(std::move(layers)));
+}
+
+template <typename Scalar>
+BasicNetwork<Scalar>::BasicNetwork(std::vector<Layer<Scalar> > layers) :
+m_pimpl(new Impl(layers, 0)),
+m_workspace(new Workspace<Scalar>())
 { }
 
-Network::~Network() { };
+template <typename Scalar>
+BasicNetwork<Scalar>::~BasicNetwork() { };
+
+template <typename Scalar>
+void BasicNetwork<Scalar>::AddNetwork(size_t perceptrons, ActivationType activation) {
+    m_pimpl->AddNetwork(perceptrons, activation);
+}
+
+template <typename Scalar>
+void BasicNetwork<Scalar>::SetBinaryInput(bool binary) {
+    m_pimpl->SetBinaryInput(binary);
+}
+
+template <typename Scalar>
+void BasicNetwork<Scalar>::SetFastActivation(bool fast) {
+    m_pimpl->SetFastActivation(fast);
+}
+
+template <typename Scalar>
+void BasicNetwork<Scalar>::SetThreadPool(ThreadPool* pool) {
+    m_pimpl->SetThreadPool(pool);
+}
+
+template <typename Scalar>
+void BasicNetwork<Scalar>::SetPipelineStages(size_t stages) {
+    
+    m_pipeline.reset();
+    
+    std::vector<size_t> boundaries = m_pimpl->Partition(stages);
+    
+    //A single stage is the same as no pipeline
+    if (boundaries.size() > 2)
+        m_pipeline.reset(new Pipeline(boundaries));
+}
+
+template <typename Scalar>
+std::vector<PipelineStage> BasicNetwork<Scalar>::PipelineStages() const {
+    
+    std::vector<PipelineStage> stages;
+    
+    if (!m_pipeline)
+        return stages;
+    
+    for (size_t stage = 0 ; stage < m_pipeline->busy.size() ; stage++) {
+        
+        PipelineStage current;
+        current.first_layer = m_pipeline->boundaries[stage];
+        current.layers = m_pipeline->boundaries[stage + 1] - current.first_layer;
+        current.utilization = (m_pipeline->seconds > 0.0) ? m_pipeline->busy[stage] / m_pipeline->seconds : 0.0;
+        stages.push_back(current);
+    }
+    
+    return stages;
+}
+
+template <typename Scalar>
+const std::vector<Scalar>& BasicNetwork<Scalar>::Feed(const Data& data) const {
+    return Feed(data, *m_workspace);
+}
 
-void Network::AddNetwork(size_t perceptrons) {
-    m_pimpl->AddNetwork(perceptrons);
+template <typename Scalar>
+const std::vector<Scalar>& BasicNetwork<Scalar>::Feed(const Data& data, Workspace<Scalar>& workspace) const {
+    
+    m_pimpl->Prepare(workspace);
+    
+    const std::vector<uint32_t>* active = m_pimpl->Active(data);
+    return m_pimpl->Feed((active) ? NULL : Input(data, workspace), active, workspace.layers.data());
 }
 
-std::vector<double> Network::Feed(const Data& data) const {
-    return m_pimpl->Feed(data);
+template <typename Scalar>
+const std::vector<Scalar>& BasicNetwork<Scalar>::FeedBatch(const std::vector<Data>& data, Workspace<Scalar>& workspace) const {
+    
+    m_pimpl->Prepare(workspace, data.size());
+    return m_pimpl->FeedBatch(data, workspace);
+}
+
+template <typename Scalar>
+void BasicNetwork<Scalar>::Train(const neural::Data &data, const neural::Data &target) {
+    Train(data, target, *m_workspace);
+}
+
+template <typename Scalar>
+void BasicNetwork<Scalar>::Train(const neural::Data &data, const neural::Data &target, Workspace<Scalar>& workspace) {
+    
+    m_pimpl->Prepare(workspace);
+    
+    const std::vector<uint32_t>* active = m_pimpl->Active(data);
+    m_pimpl->Train((active) ? NULL : Input(data, workspace), active, target, workspace.layers.data());
+}
+
+template <typename Scalar>
+void BasicNetwork<Scalar>::TrainBatch(const std::vector<Data>& data, const std::vector<Data>& targets) {
+    
+    if (m_pipeline)     m_pimpl->TrainBatch(data, targets, *m_pipeline);
+    else                m_pimpl->TrainBatch(data, targets, *m_workspace);
 }
 
-void Network::Train(const neural::Data &data, const neural::Data &target) {
-    m_pimpl->Train(data, target);
+template <typename Scalar>
+void BasicNetwork<Scalar>::TrainBatch(const std::vector<Data>& data, const std::vector<Data>& targets, Workspace<Scalar>* workspaces, ThreadPool& pool) {
+    m_pimpl->TrainBatch(data, targets, workspaces, pool);
 }
 
-std::string Network::Serialize() const {
+template <typename Scalar>
+std::string BasicNetwork<Scalar>::Serialize() const {
     return m_pimpl->Serialize();
 }
+
+template <typename Scalar>
+size_t BasicNetwork<Scalar>::Bytes() const {
+    return m_pimpl->Bytes();
+}
+
+template <typename Scalar>
+size_t BasicNetwork<Scalar>::Parameters() const {
+    return m_pimpl->Parameters();
+}
+
+template <typename Scalar>
+std::vector<const Layer<Scalar>*> BasicNetwork<Scalar>::Layers() const {
+    
+    std::vector<const Layer<Scalar>*> layers;
+    m_pimpl->Layers(layers);
+    
+    return layers;
+}
+
+template <typename Scalar>
+bool BasicNetwork<Scalar>::HasShape(size_t inputs, size_t outputs) const {
+    
+    for (const Layer<Scalar>* layer : Layers()) {
+        
+        if (layer->Connections() != inputs)
+            return false;
+        
+        inputs = layer->Size();
+    }
+    
+    return inputs == outputs;
+}
+
+template <typename Scalar>
+void BasicNetwork<Scalar>::ExportParameters(double* parameters) const {
+    m_pimpl->ExportParameters(parameters);
+}
+
+template <typename Scalar>
+void BasicNetwork<Scalar>::ImportParameters(const double* parameters) {
+    m_pimpl->ImportParameters(parameters);
+}
+
+template class neural::BasicNetwork<double>;
+template class neural::BasicNetwork<float>;
@@ -9,49 +9,169 @@
 #ifndef Network_hpp
 #define Network_hpp
 #include "Definitions.h"
+#include "Activation.hpp"
 #include <stdio.h>
 #include <vector>
 #include <memory>
 NAMESPACE_NEURAL_BEGIN
+class ThreadPool;
 class Data;
+template <typename Scalar> class Workspace;
+template <typename Scalar> class Layer;
+
+/**
+ * A stage of a pipelined network (see 'BasicNetwork::SetPipelineStages').
+ */
+struct PipelineStage {
+    
+    ///The index of the first layer of the stage
+    size_t first_layer;
+    
+    ///The number of layers of the stage
+    size_t layers;
+    
+    ///The part of the pipelined training time in which the stage was working, 0 to 1
+    double utilization;
+};
 
 /**
  * The network class is essentialy a linked list
  * of networks that communicate and handle data
  * and training via percetrons that each network has.
+ *
+ * The weights and all of the calculations use the
+ * given scalar type, which is either double or float.
+ * A float network moves half of the memory and fits
+ * twice as many values in every vector instruction.
  */
-class Network {
+template <typename Scalar>
+class BasicNetwork {
 public:
     
     /**
      * Constructor.
      *
      * @param perceptrons  Number of perceptrons in the starting layer.
+     * @param activation   The activation function of the starting layer.
+     */
+    BasicNetwork(size_t perceptrons, ActivationType activation = ActivationType::kSigmoid);
+    
+    /**
+     * Reads the serialized network in place, in a single pass.
+     *
+     * @param serialized    The beginning of the serialized network.
+     * @param end           The end of the serialized network.
+     * @param pool          The threads that share the perceptrons of every layer, or NULL.
+     * @return The network, or NULL if it has no layers or a layer could
+     *         not be read.
      */
-    Network(size_t perceptrons);
+    static std::unique_ptr<BasicNetwork> Deserialize(const char* serialized, const char* end, ThreadPool* pool = NULL);
     
     /**
      * Constructor.
+     * Chains a network for every one of the layers, in their order.
      *
-     * @param The serialized string that was given from a network.
+     * @param layers    The layers, at least one.
      */
-    Network(const std::string& serialized);
+    BasicNetwork(std::vector<Layer<Scalar> > layers);
     
     /**
      * Adds a network to the last network in the chained networks.
      * 
      * @param perceptrons   The number of perceptrons that the added network
      *                      will have.
+     * @param activation    The activation function of the added network.
+     */
+    void AddNetwork(size_t perceptrons, ActivationType activation = ActivationType::kSigmoid);
+    
+    /**
+     * Declares if the data that is given to the network is binary. A
+     * binary network keeps it's first layer's weights by input, so that
+     * records that list their set values in 'Data::active' only sum
+     * and update the weights of those values.
+     *
+     * @param binary    True if the data is binary.
+     */
+    void SetBinaryInput(bool binary);
+    
+    /**
+     * Chooses between the exact sigmoid (the default) and a fast
+     * approximation in every layer of the network. The approximation
+     * is within 1e-7 of the sigmoid, but it's effect on the accuracy
+     * should be validated (with 'Trainer::Test') before relying on it.
+     *
+     * @param fast  True to use the approximation.
+     */
+    void SetFastActivation(bool fast);
+    
+    /**
+     * Splits the work of every layer between the threads of a pool.
+     * The results are the same as with a single thread.
+     *
+     * @param pool  The pool to use, which must outlive the network's use
+     *              of it, or NULL to run on the calling thread only.
+     */
+    void SetThreadPool(ThreadPool* pool);
+    
+    /**
+     * Runs 'TrainBatch' as a pipeline: the layers are split into stages
+     * of about the same work, each on a thread of it's own, and every
+     * batch is split into micro-batches. A stage passes a micro-batch to
+     * the next stage as soon as it is done with it, and the deltas flow
+     * back the same way, so the stages work on different micro-batches
+     * at once. The updates of all the micro-batches are summed and
+     * applied once the batch is through, so the results do not depend
+     * on the number of stages. Suits deep networks with layers that are
+     * too narrow to split between threads.
+     *
+     * @param stages    The number of stages, at most the number of layers.
+     *                  0 or 1 runs the batches on the calling thread.
+     */
+    void SetPipelineStages(size_t stages);
+    
+    /**
+     * Returns the stages of the pipeline, with the part of the time in
+     * which every stage worked since the pipeline was set. A stage that
+     * works far less than the others waits for them, and moving layers
+     * to it would balance the pipeline.
+     *
+     * @return The stages, empty if the network is not pipelined.
      */
-    void AddNetwork(size_t perceptrons);
+    std::vector<PipelineStage> PipelineStages() const;
     
     /**
      * Gets a data to process and returns the result.
      *
      * @param data  The data to process.
-     * @return A vector containing all of the last layer's results
+     * @return A vector containing all of the last layer's results, which
+     *         is valid until the next call that uses the network's workspace.
+     */
+    const std::vector<Scalar>& Feed(const Data& data) const;
+    
+    /**
+     * Gets a data to process and returns the result, using the given
+     * workspace instead of the network's own one.
+     *
+     * @param data          The data to process.
+     * @param workspace     The workspace that holds the intermediate results.
+     * @return A vector containing all of the last layer's results, which
+     *         is stored in the workspace.
      */
-    std::vector<double> Feed(const Data& data) const;
+    const std::vector<Scalar>& Feed(const Data& data, Workspace<Scalar>& workspace) const;
+    
+    /**
+     * Gets a batch of data to process and returns the results, using
+     * the given workspace. Every layer passes the whole batch through
+     * a block of it's weights at once, and the results are the same as
+     * those of 'Feed' for every record. Several threads may call this
+     * at once, each with it's own workspace.
+     *
+     * @param data          The records to process.
+     * @param workspace     The workspace that holds the intermediate results.
+     * @return The last layer's results, a row per record, which is
+     *         stored in the workspace.
+     */
+    const std::vector<Scalar>& FeedBatch(const std::vector<Data>& data, Workspace<Scalar>& workspace) const;
     
     /**
      * Trains the neural network to comply to a given result.
@@ -61,6 +181,43 @@ public:
      */
     void Train(const Data& data, const Data& target);
     
+    /**
+     * Trains the neural network to comply to a given result, using
+     * the given workspace instead of the network's own one.
+     *
+     * @param data          The data to practice on.
+     * @param target        The values that the network should reach.
+     * @param workspace     The workspace that holds the intermediate results.
+     */
+    void Train(const Data& data, const Data& target, Workspace<Scalar>& workspace);
+    
+    /**
+     * Trains the neural network on a batch of records at once. The
+     * forward and backward passes run as matrix-matrix products, and
+     * the weights receive a single update that is the average of the
+     * updates of all records in the batch.
+     *
+     * @param data      The records to practice on.
+     * @param targets   The values that the network should reach per record.
+     */
+    void TrainBatch(const std::vector<Data>& data, const std::vector<Data>& targets);
+    
+    /**
+     * Trains the neural network on a batch of records that is split
+     * between the threads of a pool. Every thread sums the updates of
+     * it's part into it's own workspace, the sums are added in a fixed
+     * order, and the weights receive a single update (the average, as
+     * in the above). The results are the same on every run for the
+     * same number of threads.
+     *
+     * @param data          The records to practice on.
+     * @param targets       The values that the network should reach per record.
+     * @param workspaces    A workspace per thread of the pool.
+     * @param pool          The threads that share the records, the layers
+     *                      must not be using it (see 'SetThreadPool').
+     */
+    void TrainBatch(const std::vector<Data>& data, const std::vector<Data>& targets, Workspace<Scalar>* workspaces, ThreadPool& pool);
+    
     /**
      * Outputs the network into a format that can later
      * be loaded to recreate the setup and weights (in 
@@ -70,18 +227,82 @@ public:
      */
     std::string Serialize() const;
 
+    /**
+     * Returns the memory that the weights and biases of all
+     * the layers occupy.
+     *
+     * @return The size in bytes.
+     */
+    size_t Bytes() const;
+    
+    /**
+     * Returns the number of weights and biases of all the layers.
+     *
+     * @return The number of parameters.
+     */
+    size_t Parameters() const;
+    
+    /**
+     * Copies the weights and biases of all the layers, in the order
+     * in which 'Serialize' writes them.
+     *
+     * @param parameters    Receives 'Parameters()' values.
+     */
+    void ExportParameters(double* parameters) const;
+    
+    /**
+     * Replaces the weights and biases of all the layers, in the
+     * order of 'ExportParameters'.
+     *
+     * @param parameters    The 'Parameters()' values.
+     */
+    void ImportParameters(const double* parameters);
+    
+    /**
+     * Returns the layers of the chained networks, by order.
+     *
+     * @return The layers, which belong to the network.
+     */
+    std::vector<const Layer<Scalar>*> Layers() const;
+    
+    /**
+     * Returns true if the layers chain from the given number of inputs
+     * to the given number of outputs: the first layer has a connection
+     * per input and every other layer has one per perceptron of the
+     * layer before it. Loaded networks are checked with it before they
+     * are fed, since nothing else bounds the inputs that they read.
+     *
+     * @param inputs    The number of inputs that the network is fed.
+     * @param outputs   The number of outputs that it should give.
+     * @return True if the network has the shape.
+     */
+    bool HasShape(size_t inputs, size_t outputs) const;
+    
     /**
      * Destructor.
      */
-    ~Network();
+    ~BasicNetwork();
     
 private:
     
     class Impl;
     std::unique_ptr<Impl> m_pimpl;
     
+    ///Stores the buffers that are reused by every call
+    std::unique_ptr<Workspace<Scalar> > m_workspace;
+    
+    class Pipeline;
+    
+    ///Stores the threads and queues of the stages, NULL when the network is not pipelined
+    std::unique_ptr<Pipeline> m_pipeline;
+    
 };
 
+///A network of doubles
+typedef BasicNetwork<double> Network;
+
+///A network of floats
+typedef BasicNetwork<float> FloatNetwork;
 
 NAMESPACE_NEURAL_END
 #endif /* Network_hpp */
@@ -9,36 +9,147 @@
 #include "OperationalNetwork.hpp"
 #include "CombinedNetworkImplementation.hpp"
 #include "SeperatedNetworkImplementation.hpp"
+#include "ModelFile.hpp"
 #include "DataIterator.hpp"
+#include "Data.hpp"
+#include "ThreadPool.hpp"
 #include <sstream>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
+#include <thread>
+#include <chrono>
 #include <math.h>
+#include <stdio.h>
 
 #define SHOW_ACCURACY 0
 
 using namespace neural;
 
-OperationalNetwork::OperationalNetwork(enum OperationalNetwork::Type type) {
+///The number of records that 'Estimate' reads from a file before estimating them
+static const size_t kRecordsPerBlock = 4096;
+
+/**
+ * Creates a new network by type.
+ *
+ * @param type      The type of network to create.
+ * @param hidden    The activation function of the hidden layers.
+ * @return The implementation of the network.
+ */
+template <typename Scalar>
+static OperationalNetwork::Impl* Create(OperationalNetwork::Type type, ActivationType hidden) {
     
     switch (type) {
-        case Type::kCombined:   m_pimpl.reset(new CombinedNetworkImplementation());
-        case Type::kSeperated:  m_pimpl.reset(new SeperatedNetworkImplementation());
+        case OperationalNetwork::Type::kCombined:   return new CombinedNetworkImplementation<Scalar>(hidden);
+        case OperationalNetwork::Type::kSeperated:  return new SeperatedNetworkImplementation<Scalar>(hidden);
     }
+    
+    return NULL;
 }
 
-OperationalNetwork::OperationalNetwork(const std::string &serialized_file_path) {
+/**
+ * Recreates a serialized network by type.
+ *
+ * @param type      The name of the type of the network.
+ * @param contents  The beginning of the serialized form of the network.
+ * @param end       The end of the serialized form.
+ * @param pool      The threads that read the network, or NULL.
+ * @return The implementation of the network, or NULL if it is not valid.
+ */
+template <typename Scalar>
+static OperationalNetwork::Impl* Load(const std::string& type, const char* contents, const char* end, ThreadPool* pool) {
+    
+    if (type == "Combined")         return CombinedNetworkImplementation<Scalar>::Deserialize(contents, end, pool).release();
+    else if (type == "Seperated")   return SeperatedNetworkImplementation<Scalar>::Deserialize(contents, end, pool).release();
+    
+    return NULL;
+}
+
+OperationalNetwork::OperationalNetwork(enum OperationalNetwork::Type type, enum OperationalNetwork::Precision precision, ActivationType hidden) {
+    
+    switch (precision) {
+        case Precision::kDouble:    m_pimpl.reset(Create<double>(type, hidden));   break;
+        case Precision::kFloat:     m_pimpl.reset(Create<float>(type, hidden));    break;
+    }
+}
+
+/**
+ * Creates the implementation of a mapped binary model.
+ *
+ * @param file  The mapped file.
+ * @return The implementation of the network, or NULL if the networks
+ *         of the file do not have the shape of the type, which the
+ *         checksum of the file does not tell.
+ */
+template <typename Scalar>
+static OperationalNetwork::Impl* Load(ModelFile& file) {
+    
+    std::vector<std::unique_ptr<BasicNetwork<Scalar> > > networks = file.Networks<Scalar>();
+    
+    switch (file.Type()) {
+        case OperationalNetwork::Type::kCombined:
+            return (networks.size() == 1) ? CombinedNetworkImplementation<Scalar>::Load(std::move(networks.front())).release() : NULL;
+        case OperationalNetwork::Type::kSeperated:
+            return SeperatedNetworkImplementation<Scalar>::Load(std::move(networks)).release();
+    }
+    
+    return NULL;
+}
+
+OperationalNetwork::OperationalNetwork(const std::string &serialized_file_path, size_t threads) {
+    
+    if (ModelFile::Recognize(serialized_file_path)) {
+        
+        std::shared_ptr<ModelFile> file = ModelFile::Open(serialized_file_path);
+        
+        if (!file)
+            return;
+        
+        if (file->Precision() == Precision::kFloat)     m_pimpl.reset(Load<float>(*file));
+        else                                            m_pimpl.reset(Load<double>(*file));
+        
+        return;
+    }
+    
+    std::ifstream file_stream(serialized_file_path, std::ios::binary);
+    Deserialize(file_stream, threads);
+}
+
+OperationalNetwork::OperationalNetwork(std::istream& serialized, size_t threads) {
+    Deserialize(serialized, threads);
+}
+
+void OperationalNetwork::Deserialize(std::istream& serialized, size_t threads) {
     
-    std::fstream file_stream(serialized_file_path);
     std::string type;
-    std::getline(file_stream, type);
+    std::getline(serialized, type);
+    
+    //The precision follows the type, files without it hold doubles
+    std::string precision;
+    size_t delimiter_index = type.find_first_of(' ');
+    
+    if (delimiter_index != std::string::npos) {
+        
+        precision = type.substr(delimiter_index + 1);
+        type.erase(delimiter_index);
+    }
+    
+    //The rest is read in bulk and parsed in place
+    std::ostringstream buffer;
+    buffer << serialized.rdbuf();
+    
+    const std::string& contents = buffer.str();
+    const char* begin = contents.data();
+    const char* end = begin + contents.size();
     
-    std::string contents((std::istreambuf_iterator<char>(file_stream)),
-                         (std::istreambuf_iterator<char>()));
+    std::unique_ptr<ThreadPool> pool((threads != 1) ? new ThreadPool(threads) : NULL);
     
-    if (type == "Combined")         m_pimpl.reset(new CombinedNetworkImplementation(contents));
-    else if (type == "Seperated")   m_pimpl.reset(new SeperatedNetworkImplementation(contents));
+    if (pool && pool->Threads() == 1)
+        pool.reset();
+    
+    if (precision == "float")   m_pimpl.reset(Load<float>(type, begin, end, pool.get()));
+    else                        m_pimpl.reset(Load<double>(type, begin, end, pool.get()));
 }
 
 OperationalNetwork::~OperationalNetwork() { };
@@ -49,46 +160,175 @@ std::string OperationalNetwork::Serialize() const {
     
     //Add the prefix of the network by type
     switch (m_pimpl->Type()) {
-        case Type::kCombined: serialized = "Combined\n";    break;
-        case Type::kSeperated: serialized = "Seperated\n";  break;
+        case Type::kCombined: serialized = "Combined";    break;
+        case Type::kSeperated: serialized = "Seperated";  break;
     }
 
-    return serialized + m_pimpl->Serialize();
+    //Networks of doubles keep the original header, so older readers can load them
+    if (m_pimpl->Precision() == Precision::kFloat)
+        serialized += " float";
+    
+    return serialized + '\n' + m_pimpl->Serialize();
+}
+
+bool OperationalNetwork::Save(const std::string& path, Format format) const {
+    
+    /*
+     * The network is written to another file and renamed over the path,
+     * so that a reader never sees a partly written file, and a network
+     * that runs from the mapped file at the path is not cut short.
+     */
+    std::string temporary_path = path + ".tmp";
+    std::ofstream output(temporary_path, std::ios::binary);
+    bool written;
+    
+    if (format == Format::kBinary)
+        written = m_pimpl->WriteBinary(output);
+    else
+        written = static_cast<bool>(output << Serialize());
+    
+    output.close();
+    
+    if (!written || !output || rename(temporary_path.c_str(), path.c_str()) != 0) {
+        
+        remove(temporary_path.c_str());
+        return false;
+    }
+    
+    return true;
+}
+
+bool OperationalNetwork::Valid() const {
+    return m_pimpl != NULL;
+}
+
+size_t OperationalNetwork::Inputs() const {
+    return m_pimpl->Inputs();
+}
+
+size_t OperationalNetwork::Outputs() const {
+    return m_pimpl->Outputs();
 }
 
 std::string OperationalNetwork::Estimate(const std::string &data_file_path, bool log) const {
     
-    size_t index = 0;
-    size_t all_values = RecordsInFile(data_file_path);
+    std::ostringstream output;
+    Estimate(data_file_path, output, log);
+    
+    return output.str();
+}
+
+void OperationalNetwork::Estimate(const std::string &data_file_path, std::ostream& output, bool log) const {
     
-    std::string output;
+    size_t index = 0;
+    size_t all_values = (log) ? RecordsInFile(data_file_path) : 0;
     
-    //Reserve the values themselfs and another '\n' character
-    output.reserve(all_values * 2);
+    std::vector<Data> block;
+    std::vector<double> results;
+    std::string lines;
+    block.reserve(kRecordsPerBlock);
     
     //Set attribute for logging
     if (log) { std::cout << std::fixed; }
     
-    for (DataIterator test_iterator(data_file_path) ;
-         test_iterator.Valid() ;
-         test_iterator.Next(), ++index) {
+    DataIterator test_iterator(data_file_path);
+        
+    while (test_iterator.Valid()) {
+        
+        //The records of the block are read into those of the last block, so their memory is reused
+        size_t records = 0;
+        
+        for ( ; test_iterator.Valid() && records < kRecordsPerBlock ; test_iterator.Next(), records++) {
+            
+            if (records == block.size())
+                block.emplace_back();
+            
+            test_iterator.Value(block[records]);
+        }
+        
+        block.resize(records);
+        
+        m_pimpl->EstimateBatch(block, results);
         
+        //The results are in the order of the block, so they are written as they are
+        lines.clear();
         
-        output += std::to_string(static_cast<unsigned long long>(lround(m_pimpl->Estimate(test_iterator.Value())))) + '\n';
+        for (size_t result = 0, total = results.size() ; result < total ; result++)
+            lines += std::to_string(static_cast<unsigned long long>(lround(results[result]))) + '\n';
+        
+        output << lines;
+        index += block.size();
         
         //Logging
-        if (log && index % (all_values / 100) == 0)
+        if (log)
             std::cout
             << std::setprecision(3)
             << "overall progress: "
             << index / static_cast<double>(all_values) * 100
             << "%\n";
     }
+}
+
+double OperationalNetwork::Estimate(const Data& data) const {
+    return m_pimpl->Estimate(data);
+}
+
+std::vector<double> OperationalNetwork::EstimateBatch(const std::vector<Data>& data) const {
+    
+    std::vector<double> results;
+    m_pimpl->EstimateBatch(data, results);
     
-    return output;
+    return results;
 }
 
-void OperationalNetwork::Train(const std::string &data_file_path, const std::string &key_file_path, bool log) {
+void OperationalNetwork::Quantize(const std::string &calibration_file_path, bool log) {
+    
+    std::vector<Data> calibration;
+    
+    for (DataIterator data(calibration_file_path) ; data.Valid() ; data.Next())
+        calibration.push_back(data.Value());
+    
+    size_t original_bytes = m_pimpl->Bytes();
+    m_pimpl->Quantize(calibration);
+    
+    if (log)
+        std::cout
+        << "quantized the weights from "
+        << original_bytes / 1024
+        << "KB to "
+        << m_pimpl->Bytes() / 1024
+        << "KB\n";
+}
+
+bool OperationalNetwork::Specialize() {
+    return m_pimpl->Specialize();
+}
+
+void OperationalNetwork::SetFastActivation(bool fast) {
+    m_pimpl->SetFastActivation(fast);
+}
+
+void OperationalNetwork::SetThreads(size_t threads) {
+    m_pimpl->SetThreads(threads);
+}
+
+void OperationalNetwork::SetPipelineStages(size_t stages) {
+    m_pimpl->SetPipelineStages(stages);
+}
+
+void OperationalNetwork::TrainBatch(const std::vector<Data>& data, const std::vector<size_t>& keys) {
+    m_pimpl->TrainBatch(data, keys);
+}
+
+void OperationalNetwork::ExportParameters(std::vector<double>& parameters) const {
+    m_pimpl->ExportParameters(parameters);
+}
+
+void OperationalNetwork::ImportParameters(const std::vector<double>& parameters) {
+    m_pimpl->ImportParameters(parameters);
+}
+
+void OperationalNetwork::Train(const std::string &data_file_path, const std::string &key_file_path, bool log, size_t batch_size, size_t threads) {
         
     //Train all networks
     size_t index = 0;
@@ -104,6 +344,34 @@ void OperationalNetwork::Train(const std::string &data_file_path, const std::str
     //Set attribute for logging
     if (log) { std::cout << std::fixed; }
     
+    //Stores the records that wait for their batch to fill up
+    std::vector<Data> batch_data;
+    std::vector<size_t> batch_keys;
+    
+    //Stores the record that is trained on by itself, read into the same memory every time
+    Data record;
+    
+    if (batch_size > 1) {
+        
+        batch_data.reserve(batch_size);
+        batch_keys.reserve(batch_size);
+    }
+    
+    //The threads that split every batch, each with it's own workspace
+    std::unique_ptr<ThreadPool> pool;
+    
+    if (batch_size > 1 && threads != 1) {
+        
+        pool.reset(new ThreadPool(threads));
+        m_pimpl->BeginConcurrentTraining(pool->Threads());
+    }
+    
+    auto train_batch = [this, &pool, &batch_data, &batch_keys]() {
+        
+        if (pool)   m_pimpl->TrainBatchConcurrently(batch_data, batch_keys, *pool);
+        else        m_pimpl->TrainBatch(batch_data, batch_keys);
+    };
+    
     for (DataIterator data(data_file_path), results(key_file_path) ;
          data.Valid() && results.Valid() ;
          data.Next(), results.Next(), index++) {
@@ -111,9 +379,25 @@ void OperationalNetwork::Train(const std::string &data_file_path, const std::str
         size_t real_value = static_cast<size_t>(lround(results.Value().content.front()));
         
         //Training session
-        m_pimpl->Train(data.Value(), real_value);
+        if (batch_size > 1) {
+            
+            batch_data.push_back(data.Value());
+            batch_keys.push_back(real_value);
+            
+            if (batch_data.size() == batch_size) {
+                
+                train_batch();
+                batch_data.clear();
+                batch_keys.clear();
+            }
+        }
+        else {
+            
+            data.Value(record);
+            m_pimpl->Train(record, real_value);
+        }
         
-        if (log && index % (all_records / 100) == 0)
+        if (log && index % std::max<size_t>(all_records / 100, 1) == 0)
             std::cout
             << std::setprecision(3)
             << "overall progress: "
@@ -126,7 +410,7 @@ void OperationalNetwork::Train(const std::string &data_file_path, const std::str
             if (real_value == static_cast<size_t>(lround(m_pimpl->Estimate(data.Value()))))
                 ++correct;
             
-            if (log && (index) % (all_records / 100) == 0)
+            if (log && index % std::max<size_t>(all_records / 100, 1) == 0)
                 std::cout
                 << std::setprecision(3)
                 << "correct: "
@@ -136,4 +420,95 @@ void OperationalNetwork::Train(const std::string &data_file_path, const std::str
 #endif
         
     }
+    
+    //Train on the records that did not fill a whole batch
+    if (!batch_data.empty())
+        train_batch();
+    
+    if (pool)
+        m_pimpl->EndConcurrentTraining();
+    
+    //Show where the pipeline waits, a stage that works much less than the others has too few layers
+    std::vector<PipelineStage> stages = m_pimpl->PipelineStages();
+    
+    for (size_t stage = 0 ; log && stage < stages.size() ; stage++)
+        std::cout
+        << std::setprecision(1)
+        << "stage " << stage << ":	"
+        << "layers " << stages[stage].first_layer << "-" << stages[stage].first_layer + stages[stage].layers - 1 << "	"
+        << stages[stage].utilization * 100 << "% utilization\n";
+}
+
+void OperationalNetwork::TrainConcurrently(const std::string &data_file_path, const std::string &key_file_path, size_t threads, bool log) {
+    
+    threads = std::max<size_t>(threads, 1);
+    size_t all_records = RecordsInFile(key_file_path);
+    
+    //Every thread reports it's own numbers, written once at the end
+    std::vector<size_t> records(threads, 0);
+    std::vector<double> seconds(threads, 0.0);
+    std::vector<std::thread> trainers;
+    
+    m_pimpl->BeginConcurrentTraining(threads);
+    
+    for (size_t thread = 0 ; thread < threads ; thread++) {
+        
+        trainers.push_back(std::thread([this, &data_file_path, &key_file_path, &records, &seconds, all_records, threads, thread]() {
+            
+            //The slice of the thread, reached by skipping the lines before it
+            size_t begin = all_records * thread / threads;
+            size_t end = all_records * (thread + 1) / threads;
+            
+            DataIterator data(data_file_path), results(key_file_path);
+            
+            for (size_t index = 0 ; index < begin && data.Valid() && results.Valid() ; index++) {
+                
+                data.Next();
+                results.Next();
+            }
+            
+            auto start = std::chrono::steady_clock::now();
+            size_t trained = 0;
+            Data record;
+            
+            for (size_t index = begin ; index < end && data.Valid() && results.Valid() ; index++, data.Next(), results.Next()) {
+                
+                size_t real_value = static_cast<size_t>(lround(results.Value().content.front()));
+                
+                data.Value(record);
+                m_pimpl->TrainConcurrently(record, real_value, thread);
+                trained++;
+            }
+            
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            records[thread] = trained;
+            seconds[thread] = elapsed.count();
+        }));
+    }
+    
+    for (size_t thread = 0 ; thread < threads ; thread++)
+        trainers[thread].join();
+    
+    m_pimpl->EndConcurrentTraining();
+    
+    if (log) {
+        
+        size_t total_records = 0;
+        double slowest = 0.0;
+        
+        std::cout << std::fixed << std::setprecision(1);
+        
+        for (size_t thread = 0 ; thread < threads ; thread++) {
+            
+            std::cout
+            << "thread " << thread << ":\t"
+            << records[thread] << " records\t"
+            << records[thread] / std::max(seconds[thread], 1e-9) << " records/sec\n";
+            
+            total_records += records[thread];
+            slowest = std::max(slowest, seconds[thread]);
+        }
+        
+        std::cout << "all threads:\t" << total_records << " records\t" << total_records / std::max(slowest, 1e-9) << " records/sec\n";
+    }
 }
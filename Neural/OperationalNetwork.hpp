@@ -9,8 +9,12 @@
 #ifndef OperationalNetwork_hpp
 #define OperationalNetwork_hpp
 #include "Definitions.h"
+#include "Activation.hpp"
 #include <string>
+#include <vector>
 #include <memory>
+#include <istream>
+#include <ostream>
 NAMESPACE_NEURAL_BEGIN
 class Data;
 
@@ -22,19 +26,48 @@ public:
         kSeperated
     };
     
+    enum class Precision {
+        kDouble,
+        kFloat
+    };
+    
+    enum class Format {
+        kText,
+        kBinary
+    };
+    
     /**
      * This will create the network by given type in the input.
      *
-     * @param type The type of network to create.
+     * @param type      The type of network to create.
+     * @param precision The type of the network's weights.
+     * @param hidden    The activation function of the hidden layers (the
+     *                  output layer is always a sigmoid).
+     */
+    OperationalNetwork(enum OperationalNetwork::Type type,
+                       enum OperationalNetwork::Precision precision = Precision::kDouble,
+                       ActivationType hidden = ActivationType::kSigmoid);
+    
+    /**
+     * This will recreate the network given in the input, with the
+     * precision that the network was saved with. A file in the binary
+     * form is mapped and used in place (see 'ModelFile'), a file in
+     * the text form is parsed.
+     *
+     * @param serialized_file_path  The serialized form of the network.
+     * @param threads               The number of threads that parse the text form: 0 uses
+     *                              a thread per core. The network itself is not affected.
      */
-    OperationalNetwork(enum OperationalNetwork::Type type);
+    OperationalNetwork(const std::string& serialized_file_path, size_t threads = 1);
     
     /**
-     * This will recreate the network given in the input.
+     * This will recreate the network from it's serialized form, as
+     * returned by 'Serialize'.
      *
-     * @param serialized_file_path The serialized form of the network.
+     * @param serialized    A stream that holds the serialized form of the network.
+     * @param threads       The number of threads that parse it, 0 uses a thread per core.
      */
-    OperationalNetwork(const std::string& serialized_file_path);
+    OperationalNetwork(std::istream& serialized, size_t threads = 1);
 
     /**
      * This will serialize the network into a form that can be saved and
@@ -44,6 +77,41 @@ public:
      */
     std::string Serialize() const;
     
+    /**
+     * Saves the network to a file, in the text form of 'Serialize' or
+     * in the binary form, which keeps the weights exactly and loads
+     * without parsing.
+     *
+     * @param path      The path to the file.
+     * @param format    The form to save in.
+     * @return True if the network was saved.
+     */
+    bool Save(const std::string& path, Format format = Format::kText) const;
+    
+    /**
+     * Returns true if the network was created, which fails only when
+     * a binary file is damaged or of another version.
+     *
+     * @return The state of the network.
+     */
+    bool Valid() const;
+    
+    /**
+     * Returns the number of values that every record has, the pixels
+     * of an image. Missing values of a shorter record are taken as 0.
+     *
+     * @return The number of values.
+     */
+    size_t Inputs() const;
+    
+    /**
+     * Returns the number of results of the network, a certainty per
+     * digit that the estimation picks the largest of.
+     *
+     * @return The number of results.
+     */
+    size_t Outputs() const;
+    
     /**
      * Runs the network against the input data and outputs the
      * results as a string with each line containing the estimated
@@ -55,16 +123,156 @@ public:
      */
     std::string Estimate(const std::string& data_file_path, bool log = true) const;
     
+    /**
+     * Runs the network against the input data and writes the results
+     * to a stream, a line per record in the order of the file. The file
+     * is read in blocks that are estimated with 'EstimateBatch', so only
+     * a block of records is held at a time.
+     *
+     * @param data_file_path    The path to the data file.
+     * @param output            The stream to write the estimated results to.
+     * @param log               Flag that indicates to print progress to consule.
+     */
+    void Estimate(const std::string& data_file_path, std::ostream& output, bool log = true) const;
+    
+    /**
+     * Estimates the result of a single record. Several threads may
+     * estimate at once, as long as none of them trains the network.
+     *
+     * @param data  The record to estimate.
+     * @return The estimated result.
+     */
+    double Estimate(const Data& data) const;
+    
+    /**
+     * Estimates the results of a batch of records. The records are
+     * passed through the network in chunks, which are split between
+     * the threads of the network (see 'SetThreads'). The results are
+     * the same as those of 'Estimate' for every record.
+     *
+     * @param data  The records to estimate.
+     * @return The estimated result of every record, by order.
+     */
+    std::vector<double> EstimateBatch(const std::vector<Data>& data) const;
+    
+    /**
+     * Creates an 8 bit integer copy of the trained network, which
+     * 'Estimate' uses from then on (until the network trains again).
+     * The copy is calibrated on the records of the given file, which
+     * should be a sample of the data that the network will estimate.
+     *
+     * @param calibration_file_path     The path to the file that has the sample records.
+     * @param log                       Flag that indicates to print the size of the copy to consule.
+     */
+    void Quantize(const std::string& calibration_file_path, bool log = true);
+    
+    /**
+     * Creates a copy of the trained network whose layer sizes are
+     * compile time constants (see 'FixedNetwork'), which 'Estimate'
+     * uses from then on (until the network trains again). Only the
+     * default topology of every type has such a copy.
+     *
+     * @return True if the network has the default topology of it's type.
+     */
+    bool Specialize();
+    
+    /**
+     * Chooses between the exact sigmoid (the default) and a fast
+     * approximation, for both training and estimating. The choice
+     * is not saved with the network.
+     *
+     * @param fast  True to use the approximation.
+     */
+    void SetFastActivation(bool fast);
+    
+    /**
+     * Changes the number of threads that share the work of every layer,
+     * for both training and estimating. Layers that are too small to
+     * gain from it still run on a single thread. The ten networks of a
+     * seperated network run concurrently instead, each on one thread.
+     * The results are the same for any number of threads. The choice
+     * is not saved with the network.
+     *
+     * @param threads   The number of threads, 0 uses a thread per core and
+     *                  1 (the default) runs on the calling thread only.
+     */
+    void SetThreads(size_t threads);
+    
+    /**
+     * Trains the mini-batches of 'Train' as a pipeline: the layers of the
+     * network are split into stages, each on a thread of it's own, and
+     * the micro-batches of every batch flow through them. The results
+     * are the same for any number of stages, and the same as those of
+     * the mini-batches without a pipeline. Only the combined network
+     * is deep enough to be pipelined. When 'Train' logs, it prints the
+     * utilization of every stage at the end.
+     *
+     * @param stages    The number of stages, 0 or 1 (the default) turns it off.
+     */
+    void SetPipelineStages(size_t stages);
+    
     /**
      * Trains the network against known data.
      *
      * @param data_file_path    The path to the file containing the pixel data.
      * @param key_file_path     The path to the file containing the results of the data file.
      * @param log               Flag if to output progress to the consule.
+     * @param batch_size        The number of records that are trained together. A batch
+     *                          of 1 updates the weights after every record.
+     * @param threads           The number of threads that split every batch (0 for a
+     *                          thread per core). The threads sum their updates and the
+     *                          sums are added in a fixed order, so for the same number of
+     *                          threads (and seed, see 'RandomGenerator::Seed') every run
+     *                          gives the same weights. Only used with batches.
      */
     void Train(const std::string& data_file_path,
                const std::string& key_file_path,
-               bool log = true);
+               bool log = true,
+               size_t batch_size = 1,
+               size_t threads = 1);
+    
+    /**
+     * Trains the network against known data with several threads at
+     * once, each on it's own slice of the file, that update the shared
+     * weights without locks (Hogwild). Updates that race with each other
+     * may be lost, so the results differ from run to run, but the inputs
+     * are sparse and the updates rarely meet.
+     *
+     * @param data_file_path    The path to the file containing the pixel data.
+     * @param key_file_path     The path to the file containing the results of the data file.
+     * @param threads           The number of threads that train.
+     * @param log               Flag if to output the throughput of every thread to the consule.
+     */
+    void TrainConcurrently(const std::string& data_file_path,
+                           const std::string& key_file_path,
+                           size_t threads,
+                           bool log = true);
+    
+    /**
+     * Trains the network with a batch of records and their answers,
+     * applying a single update for the whole batch.
+     *
+     * @param data  The records to train on.
+     * @param keys  The answer to every record.
+     */
+    void TrainBatch(const std::vector<Data>& data, const std::vector<size_t>& keys);
+    
+    /**
+     * Copies the weights and biases of the network into a single
+     * vector, in the order in which they are serialized. Networks of
+     * the same type and shape have the same layout.
+     *
+     * @param parameters    Receives the parameters, resized to fit them.
+     */
+    void ExportParameters(std::vector<double>& parameters) const;
+    
+    /**
+     * Replaces the weights and biases of the network, in the order
+     * of 'ExportParameters'.
+     *
+     * @param parameters    The parameters.
+     */
+    void ImportParameters(const std::vector<double>& parameters);
     
     /**
      * Destructor.
@@ -76,6 +284,14 @@ public:
 
 private:
     
+    /**
+     * Creates the implementation from the serialized form of a network.
+     *
+     * @param serialized    A stream that holds the serialized form.
+     * @param threads       The number of threads that parse it.
+     */
+    void Deserialize(std::istream& serialized, size_t threads);
+    
     ///Stores the implementation
     std::unique_ptr<Impl> m_pimpl;
     
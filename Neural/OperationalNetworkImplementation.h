@@ -10,8 +10,11 @@
 #define OperationalNetworkImplementation_h
 #include "OperationalNetwork.hpp"
 #include <stdlib.h>
+#include <vector>
 NAMESPACE_NEURAL_BEGIN
 class Data;
+class ThreadPool;
+struct PipelineStage;
 
 class OperationalNetwork::Impl {
 public:
@@ -28,6 +31,13 @@ public:
      */
     virtual OperationalNetwork::Type Type() const = 0;
     
+    /**
+     * Returns the precision of the network's weights as an enum.
+     *
+     * @return An enum that represents the precision of the network.
+     */
+    virtual OperationalNetwork::Precision Precision() const = 0;
+    
     /**
      * Trains the network with given input and it's answer.
      *
@@ -36,6 +46,53 @@ public:
      */
     virtual void Train(const Data& data, size_t key) = 0;
     
+    /**
+     * Trains the network with a batch of inputs and their answers,
+     * applying a single update for the whole batch.
+     *
+     * @param data  The data to train on.
+     * @param keys  The answer to every data in the batch.
+     */
+    virtual void TrainBatch(const std::vector<Data>& data, const std::vector<size_t>& keys) = 0;
+    
+    /**
+     * Prepares the network to be trained by several threads at once,
+     * each with it's own intermediate results.
+     *
+     * @param threads   The number of threads that will train.
+     */
+    virtual void BeginConcurrentTraining(size_t threads) = 0;
+    
+    /**
+     * Trains the network with given input and it's answer, from one of
+     * the threads that train at once. The threads update the weights
+     * without locks, so an update that races with another may be lost.
+     *
+     * @param data      The data to train on.
+     * @param key       The answer to the data.
+     * @param thread    The index of the calling thread, below the number of threads.
+     */
+    virtual void TrainConcurrently(const Data& data, size_t key, size_t thread) = 0;
+    
+    /**
+     * Releases what 'BeginConcurrentTraining' prepared.
+     */
+    virtual void EndConcurrentTraining() = 0;
+    
+    /**
+     * Trains the network with a batch of inputs and their answers, split
+     * between the threads of a pool. Every thread sums the updates of it's
+     * part of the batch, and the sums are added in a fixed order before a
+     * single update, so the results do not depend on the timing of the
+     * threads. Must be called between 'BeginConcurrentTraining' (with the
+     * number of threads of the pool) and 'EndConcurrentTraining'.
+     *
+     * @param data  The data to train on.
+     * @param keys  The answer to every data in the batch.
+     * @param pool  The threads that share the batch.
+     */
+    virtual void TrainBatchConcurrently(const std::vector<Data>& data, const std::vector<size_t>& keys, ThreadPool& pool) = 0;
+    
     /**
      * Estimates the result to the given input.
      *
@@ -43,6 +100,98 @@ public:
      */
     virtual double Estimate(const Data& input) const = 0;
     
+    /**
+     * Estimates the results of a batch of inputs, which may be split
+     * between the threads of the network.
+     *
+     * @param data      The inputs to estimate.
+     * @param results   Receives the estimation of every input, by order.
+     */
+    virtual void EstimateBatch(const std::vector<Data>& data, std::vector<double>& results) const = 0;
+    
+    /**
+     * Creates an 8 bit integer copy of the network that is used by
+     * 'Estimate' from then on, until the network trains again.
+     *
+     * @param calibration   Sample records to calibrate the copy with.
+     */
+    virtual void Quantize(const std::vector<Data>& calibration) = 0;
+    
+    /**
+     * Creates a copy of the network with compile time layer sizes that
+     * is used by 'Estimate' from then on, until the network trains again.
+     *
+     * @return True if the network has the sizes of the copy.
+     */
+    virtual bool Specialize() = 0;
+    
+    /**
+     * Chooses between the exact sigmoid and a fast approximation.
+     *
+     * @param fast  True to use the approximation.
+     */
+    virtual void SetFastActivation(bool fast) = 0;
+    
+    /**
+     * Changes the number of threads that share the work of every layer.
+     *
+     * @param threads   The number of threads, 1 runs on the calling thread only.
+     */
+    virtual void SetThreads(size_t threads) = 0;
+    
+    /**
+     * Trains the batches as a pipeline of stages of layers, each stage
+     * on a thread of it's own.
+     *
+     * @param stages    The number of stages, 0 or 1 turns the pipeline off.
+     */
+    virtual void SetPipelineStages(size_t stages) = 0;
+    
+    /**
+     * Returns the stages of the pipeline and their utilization.
+     *
+     * @return The stages, empty if the network is not pipelined.
+     */
+    virtual std::vector<PipelineStage> PipelineStages() const = 0;
+    
+    /**
+     * Returns the number of values that every record has.
+     *
+     * @return The number of values.
+     */
+    virtual size_t Inputs() const = 0;
+    
+    /**
+     * Returns the number of results of the network.
+     *
+     * @return The number of results.
+     */
+    virtual size_t Outputs() const = 0;
+    
+    /**
+     * Returns the memory that the weights occupy, of the quantized
+     * copy if there is one.
+     *
+     * @return The size in bytes.
+     */
+    virtual size_t Bytes() const = 0;
+    
+    /**
+     * Copies the weights and biases of the network into a single vector,
+     * in the order in which they are serialized.
+     *
+     * @param parameters    Receives the parameters, resized to fit them.
+     */
+    virtual void ExportParameters(std::vector<double>& parameters) const = 0;
+    
+    /**
+     * Replaces the weights and biases of the network, in the order
+     * of 'ExportParameters'.
+     *
+     * @param parameters    The parameters.
+     */
+    virtual void ImportParameters(const std::vector<double>& parameters) = 0;
+    
     /**
      * This will serialize the network into a form that can be saved and
      * later construct an identical network to the current one.
@@ -51,6 +200,27 @@ public:
      */
     virtual std::string Serialize() const = 0;
     
+    /**
+     * Writes the network in the binary form of 'ModelFile'.
+     *
+     * @param output    The stream to write to.
+     * @return True if the network was written.
+     */
+    virtual bool WriteBinary(std::ostream& output) const = 0;
+    
+};
+
+/**
+ * Maps the scalar type of a network's weights to it's precision.
+ */
+template <typename Scalar> struct PrecisionOf;
+
+template <> struct PrecisionOf<double> {
+    static constexpr OperationalNetwork::Precision value = OperationalNetwork::Precision::kDouble;
+};
+
+template <> struct PrecisionOf<float> {
+    static constexpr OperationalNetwork::Precision value = OperationalNetwork::Precision::kFloat;
 };
 
 NAMESPACE_NEURAL_END
@@ -0,0 +1,303 @@
+//
+//  ParameterServer.cpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#include "ParameterServer.hpp"
+#include "OperationalNetwork.hpp"
+#include "Connection.hpp"
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <stdint.h>
+
+using namespace neural;
+
+/**
+ * Implementation.
+ */
+class ParameterServer::Impl {
+public:
+    
+    /**
+     * Constructor.
+     *
+     * @param network       The network to train.
+     * @param address       The address to listen on.
+     * @param workers       The number of workers.
+     * @param staleness     The number of steps that a worker may be ahead.
+     */
+    Impl(OperationalNetwork& network, const std::string& address, size_t workers, size_t staleness);
+    
+    /**
+     * Serves all the workers until they are done.
+     *
+     * @param log   Flag that indicates to print the progress to consule.
+     * @return True if the workers were served.
+     */
+    bool Run(bool log);
+    
+private:
+    
+    /**
+     * Receives the changes of a worker and replies with the weights,
+     * until the worker is done. Runs on a thread per worker.
+     *
+     * @param worker    The index of the worker.
+     */
+    void Serve(size_t worker);
+    
+    /**
+     * Marks a worker as done, so that the others no longer wait for it.
+     * Must be called with the lock held.
+     *
+     * @param worker    The index of the worker.
+     */
+    void Leave(size_t worker);
+    
+    /**
+     * Applies the average of the changes of a synchronous step if every
+     * worker that is not done sent it's change. Must be called with the
+     * lock held.
+     */
+    void CompleteStep();
+    
+    /**
+     * Returns the step of the slowest worker that is not done. Must be
+     * called with the lock held.
+     *
+     * @param fallback  The step to return if all the workers are done.
+     * @return The step of the slowest worker.
+     */
+    uint32_t Slowest(uint32_t fallback) const;
+    
+    ///Stores the network, which receives the weights at the end
+    OperationalNetwork& m_network;
+    
+    ///Stores the address to listen on
+    std::string m_address;
+    
+    ///Stores the number of workers
+    size_t m_workers;
+    
+    ///Stores the number of steps that a worker may be ahead, 0 for synchronous steps
+    size_t m_staleness;
+    
+    ///Stores a connection per worker
+    std::vector<std::unique_ptr<Connection> > m_connections;
+    
+    ///Stores the weights of the network, as in 'OperationalNetwork::ExportParameters'
+    std::vector<double> m_parameters;
+    
+    ///Stores the sum of the changes of the current synchronous step
+    std::vector<double> m_changes;
+    
+    ///Stores the number of workers that sent their change for the current synchronous step
+    size_t m_pushed;
+    
+    ///Stores the number of the current synchronous step
+    uint32_t m_step;
+    
+    ///Stores the number of steps that every worker finished
+    std::vector<uint32_t> m_clocks;
+    
+    ///Stores true for every worker that is done
+    std::vector<bool> m_done;
+    
+    ///Stores the number of times that the weights changed
+    size_t m_updates;
+    
+    ///Guards all of the above that the workers share
+    std::mutex m_mutex;
+    
+    ///Wakes the workers that wait for a step
+    std::condition_variable m_changed;
+    
+};
+
+#pragma mark - Implementation
+
+ParameterServer::Impl::Impl(OperationalNetwork& network, const std::string& address, size_t workers, size_t staleness) :
+m_network(network),
+m_address(address),
+m_workers(std::max<size_t>(workers, 1)),
+m_staleness(staleness),
+m_pushed(0),
+m_step(0),
+m_clocks(m_workers, 0),
+m_done(m_workers, false),
+m_updates(0)
+{ }
+
+bool ParameterServer::Impl::Run(bool log) {
+    
+    Listener listener(m_address);
+    
+    if (!listener.Listening())
+        return false;
+    
+    m_network.ExportParameters(m_parameters);
+    m_changes.assign(m_parameters.size(), 0.0);
+    
+    //The workers build their copies from the same form that is saved to files, then take the exact weights
+    std::string model = m_network.Serialize();
+    
+    if (log)
+        std::cout << "waiting for " << m_workers << " workers on " << m_address << '\n';
+    
+    for (size_t worker = 0 ; worker < m_workers ; worker++) {
+        
+        std::unique_ptr<Connection> connection = listener.Accept();
+        uint64_t shard[] = { worker, m_workers };
+        
+        if (!connection ||
+            !connection->Send(Connection::Message::kShard, 0, shard, sizeof(shard)) ||
+            !connection->Send(Connection::Message::kModel, 0, model.data(), model.size()) ||
+            !connection->Send(Connection::Message::kWeights, 0, m_parameters.data(), m_parameters.size() * sizeof(double)))
+            return false;
+        
+        m_connections.push_back(std::move(connection));
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> servers;
+    
+    for (size_t worker = 0 ; worker < m_workers ; worker++)
+        servers.push_back(std::thread(&ParameterServer::Impl::Serve, this, worker));
+    
+    for (size_t worker = 0 ; worker < m_workers ; worker++)
+        servers[worker].join();
+    
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    m_network.ImportParameters(m_parameters);
+    
+    if (log)
+        std::cout
+        << std::fixed << std::setprecision(3)
+        << m_updates << " updates from " << m_workers << " workers in "
+        << elapsed.count() << " seconds\n";
+    
+    return true;
+}
+
+void ParameterServer::Impl::Serve(size_t worker) {
+    
+    Connection& connection = *m_connections[worker];
+    std::vector<char> payload;
+    std::vector<double> reply;
+    
+    while (true) {
+        
+        Connection::Message type;
+        uint32_t step;
+        
+        //A worker that is done (or lost) must not hold the others back
+        if (!connection.Receive(type, step, payload) ||
+            type != Connection::Message::kPush ||
+            payload.size() != m_parameters.size() * sizeof(double)) {
+            
+            std::lock_guard<std::mutex> lock(m_mutex);
+            Leave(worker);
+            return;
+        }
+        
+        const double* changes = reinterpret_cast<const double*>(payload.data());
+        
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            
+            if (m_staleness == 0) {
+                
+                for (size_t index = 0, total = m_changes.size() ; index < total ; index++)
+                    m_changes[index] += changes[index];
+                
+                m_pushed++;
+                CompleteStep();
+                
+                m_changed.wait(lock, [this, step]() { return m_step > step; });
+            }
+            else {
+                
+                for (size_t index = 0, total = m_parameters.size() ; index < total ; index++)
+                    m_parameters[index] += changes[index];
+                
+                m_updates++;
+                m_clocks[worker] = step + 1;
+                m_changed.notify_all();
+                
+                m_changed.wait(lock, [this, worker]() { return m_clocks[worker] <= Slowest(m_clocks[worker]) + m_staleness; });
+            }
+            
+            reply = m_parameters;
+        }
+        
+        //The weights are copied so that they are sent without the lock
+        if (!connection.Send(Connection::Message::kWeights, step + 1, reply.data(), reply.size() * sizeof(double))) {
+            
+            std::lock_guard<std::mutex> lock(m_mutex);
+            Leave(worker);
+            return;
+        }
+    }
+}
+
+void ParameterServer::Impl::Leave(size_t worker) {
+    
+    m_done[worker] = true;
+    
+    if (m_staleness == 0)
+        CompleteStep();
+    
+    m_changed.notify_all();
+}
+
+void ParameterServer::Impl::CompleteStep() {
+    
+    size_t active = std::count(m_done.begin(), m_done.end(), false);
+    
+    if (m_pushed == 0 || m_pushed < active)
+        return;
+    
+    //The average of the changes, as if the records of all the workers were a single batch
+    for (size_t index = 0, total = m_parameters.size() ; index < total ; index++) {
+        
+        m_parameters[index] += m_changes[index] / m_pushed;
+        m_changes[index] = 0.0;
+    }
+    
+    m_pushed = 0;
+    m_step++;
+    m_updates++;
+    m_changed.notify_all();
+}
+
+uint32_t ParameterServer::Impl::Slowest(uint32_t fallback) const {
+    
+    uint32_t slowest = fallback;
+    
+    for (size_t worker = 0 ; worker < m_workers ; worker++)
+        if (!m_done[worker])
+            slowest = std::min(slowest, m_clocks[worker]);
+    
+    return slowest;
+}
+
+#pragma mark - ParameterServer functions
+
+ParameterServer::ParameterServer(OperationalNetwork& network, const std::string& address, size_t workers, size_t staleness) :
+m_pimpl(new Impl(network, address, workers, staleness))
+{ }
+
+ParameterServer::~ParameterServer() { };
+
+bool ParameterServer::Run(bool log) {
+    return m_pimpl->Run(log);
+}
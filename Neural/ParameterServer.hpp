@@ -0,0 +1,70 @@
+//
+//  ParameterServer.hpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#ifndef ParameterServer_hpp
+#define ParameterServer_hpp
+#include "Definitions.h"
+#include <string>
+#include <memory>
+NAMESPACE_NEURAL_BEGIN
+class OperationalNetwork;
+
+/**
+ * Holds the weights of a network while worker processes (see
+ * 'ParameterWorker') train copies of it, each on it's own shard of
+ * the data. Every step a worker sends the change that a mini-batch
+ * made to it's copy, and receives the current weights back.
+ *
+ * With a staleness of 0 the training is synchronous: the server waits
+ * for the changes of every worker, applies their average and only then
+ * replies, which is the same as a single mini-batch of all the records
+ * of the step. Otherwise every change is applied as it arrives, and a
+ * worker waits only when it is more than 'staleness' steps ahead of the
+ * slowest worker (bounded staleness).
+ */
+class ParameterServer {
+public:
+    
+    /**
+     * Constructor.
+     *
+     * @param network       The network to train, which holds the result once 'Run' returns.
+     * @param address       The address to listen on, "unix:<path>" or "<host>:<port>".
+     * @param workers       The number of workers, the data is split between them.
+     * @param staleness     The number of steps that a worker may be ahead of the slowest one,
+     *                      0 for synchronous training.
+     */
+    ParameterServer(OperationalNetwork& network,
+                    const std::string& address,
+                    size_t workers,
+                    size_t staleness = 0);
+    
+    /**
+     * Waits for all the workers to connect, hands each it's shard and
+     * the network, and serves their steps until they are all done.
+     *
+     * @param log   Flag that indicates to print the progress to consule.
+     * @return True if the workers were served, false if the address
+     *         could not be listened on or a worker could not be reached.
+     */
+    bool Run(bool log = true);
+    
+    /**
+     * Destructor.
+     */
+    ~ParameterServer();
+    
+private:
+    
+    class Impl;
+    std::unique_ptr<Impl> m_pimpl;
+    
+};
+
+NAMESPACE_NEURAL_END
+#endif /* ParameterServer_hpp */
@@ -0,0 +1,264 @@
+//
+//  ParameterWorker.cpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#include "ParameterWorker.hpp"
+#include "OperationalNetwork.hpp"
+#include "Connection.hpp"
+#include "DataIterator.hpp"
+#include "Data.hpp"
+#include <vector>
+#include <sstream>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <string.h>
+#include <math.h>
+
+using namespace neural;
+
+/**
+ * Implementation.
+ */
+class ParameterWorker::Impl {
+public:
+    
+    /**
+     * Constructor.
+     *
+     * @param address   The address of the server.
+     */
+    Impl(const std::string& address);
+    
+    /**
+     * Returns true if the worker received it's shard and network.
+     *
+     * @return The state of the worker.
+     */
+    bool Connected() const { return m_network != NULL; }
+    
+    /**
+     * Trains on the shard of the worker.
+     *
+     * @param data_file_path    The path to the data file.
+     * @param key_file_path     The path to the key file.
+     * @param batch_size        The number of records of every step.
+     * @param log               Flag that indicates to print the times of the steps.
+     * @return True if all the steps were exchanged with the server.
+     */
+    bool Train(const std::string& data_file_path, const std::string& key_file_path, size_t batch_size, bool log);
+    
+private:
+    
+    /**
+     * Sends the change of a step and replaces the weights of the copy
+     * with the weights of the server.
+     *
+     * @param step          The number of the step.
+     * @param changes       The change that the step made to the weights.
+     * @param parameters    Receives the weights of the server.
+     * @return True if the exchange succeeded.
+     */
+    bool Exchange(uint32_t step, const std::vector<double>& changes, std::vector<double>& parameters);
+    
+    ///Stores the connection to the server
+    std::unique_ptr<Connection> m_connection;
+    
+    ///Stores the copy of the network, NULL until it is received
+    std::unique_ptr<OperationalNetwork> m_network;
+    
+    ///Stores the index of the shard of the worker
+    size_t m_shard;
+    
+    ///Stores the number of shards that the data is split into
+    size_t m_shards;
+    
+    ///Stores the last message from the server
+    std::vector<char> m_payload;
+    
+};
+
+#pragma mark - Implementation
+
+ParameterWorker::Impl::Impl(const std::string& address) :
+m_connection(Connection::Connect(address)),
+m_shard(0),
+m_shards(1) {
+    
+    if (!m_connection)
+        return;
+    
+    Connection::Message type;
+    uint32_t step;
+    
+    //The shard comes first, then the network in it's serialized form and it's exact weights
+    if (!m_connection->Receive(type, step, m_payload) || type != Connection::Message::kShard || m_payload.size() != 2 * sizeof(uint64_t))
+        return;
+    
+    uint64_t shard[2];
+    memcpy(shard, m_payload.data(), sizeof(shard));
+    m_shard = shard[0];
+    m_shards = shard[1];
+    
+    if (!m_connection->Receive(type, step, m_payload) || type != Connection::Message::kModel)
+        return;
+    
+    std::istringstream serialized(std::string(m_payload.begin(), m_payload.end()));
+    std::unique_ptr<OperationalNetwork> network(new OperationalNetwork(serialized));
+    
+    if (!network->Valid())
+        return;
+    
+    /*
+     * The serialized form rounds the weights to six decimals, so the
+     * change of the first step would be measured from other weights
+     * than the ones that the server adds it to.
+     */
+    std::vector<double> parameters;
+    network->ExportParameters(parameters);
+    
+    if (!m_connection->Receive(type, step, m_payload) || type != Connection::Message::kWeights || m_payload.size() != parameters.size() * sizeof(double))
+        return;
+    
+    memcpy(parameters.data(), m_payload.data(), m_payload.size());
+    network->ImportParameters(parameters);
+    
+    m_network = std::move(network);
+}
+
+bool ParameterWorker::Impl::Exchange(uint32_t step, const std::vector<double>& changes, std::vector<double>& parameters) {
+    
+    Connection::Message type;
+    uint32_t reply_step;
+    
+    if (!m_connection->Send(Connection::Message::kPush, step, changes.data(), changes.size() * sizeof(double)) ||
+        !m_connection->Receive(type, reply_step, m_payload) ||
+        type != Connection::Message::kWeights ||
+        m_payload.size() != parameters.size() * sizeof(double))
+        return false;
+    
+    memcpy(parameters.data(), m_payload.data(), m_payload.size());
+    return true;
+}
+
+bool ParameterWorker::Impl::Train(const std::string& data_file_path, const std::string& key_file_path, size_t batch_size, bool log) {
+    
+    if (!m_network)
+        return false;
+    
+    batch_size = std::max<size_t>(batch_size, 1);
+    
+    //The shard of the worker, reached by skipping the lines before it
+    size_t all_records = RecordsInFile(key_file_path);
+    size_t begin = all_records * m_shard / m_shards;
+    size_t end = all_records * (m_shard + 1) / m_shards;
+    size_t steps = (end - begin + batch_size - 1) / batch_size;
+    
+    DataIterator data(data_file_path), results(key_file_path);
+    
+    for (size_t index = 0 ; index < begin && data.Valid() && results.Valid() ; index++) {
+        
+        data.Next();
+        results.Next();
+    }
+    
+    std::vector<Data> batch_data;
+    std::vector<size_t> batch_keys;
+    batch_data.reserve(batch_size);
+    batch_keys.reserve(batch_size);
+    
+    //The weights before the step, and the change that the step made to them
+    std::vector<double> parameters;
+    std::vector<double> changes;
+    m_network->ExportParameters(parameters);
+    
+    double compute_seconds = 0.0;
+    double communication_seconds = 0.0;
+    double slowest_communication = 0.0;
+    uint32_t step = 0;
+    bool succeeded = true;
+    
+    if (log) { std::cout << std::fixed << std::setprecision(3); }
+    
+    for (size_t index = begin ; index < end && data.Valid() && results.Valid() && succeeded ; ) {
+        
+        batch_data.clear();
+        batch_keys.clear();
+        
+        for ( ; index < end && batch_data.size() < batch_size && data.Valid() && results.Valid() ; index++, data.Next(), results.Next()) {
+            
+            batch_data.push_back(data.Value());
+            batch_keys.push_back(static_cast<size_t>(lround(results.Value().content.front())));
+        }
+        
+        auto start = std::chrono::steady_clock::now();
+        
+        m_network->TrainBatch(batch_data, batch_keys);
+        m_network->ExportParameters(changes);
+        
+        for (size_t parameter = 0, total = changes.size() ; parameter < total ; parameter++)
+            changes[parameter] -= parameters[parameter];
+        
+        auto computed = std::chrono::steady_clock::now();
+        
+        succeeded = Exchange(step, changes, parameters);
+        
+        auto exchanged = std::chrono::steady_clock::now();
+        
+        if (succeeded) {
+            
+            m_network->ImportParameters(parameters);
+            
+            //Read back what the copy holds, so that a float network does not send it's rounding as a change
+            m_network->ExportParameters(parameters);
+        }
+        
+        std::chrono::duration<double> compute = computed - start;
+        std::chrono::duration<double> communication = exchanged - computed;
+        
+        compute_seconds += compute.count();
+        communication_seconds += communication.count();
+        slowest_communication = std::max(slowest_communication, communication.count());
+        
+        if (log && step % std::max<size_t>(steps / 100, 1) == 0)
+            std::cout
+            << "step " << step << ":\t"
+            << "compute " << compute.count() * 1000 << " ms\t"
+            << "communication " << communication.count() * 1000 << " ms\n";
+        
+        step++;
+    }
+    
+    m_connection->Send(Connection::Message::kDone, step, NULL, 0);
+    
+    if (log && step > 0)
+        std::cout
+        << "worker " << m_shard << ":\t"
+        << step << " steps\t"
+        << "compute " << compute_seconds * 1000 / step << " ms/step\t"
+        << "communication " << communication_seconds * 1000 / step << " ms/step (slowest " << slowest_communication * 1000 << " ms)\t"
+        << 2 * parameters.size() * sizeof(double) << " bytes/step\n";
+    
+    return succeeded;
+}
+
+#pragma mark - ParameterWorker functions
+
+ParameterWorker::ParameterWorker(const std::string& address) :
+m_pimpl(new Impl(address))
+{ }
+
+ParameterWorker::~ParameterWorker() { };
+
+bool ParameterWorker::Connected() const {
+    return m_pimpl->Connected();
+}
+
+bool ParameterWorker::Train(const std::string& data_file_path, const std::string& key_file_path, size_t batch_size, bool log) {
+    return m_pimpl->Train(data_file_path, key_file_path, batch_size, log);
+}
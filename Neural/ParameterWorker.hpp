@@ -0,0 +1,69 @@
+//
+//  ParameterWorker.hpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#ifndef ParameterWorker_hpp
+#define ParameterWorker_hpp
+#include "Definitions.h"
+#include <string>
+#include <memory>
+NAMESPACE_NEURAL_BEGIN
+
+/**
+ * Trains a copy of the network of a 'ParameterServer' on a shard of
+ * the data, exchanging the changes of every mini-batch (a step) for the
+ * weights of the server.
+ */
+class ParameterWorker {
+public:
+    
+    /**
+     * Constructor. Connects to the server and receives the shard of
+     * the worker and the network.
+     *
+     * @param address   The address of the server, "unix:<path>" or "<host>:<port>".
+     */
+    ParameterWorker(const std::string& address);
+    
+    /**
+     * Returns true if the worker received it's shard and network.
+     *
+     * @return The state of the worker.
+     */
+    bool Connected() const;
+    
+    /**
+     * Trains on the shard of the worker, a contiguous part of the file.
+     * The time of every step is split between the computation (training
+     * the copy) and the communication (sending the change and waiting
+     * for the weights, which includes waiting for the other workers).
+     *
+     * @param data_file_path    The path to the file containing the pixel data.
+     * @param key_file_path     The path to the file containing the results of the data file.
+     * @param batch_size        The number of records of every step.
+     * @param log               Flag that indicates to print the times of the steps to consule.
+     * @return True if all the steps were exchanged with the server.
+     */
+    bool Train(const std::string& data_file_path,
+               const std::string& key_file_path,
+               size_t batch_size,
+               bool log = true);
+    
+    /**
+     * Destructor.
+     */
+    ~ParameterWorker();
+    
+private:
+    
+    class Impl;
+    std::unique_ptr<Impl> m_pimpl;
+    
+};
+
+NAMESPACE_NEURAL_END
+#endif /* ParameterWorker_hpp */
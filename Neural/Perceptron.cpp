@@ -7,91 +7,123 @@
 //
 
 #include "Perceptron.hpp"
-#include <math.h>
+#include "Kernels.hpp"
 #include <string>
+#include <charconv>
+#include <algorithm>
 
-NAMESPACE_NEURAL_BEGIN
+using namespace neural;
 
-inline double ActivationFunction(double value) {
-    
-    //Sigmoid function
-    return 1/(1 + exp(-value));
+/**
+ * Parses a number that ends at a delimiter and moves past the delimiter.
+ * Numbers are parsed as doubles (as 'std::stod' does) before they are
+ * converted to the scalar type, so the results are identical.
+ *
+ * @param position      The position of the number, moved past the delimiter.
+ * @param end           The end of the buffer.
+ * @param delimiter     The delimiter that follows the number.
+ * @param value         Receives the number.
+ * @return True if a number was read and the delimiter follows it right away.
+ */
+template <typename Value>
+static bool Parse(const char*& position, const char* end, char delimiter, Value& value) {
+    
+    std::from_chars_result result = std::from_chars(position, end, value);
+    
+    //Anything between the number and the delimiter would be skipped into the next lines
+    if (result.ec != std::errc() || result.ptr == end || *result.ptr != delimiter)
+        return false;
+    
+    position = result.ptr + 1;
+    return true;
 }
 
-NAMESPACE_NEURAL_END
-
-using namespace neural;
-
-Perceptron::Perceptron(size_t weights_count, double learning_constant, double bias) :
-m_learning_constant(learning_constant),
+template <typename Scalar>
+Perceptron<Scalar>::Perceptron(Scalar* weights, size_t weights_count, Scalar& bias, Scalar& learning_constant) :
+m_weights(weights),
+m_weights_count(weights_count),
 m_bias(bias),
-m_generator(-1.0, 1.0) {
+m_learning_constant(learning_constant)
+{ }
     
-    m_weights.reserve(weights_count);
+template <typename Scalar>
+bool Perceptron<Scalar>::WeightsCount(const std::string& serialized, size_t& count) {
+    return WeightsCount(serialized.data(), serialized.data() + serialized.size(), count);
+}
+
+template <typename Scalar>
+bool Perceptron<Scalar>::WeightsCount(const char* serialized, const char* end, size_t& count) {
+    
+    //The weight count is the third field
+    double value;
     
-    //Fill the weights with random numbers between -1 and 1
-    for (size_t index = 0 ; index < weights_count ; index++)
-        m_weights.push_back(m_generator.Random());
+    return Parse(serialized, end, ':', value) && Parse(serialized, end, ':', value) && Parse(serialized, end, ':', count);
 }
 
-Perceptron::Perceptron(const std::string& serialized) {
+template <typename Scalar>
+bool Perceptron<Scalar>::Deserialize(const std::string& serialized) {
     
-    //Deserialize manually
-    size_t delimiter_index = serialized.find_first_of(':');
-    m_bias = std::stod(std::string(serialized.begin(), serialized.begin() + delimiter_index));
+    const char* end = serialized.data() + serialized.size();
+    return Deserialize(serialized.data(), end) == end;
+}
     
-    size_t last_delimiter_index = delimiter_index + 1;
-    delimiter_index = serialized.find_first_of(':', delimiter_index + 1);
-    m_learning_constant = std::stod(std::string(serialized.begin() + last_delimiter_index, serialized.begin() + delimiter_index));
+template <typename Scalar>
+const char* Perceptron<Scalar>::Deserialize(const char* serialized, const char* end) {
     
-    last_delimiter_index = delimiter_index + 1;
-    delimiter_index = serialized.find_first_of(':', delimiter_index + 1);
-    size_t weights_count = std::stoul(std::string(serialized.begin() + last_delimiter_index, serialized.begin() + delimiter_index));
-    m_weights.reserve(weights_count);
+    //Deserialize manually, the numbers are read where they are
+    double value;
     
-    for (size_t index = 0 ; index < weights_count ; index++) {
-        
-        last_delimiter_index = delimiter_index + 1;
-        delimiter_index = serialized.find_first_of(',', delimiter_index + 1);
-        double weight_value = std::stod(std::string(serialized.begin() + last_delimiter_index, serialized.begin() + delimiter_index));
-        m_weights.push_back(weight_value);
-        
-    }
-}
-
-double Perceptron::Feed(const std::vector<double> &input) const {
+    if (!Parse(serialized, end, ':', value))
+        return NULL;
+    
+    m_bias = static_cast<Scalar>(value);
+    
+    if (!Parse(serialized, end, ':', value))
+        return NULL;
     
-    double sum = 0.0;
+    m_learning_constant = static_cast<Scalar>(value);
     
-    for (size_t index = 0 ; index < m_weights.size() ; index++)
-        sum += m_weights[index] * input[index];
+    //The row was sized by the layer, so the weight count has to match it
+    size_t weights_count;
     
-    sum += m_bias;
+    if (!Parse(serialized, end, ':', weights_count) || weights_count != m_weights_count)
+        return NULL;
     
-    return ActivationFunction(sum);
+    for (size_t index = 0 ; index < m_weights_count ; index++) {
+        
+        if (!Parse(serialized, end, ',', value))
+            return NULL;
+        
+        m_weights[index] = static_cast<Scalar>(value);
+    }
+        
+    return serialized;
 }
 
-void Perceptron::Train(double delta, const std::vector<double> &omicron) {
+template <typename Scalar>
+void Perceptron<Scalar>::Train(Scalar delta, const Scalar* omicron) {
     
-    for (size_t index = 0, total = m_weights.size() ; index < total ; index++)
-        m_weights[index] += -m_learning_constant * delta * omicron[index];
+    ActiveKernels<Scalar>().axpy(-m_learning_constant * delta, omicron, m_weights, m_weights_count);
     
     //Find it there is a bias and update it accordingly
     m_bias += -m_learning_constant * delta;
     
 }
 
-std::string Perceptron::Serialize() const {
+template <typename Scalar>
+std::string Perceptron<Scalar>::Serialize() const {
     
     //Serialize by order of: bias - learning constant - weight count - weights
     std::string serialized =  std::to_string(static_cast<long double>(m_bias)) +
     ':' + std::to_string(static_cast<long double>(m_learning_constant)) +
-    ':' + std::to_string(static_cast<unsigned long long>(m_weights.size())) +
+    ':' + std::to_string(static_cast<unsigned long long>(m_weights_count)) +
     ':';
     
-    for (size_t index = 0, total = m_weights.size() ; index < total ; index++)
+    for (size_t index = 0 ; index < m_weights_count ; index++)
         serialized += std::to_string(static_cast<long double>(m_weights[index])) + ',';
     
     return serialized;
 }
 
+template class neural::Perceptron<double>;
+template class neural::Perceptron<float>;
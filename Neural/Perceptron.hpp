@@ -9,40 +9,31 @@
 #ifndef Perceptron_hpp
 #define Perceptron_hpp
 #include "Definitions.h"
-#include "RandomGenerator.hpp"
-#include <vector>
+#include <string>
 #include <stdio.h>
+#include <math.h>
 NAMESPACE_NEURAL_BEGIN
-class Network;
 
+/**
+ * A perceptron is a view over a single row of a layer.
+ * The layer owns the weights (all of the perceptrons in a
+ * layer share one contiguous matrix), while the perceptron
+ * gives access to the weights of a single neuron.
+ */
+template <typename Scalar>
 class Perceptron {
 public:
     
     /**
      * Constructor.
      *
-     * @param weights_count         Number of weights that the perceptron will have.
+     * @param weights               The row of weights that belongs to the perceptron.
+     * @param weights_count         Number of weights that the perceptron has.
+     * @param bias                  The bias of the perceptron.
      * @param learning_constant     The learning rate for weights adjustments.
      */
-    Perceptron(size_t weights_count, double learning_constant = 0.01, double bias = 1.0);
+    Perceptron(Scalar* weights, size_t weights_count, Scalar& bias, Scalar& learning_constant);
     
-    /**
-     * Constructor.
-     *
-     * @param serialized The serialized perceptron.
-     */
-    Perceptron(const std::string& serialized);
-    
-    /**
-     * Recieves input and returns the the sum.
-     *
-     * @param input     The input to calculate (either all of the previous perceptron's 
-     *                  results or the input data).
-     *
-     * @return The value that the perceptron has given this input.
-     */
-    double Feed(const std::vector<double>& input) const;
-
     /**
      * Trains the perceptron according to the given learning
      * constant (eta), the delta of the current layer and the
@@ -51,7 +42,7 @@ public:
      * @param delta The delta of the current layer (depends on hidden or output layer).
      * @param omicron The omicron (output) of the previous layer.
      */
-    void Train(double delta, const std::vector<double>& omicron);
+    void Train(Scalar delta, const Scalar* omicron);
     
     /**
      * Outputs the perceptron into a format that can later
@@ -61,17 +52,68 @@ public:
      */
     std::string Serialize() const;
     
-    //The random generator.
-    RandomGenerator m_generator;
+    /**
+     * Loads the values of a serialized perceptron into the
+     * viewed row. The row must have room for all of the weights.
+     *
+     * @param serialized The serialized perceptron.
+     * @return True if the perceptron was read, false if it is malformed
+     *         or has another number of weights than the row.
+     */
+    bool Deserialize(const std::string& serialized);
+    
+    /**
+     * Loads the values of a serialized perceptron from a buffer, in
+     * place. The values are the same as those of the string version.
+     *
+     * @param serialized    The beginning of the serialized perceptron.
+     * @param end           The end of the buffer.
+     * @return The position after the last weight, or NULL if the
+     *         perceptron is malformed or has another number of weights
+     *         than the row.
+     */
+    const char* Deserialize(const char* serialized, const char* end);
+    
+    /**
+     * Reads the number of weights that a serialized perceptron has.
+     *
+     * @param serialized The serialized perceptron.
+     * @param count      Receives the number of weights.
+     * @return True if the number could be read.
+     */
+    static bool WeightsCount(const std::string& serialized, size_t& count);
+    
+    /**
+     * Reads the number of weights that a serialized perceptron has.
+     *
+     * @param serialized    The beginning of the serialized perceptron.
+     * @param end           The end of the buffer.
+     * @param count         Receives the number of weights.
+     * @return True if the number could be read.
+     */
+    static bool WeightsCount(const char* serialized, const char* end, size_t& count);
+    
+    /**
+     * Returns the weight at a given index.
+     *
+     * @param index The index of the weight.
+     * @return The weight's value.
+     */
+    Scalar Weight(size_t index) const { return m_weights[index]; }
     
-    //Holds the weights.
-    std::vector<double> m_weights;
+private:
     
-    ///Stores the learning constant.
-    double m_learning_constant;
+    ///Holds the weights.
+    Scalar* m_weights;
+    
+    ///Stores the number of weights.
+    size_t m_weights_count;
     
     ///Stores the bias
-    double m_bias;
+    Scalar& m_bias;
+    
+    ///Stores the learning constant.
+    Scalar& m_learning_constant;
     
 };
 
@@ -0,0 +1,314 @@
+//
+//  QuantizedNetwork.cpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#include "QuantizedNetwork.hpp"
+#include "AlignedAllocator.hpp"
+#include "Layer.hpp"
+#include "Data.hpp"
+#include "Kernels.hpp"
+#include <sstream>
+#include <algorithm>
+#include <math.h>
+
+using namespace neural;
+
+/**
+ * Converts a value to the nearest unsigned 7 bit step of a scale,
+ * counted from the step that stands for zero.
+ *
+ * @param value     The value to convert.
+ * @param inverse   The inverse of the value of a single step.
+ * @param zero      The step that stands for zero.
+ * @return The number of steps, between 0 and 127.
+ */
+static inline uint8_t QuantizeInput(float value, float inverse, float zero) {
+    
+    //Rounds by truncation, which is correct since values below step 0 are clamped anyway
+    float step = std::min(127.0f, std::max(0.0f, value * inverse + zero + 0.5f));
+    return static_cast<uint8_t>(step);
+}
+
+/**
+ * Implementation.
+ */
+class QuantizedNetwork::Impl {
+public:
+    
+    /**
+     * Constructor.
+     *
+     * @param serialized    The serialized string that was given from a network.
+     */
+    Impl(const std::string& serialized);
+    
+    /**
+     * Records the range of the values that every layer receives.
+     *
+     * @param data  The data to process.
+     */
+    void Calibrate(const Data& data);
+    
+    /**
+     * Converts the weights to integers.
+     */
+    void Quantize();
+    
+    /**
+     * Gets a data to process and returns the result.
+     *
+     * @param data  The data to process.
+     * @return A vector containing all of the last layer's results.
+     */
+    const std::vector<float>& Feed(const Data& data) const;
+    
+    /**
+     * Returns the memory that the weights and biases occupy.
+     *
+     * @return The size in bytes.
+     */
+    size_t Bytes() const;
+    
+private:
+    
+    /**
+     * The integer weights of a single layer.
+     */
+    struct QuantizedLayer {
+        
+        ///The number of perceptrons (rows)
+        size_t size;
+        
+        ///The number of inputs (columns)
+        size_t connections;
+        
+        ///The distance between rows, padded to a cache line
+        size_t stride;
+        
+        ///The weights as steps of 'weights_scale', row after row
+        AlignedVector<int8_t> weights;
+        
+        ///The bias of every perceptron
+        std::vector<float> biases;
+        
+        ///The sum of the weights of every perceptron, to remove the zero step of the inputs
+        std::vector<int32_t> sums;
+        
+        ///The activation function of the perceptrons
+        ActivationType activation;
+        
+        ///The value of a single step of the weights
+        float weights_scale;
+        
+        ///The value of a single step of the inputs
+        float inputs_scale;
+        
+        ///The step of the inputs that stands for zero
+        int32_t inputs_zero;
+    };
+    
+    ///Stores the original layers until the network is quantized
+    std::vector<Layer<float> > m_layers;
+    
+    ///Stores the smallest input that every layer received while calibrating
+    std::vector<float> m_minimums;
+    
+    ///Stores the largest input that every layer received while calibrating
+    std::vector<float> m_maximums;
+    
+    ///Stores the quantized layers by order
+    std::vector<QuantizedLayer> m_quantized;
+    
+    ///Stores the number of values of the largest input or output of a layer
+    size_t m_largest_layer;
+    
+};
+
+#pragma mark - Implementation
+
+QuantizedNetwork::Impl::Impl(const std::string& serialized) :
+m_largest_layer(0) {
+    
+    //Read the layers in the same format as a network does, which wrote them
+    const char* position = serialized.data();
+    const char* end = position + serialized.size();
+    
+    while (position != end && *position != '\n') {
+        
+        m_layers.push_back(Layer<float>(0, 0));
+        
+        if (!Layer<float>::Deserialize(position, end, m_layers.back())) {
+            
+            m_layers.pop_back();
+            break;
+        }
+    }
+    
+    //The ranges always hold zero, so that it has an exact step
+    m_minimums.resize(m_layers.size(), 0.0f);
+    m_maximums.resize(m_layers.size(), 0.0f);
+}
+
+void QuantizedNetwork::Impl::Calibrate(const Data& data) {
+    
+    std::vector<float> input(data.content.begin(), data.content.end());
+    std::vector<float> output;
+    
+    for (size_t index = 0 ; index < m_layers.size() ; index++) {
+        
+        auto range = std::minmax_element(input.begin(), input.end());
+        m_minimums[index] = std::min(m_minimums[index], *range.first);
+        m_maximums[index] = std::max(m_maximums[index], *range.second);
+        
+        output.resize(m_layers[index].Size());
+        m_layers[index].Feed(input.data(), output.data());
+        input.swap(output);
+    }
+}
+
+void QuantizedNetwork::Impl::Quantize() {
+    
+    size_t largest_layer = 0;
+    m_quantized.resize(m_layers.size());
+    
+    for (size_t index = 0 ; index < m_layers.size() ; index++) {
+        
+        const Layer<float>& layer = m_layers[index];
+        QuantizedLayer& quantized = m_quantized[index];
+        
+        quantized.size = layer.Size();
+        quantized.connections = layer.Connections();
+        quantized.stride = AlignedStride<int8_t>(quantized.connections);
+        
+        //A single scale maps the largest weight of the layer to 127
+        float largest = 0.0f;
+        
+        for (size_t row = 0 ; row < quantized.size ; row++)
+            for (size_t column = 0 ; column < quantized.connections ; column++)
+                largest = std::max(largest, fabsf(layer.Weight(row, column)));
+        
+        quantized.weights_scale = (largest > 0.0f) ? largest / 127.0f : 1.0f;
+        
+        /*
+         * The inputs are activations between 0 and 1 unless the calibration
+         * saw otherwise. Inputs that can be negative (tanh, leaky ReLU) move
+         * the zero step up, which the sums of the weights take back out.
+         */
+        float range = m_maximums[index] - m_minimums[index];
+        quantized.inputs_scale = ((range > 0.0f) ? range : 1.0f) / 127.0f;
+        quantized.inputs_zero = static_cast<int32_t>(lroundf(-m_minimums[index] / quantized.inputs_scale));
+        quantized.activation = layer.Activation();
+        
+        quantized.weights.assign(quantized.size * quantized.stride, 0);
+        quantized.biases.resize(quantized.size);
+        quantized.sums.assign(quantized.size, 0);
+        
+        for (size_t row = 0 ; row < quantized.size ; row++) {
+            
+            for (size_t column = 0 ; column < quantized.connections ; column++) {
+                
+                int8_t weight = static_cast<int8_t>(lroundf(layer.Weight(row, column) / quantized.weights_scale));
+                quantized.weights[row * quantized.stride + column] = weight;
+                quantized.sums[row] += weight;
+            }
+            
+            quantized.biases[row] = layer.Bias(row);
+        }
+        
+        largest_layer = std::max(largest_layer, std::max(quantized.size, quantized.connections));
+    }
+    
+    m_largest_layer = largest_layer;
+    
+    //The original weights are no longer needed
+    std::vector<Layer<float> >().swap(m_layers);
+}
+
+const std::vector<float>& QuantizedNetwork::Impl::Feed(const Data& data) const {
+    
+    const QuantizedKernels& kernels = ActiveQuantizedKernels();
+    
+    //Every thread has it's own buffers, so that several threads can feed at once
+    static thread_local AlignedVector<uint8_t> inputs;
+    static thread_local std::vector<float> outputs;
+    
+    if (inputs.size() < m_largest_layer)
+        inputs.resize(m_largest_layer);
+    
+    const QuantizedLayer& first = m_quantized.front();
+    float inverse = 1.0f / first.inputs_scale;
+    float zero = static_cast<float>(first.inputs_zero);
+    
+    for (size_t index = 0 ; index < first.connections ; index++)
+        inputs[index] = QuantizeInput(data.content[index], inverse, zero);
+    
+    for (size_t index = 0 ; index < m_quantized.size() ; index++) {
+        
+        const QuantizedLayer& layer = m_quantized[index];
+        
+        //A step of the product is a step of the weights times a step of the inputs
+        float scale = layer.weights_scale * layer.inputs_scale;
+        outputs.resize(layer.size);
+        
+        for (size_t row = 0 ; row < layer.size ; row++) {
+            
+            int32_t sum = kernels.dot(inputs.data(), layer.weights.data() + row * layer.stride, layer.connections);
+            sum -= layer.inputs_zero * layer.sums[row];
+            outputs[row] = sum * scale + layer.biases[row];
+        }
+        
+        Activate(layer.activation, outputs.data(), layer.size);
+        
+        //The outputs are the inputs of the next layer
+        if (index + 1 < m_quantized.size()) {
+            
+            inverse = 1.0f / m_quantized[index + 1].inputs_scale;
+            zero = static_cast<float>(m_quantized[index + 1].inputs_zero);
+            
+            for (size_t row = 0 ; row < layer.size ; row++)
+                inputs[row] = QuantizeInput(outputs[row], inverse, zero);
+        }
+    }
+    
+    return outputs;
+}
+
+size_t QuantizedNetwork::Impl::Bytes() const {
+    
+    size_t bytes = 0;
+    
+    for (size_t index = 0 ; index < m_quantized.size() ; index++)
+        bytes += m_quantized[index].weights.size() * sizeof(int8_t)
+              + m_quantized[index].biases.size() * sizeof(float)
+              + m_quantized[index].sums.size() * sizeof(int32_t);
+    
+    return bytes;
+}
+
+#pragma mark - Quantized network functions
+
+QuantizedNetwork::QuantizedNetwork(const std::string& serialized) :
+m_pimpl(new Impl(serialized))
+{ }
+
+QuantizedNetwork::~QuantizedNetwork() { };
+
+void QuantizedNetwork::Calibrate(const Data& data) {
+    m_pimpl->Calibrate(data);
+}
+
+void QuantizedNetwork::Quantize() {
+    m_pimpl->Quantize();
+}
+
+const std::vector<float>& QuantizedNetwork::Feed(const Data& data) const {
+    return m_pimpl->Feed(data);
+}
+
+size_t QuantizedNetwork::Bytes() const {
+    return m_pimpl->Bytes();
+}
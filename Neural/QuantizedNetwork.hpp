@@ -0,0 +1,85 @@
+//
+//  QuantizedNetwork.hpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#ifndef QuantizedNetwork_hpp
+#define QuantizedNetwork_hpp
+#include "Definitions.h"
+#include <string>
+#include <vector>
+#include <memory>
+NAMESPACE_NEURAL_BEGIN
+class Data;
+
+/**
+ * An 8 bit integer copy of a trained network that is only used
+ * to estimate. The weights of every layer are stored as signed bytes
+ * with a single scale per layer, and the values that flow between
+ * the layers are stored as unsigned 7 bit values with a scale (and
+ * a step that stands for zero, for activations that can be negative)
+ * that are found by a calibration pass over sample data. Every perceptron
+ * is then an integer dot product, which moves an eighth of the memory
+ * of a network of doubles.
+ *
+ * The network is created from a serialized network, is calibrated on
+ * a few records and is then quantized. Only then can it be fed.
+ */
+class QuantizedNetwork {
+public:
+    
+    /**
+     * Constructor.
+     *
+     * @param serialized    The serialized string that was given from a network.
+     */
+    QuantizedNetwork(const std::string& serialized);
+    
+    /**
+     * Records the range of the values that every layer receives for the
+     * given data. Must be called before 'Quantize', with data that is
+     * conformed the same as the data that the network was trained on.
+     *
+     * @param data  The data to process.
+     */
+    void Calibrate(const Data& data);
+    
+    /**
+     * Converts the weights to integers according to the calibrated ranges
+     * and releases the original weights.
+     */
+    void Quantize();
+    
+    /**
+     * Gets a data to process and returns the result.
+     *
+     * @param data  The data to process.
+     * @return A vector containing all of the last layer's results, which
+     *         is valid until the next call on the same thread.
+     */
+    const std::vector<float>& Feed(const Data& data) const;
+    
+    /**
+     * Returns the memory that the weights and biases occupy.
+     *
+     * @return The size in bytes.
+     */
+    size_t Bytes() const;
+    
+    /**
+     * Destructor.
+     */
+    ~QuantizedNetwork();
+    
+private:
+    
+    class Impl;
+    std::unique_ptr<Impl> m_pimpl;
+    
+};
+
+NAMESPACE_NEURAL_END
+#endif /* QuantizedNetwork_hpp */
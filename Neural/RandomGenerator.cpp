@@ -12,6 +12,9 @@
 
 using namespace neural;
 
+///Stores true once a fixed seed was given
+static bool s_seeded = false;
+
 /**
  * Implementation.
  */
@@ -58,13 +61,14 @@ RandomGenerator::Impl::Impl(double start, double end) :
 m_start(start),
 m_end(end){
 
-    srand(time(NULL));
+    if (!s_seeded)
+        srand(time(NULL));
 
 }
 
 double RandomGenerator::Impl::Random() {
 //    return m_uniform_distribution(m_generator);
-    return ((double)rand() / (double)RAND_MAX) * 2 - 1;
+    return ((double)rand() / (double)RAND_MAX) * (m_end - m_start) + m_start;
 }
 
 #pragma mark - RandomGenerator
@@ -78,3 +82,9 @@ RandomGenerator::~RandomGenerator() { };
 double RandomGenerator::Random() {
     return m_pimpl->Random();
 }
+
+void RandomGenerator::Seed(unsigned int seed) {
+    
+    srand(seed);
+    s_seeded = true;
+}
@@ -31,6 +31,15 @@ public:
      */
     double Random();
     
+    /**
+     * Seeds all the generators with a fixed value, so that the networks
+     * that are created from then on start with the same weights on every
+     * run. Without it the generators are seeded by the time.
+     *
+     * @param seed  The seed.
+     */
+    static void Seed(unsigned int seed);
+    
     /**
      * Destructor.
      */
@@ -0,0 +1,358 @@
+//
+//  RecordFile.cpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#include "RecordFile.hpp"
+#include "DataIterator.hpp"
+#include "Data.hpp"
+#include "AlignedAllocator.hpp"
+#include <fstream>
+#include <vector>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace neural;
+
+///The string that every binary record file begins with
+static const char kMagic[8] = { 'N', 'E', 'U', 'R', 'A', 'L', 'B', 'D' };
+
+///Written in the byte order of the host, a file from a host of the other order reads it reversed
+static const uint32_t kByteOrder = 0x01020304;
+
+///The version of the format, changed whenever the layout changes
+static const uint32_t kVersion = 1;
+
+/**
+ * The header of the file, a cache line.
+ */
+struct Header {
+    
+    ///The magic string
+    char magic[8];
+    
+    ///The byte order of the host that wrote the file
+    uint32_t byte_order;
+    
+    ///The version of the format
+    uint32_t version;
+    
+    ///The number of records
+    uint64_t records;
+    
+    ///The number of values in every record
+    uint32_t width;
+    
+    ///The size of every value in bytes, always 1
+    uint32_t value_size;
+    
+    uint8_t reserved[32];
+};
+
+static_assert(sizeof(Header) == NEURAL_ALIGNMENT, "The header must be a cache line");
+
+///The type code of unsigned bytes in the magic number of an IDX file
+static const uint8_t kIdxUnsignedByte = 0x08;
+
+///The most dimensions that an IDX file of records has (images of rows and columns)
+static const uint8_t kIdxMaxDimensions = 3;
+
+/**
+ * Returns true if the bytes begin as an IDX file: two zero bytes, the
+ * type code of the values and the number of dimensions.
+ *
+ * @param magic     The first 4 bytes of the file.
+ * @return True if the bytes are the magic number of an IDX file.
+ */
+static bool IsIdx(const uint8_t* magic) {
+    
+    //The type codes are unsigned and signed bytes, shorts, ints, floats and doubles
+    return magic[0] == 0 && magic[1] == 0 &&
+    (magic[2] == kIdxUnsignedByte || (magic[2] >= 0x09 && magic[2] <= 0x0E && magic[2] != 0x0A)) &&
+    magic[3] >= 1 && magic[3] <= kIdxMaxDimensions;
+}
+
+/**
+ * Reads a big endian integer, as the sizes of an IDX file are stored.
+ *
+ * @param bytes     The 4 bytes of the integer.
+ * @return The integer.
+ */
+static uint32_t ReadBigEndian(const uint8_t* bytes) {
+    return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) | (static_cast<uint32_t>(bytes[2]) << 8) | bytes[3];
+}
+
+/**
+ * Implementation.
+ */
+class RecordFile::Impl {
+public:
+    
+    /**
+     * Constructor.
+     */
+    Impl();
+    
+    /**
+     * Maps the file and validates it.
+     *
+     * @param path  The path to the file.
+     * @return True if the file is a valid record file.
+     */
+    bool Map(const std::string& path);
+    
+    /**
+     * Returns the values of a record.
+     *
+     * @param index     The index of the record.
+     * @return The values.
+     */
+    const uint8_t* Record(size_t index) const { return m_data + m_offset + index * m_width; }
+    
+    /**
+     * Returns the number of records.
+     *
+     * @return The number of records.
+     */
+    size_t Records() const { return m_records; }
+    
+    /**
+     * Returns the number of values in every record.
+     *
+     * @return The number of values.
+     */
+    size_t Width() const { return m_width; }
+    
+    /**
+     * Destructor.
+     */
+    ~Impl();
+    
+private:
+    
+    /**
+     * Reads the header of a binary record file.
+     *
+     * @return True if the header is valid.
+     */
+    bool ReadHeader();
+    
+    /**
+     * Reads the header of an IDX file, whose first dimension is the
+     * number of records and the others make up a record.
+     *
+     * @return True if the header is valid.
+     */
+    bool ReadIdxHeader();
+    
+    ///Stores the mapped file, NULL until it is mapped
+    uint8_t* m_data;
+    
+    ///Stores the size of the mapping
+    size_t m_size;
+    
+    ///Stores the offset of the first record
+    size_t m_offset;
+    
+    ///Stores the number of records
+    size_t m_records;
+    
+    ///Stores the number of values in every record
+    size_t m_width;
+    
+};
+
+#pragma mark - Implementation
+
+RecordFile::Impl::Impl() :
+m_data(NULL),
+m_size(0),
+m_offset(0),
+m_records(0),
+m_width(0)
+{ }
+
+RecordFile::Impl::~Impl() {
+    
+    if (m_data)
+        munmap(m_data, m_size);
+}
+
+bool RecordFile::Impl::Map(const std::string& path) {
+    
+    int file = open(path.c_str(), O_RDONLY);
+    
+    if (file < 0)
+        return false;
+    
+    struct stat status;
+    
+    if (fstat(file, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(kMagic))) {
+        
+        close(file);
+        return false;
+    }
+    
+    //The records are only read, and in order
+    void* mapping = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    
+    if (mapping == MAP_FAILED)
+        return false;
+    
+    madvise(mapping, status.st_size, MADV_SEQUENTIAL);
+    
+    m_data = static_cast<uint8_t*>(mapping);
+    m_size = status.st_size;
+    
+    /*
+     * The records are not checksummed, since that would read the whole
+     * file every time it is opened. The size of the file must match the
+     * header, so that a record never reads past the mapping.
+     */
+    return (IsIdx(m_data)) ? ReadIdxHeader() : ReadHeader();
+}
+
+bool RecordFile::Impl::ReadHeader() {
+    
+    if (m_size < sizeof(Header))
+        return false;
+    
+    const Header& header = *reinterpret_cast<const Header*>(m_data);
+    
+    m_offset = sizeof(Header);
+    m_records = header.records;
+    m_width = header.width;
+    
+    return memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+    header.byte_order == kByteOrder &&
+    header.version == kVersion &&
+    header.value_size == sizeof(uint8_t) &&
+    m_width > 0 &&
+    m_records == (m_size - m_offset) / m_width &&
+    (m_size - m_offset) % m_width == 0;
+}
+
+bool RecordFile::Impl::ReadIdxHeader() {
+    
+    //Only bytes are read, as the pixels and labels of MNIST are
+    size_t dimensions = m_data[3];
+    m_offset = 4 + 4 * dimensions;
+    
+    if (m_data[2] != kIdxUnsignedByte || m_size < m_offset)
+        return false;
+    
+    m_records = ReadBigEndian(m_data + 4);
+    m_width = 1;
+    
+    //A record larger than the file is rejected before the product can overflow
+    for (size_t dimension = 1 ; dimension < dimensions && m_width <= m_size ; dimension++)
+        m_width *= ReadBigEndian(m_data + 4 + 4 * dimension);
+    
+    return m_width > 0 && m_width <= m_size && m_records == (m_size - m_offset) / m_width && (m_size - m_offset) % m_width == 0;
+}
+
+#pragma mark - RecordFile functions
+
+RecordFile::RecordFile() :
+m_pimpl(new Impl())
+{ }
+
+RecordFile::~RecordFile() { };
+
+bool RecordFile::Recognize(const std::string& path) {
+    
+    char magic[sizeof(kMagic)];
+    std::ifstream file(path, std::ios::binary);
+    
+    //An IDX file may be shorter than the magic string of the binary form
+    if (!file.read(magic, 4))
+        return false;
+    
+    return IsIdx(reinterpret_cast<const uint8_t*>(magic)) || (file.read(magic + 4, sizeof(magic) - 4) && memcmp(magic, kMagic, sizeof(kMagic)) == 0);
+}
+
+std::unique_ptr<RecordFile> RecordFile::Open(const std::string& path) {
+    
+    std::unique_ptr<RecordFile> file(new RecordFile());
+    
+    if (!file->m_pimpl->Map(path))
+        file.reset();
+    
+    return file;
+}
+
+bool RecordFile::Convert(const std::string& input_path, const std::string& output_path) {
+    
+    //The file is written to another file and renamed over the path, as networks are saved
+    std::string temporary_path = output_path + ".tmp";
+    std::ofstream output(temporary_path, std::ios::binary);
+    
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.byte_order = kByteOrder;
+    header.version = kVersion;
+    header.value_size = sizeof(uint8_t);
+    
+    //The header is written again once the records are counted
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    
+    std::vector<uint8_t> record;
+    bool written = true;
+    
+    for (DataIterator data(input_path) ; data.Valid() && written ; data.Next()) {
+        
+        Data value = data.Value();
+        
+        if (header.records == 0)
+            header.width = static_cast<uint32_t>(value.content.size());
+        
+        written = (value.content.size() == header.width && header.width > 0);
+        record.resize(header.width);
+        
+        for (size_t index = 0 ; index < value.content.size() && written ; index++) {
+            
+            written = (value.content[index] >= 0 && value.content[index] <= UINT8_MAX);
+            record[index] = static_cast<uint8_t>(value.content[index]);
+        }
+        
+        output.write(reinterpret_cast<const char*>(record.data()), record.size());
+        header.records++;
+    }
+    
+    //A file without records still needs a width to be valid
+    if (header.records == 0)
+        header.width = 1;
+    
+    output.seekp(0);
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    output.close();
+    
+    if (!written || !output || rename(temporary_path.c_str(), output_path.c_str()) != 0) {
+        
+        remove(temporary_path.c_str());
+        return false;
+    }
+    
+    return true;
+}
+
+size_t RecordFile::Records() const {
+    return m_pimpl->Records();
+}
+
+size_t RecordFile::Width() const {
+    return m_pimpl->Width();
+}
+
+const uint8_t* RecordFile::Record(size_t index) const {
+    return m_pimpl->Record(index);
+}
@@ -0,0 +1,104 @@
+//
+//  RecordFile.hpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#ifndef RecordFile_hpp
+#define RecordFile_hpp
+#include "Definitions.h"
+#include <string>
+#include <memory>
+#include <stdint.h>
+NAMESPACE_NEURAL_BEGIN
+
+/**
+ * A data or key file in a binary form, mapped into memory.
+ *
+ * The file begins with a header of a cache line: a magic string, the
+ * byte order and version of the format, the number of records and the
+ * number of values in every record. The records follow the header as
+ * they are, a byte per value, so a record of an image is 784 bytes and
+ * a record of a key file is a single byte. Reading a record is a copy
+ * from the mapped pages, which stay in the page cache between epochs
+ * and between the processes that read the same file.
+ *
+ * Files in the IDX form of MNIST (idx3-ubyte images and idx1-ubyte
+ * labels) are read the same way: the big endian sizes of the header
+ * give the number of records (the first dimension) and the size of
+ * every record (the product of the others).
+ */
+class RecordFile {
+public:
+    
+    /**
+     * Returns true if the file begins as a binary record file or an
+     * IDX file.
+     *
+     * @param path  The path to the file.
+     * @return True if the file has the magic string of either form.
+     */
+    static bool Recognize(const std::string& path);
+    
+    /**
+     * Maps a binary record file or an IDX file of bytes and validates
+     * it's header.
+     *
+     * @param path  The path to the file.
+     * @return The mapped file, or NULL if it could not be mapped or is
+     *         not a valid record file.
+     */
+    static std::unique_ptr<RecordFile> Open(const std::string& path);
+    
+    /**
+     * Packs the records of a data or key file (in any form that
+     * 'DataIterator' reads) into a binary record file.
+     *
+     * @param input_path    The path to the file to pack.
+     * @param output_path   The path to the binary record file.
+     * @return True if the file was written, false if it could not be,
+     *         or if the records differ in size or have values that do
+     *         not fit in a byte.
+     */
+    static bool Convert(const std::string& input_path, const std::string& output_path);
+    
+    /**
+     * Returns the number of records in the file.
+     *
+     * @return The number of records.
+     */
+    size_t Records() const;
+    
+    /**
+     * Returns the number of values in every record.
+     *
+     * @return The number of values.
+     */
+    size_t Width() const;
+    
+    /**
+     * Returns the values of a record.
+     *
+     * @param index The index of the record, less than 'Records()'.
+     * @return The 'Width()' values of the record.
+     */
+    const uint8_t* Record(size_t index) const;
+    
+    /**
+     * Destructor. Unmaps the file.
+     */
+    ~RecordFile();
+    
+private:
+    
+    RecordFile();
+    
+    class Impl;
+    std::unique_ptr<Impl> m_pimpl;
+    
+};
+
+NAMESPACE_NEURAL_END
+#endif /* RecordFile_hpp */
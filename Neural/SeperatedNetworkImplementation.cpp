@@ -8,44 +8,130 @@
 
 #include "SeperatedNetworkImplementation.hpp"
 #include "Data.hpp"
+#include "ModelFile.hpp"
+#include "Layer.hpp"
 #include <string>
+#include <thread>
+#include <algorithm>
 
 using namespace neural;
 
-SeperatedNetworkImplementation::SeperatedNetworkImplementation() {
+///The number of records that 'EstimateBatch' passes through the networks at once
+static const size_t kRecordsPerChunk = 64;
+
+///The number of values of every record, the pixels of an image
+static const size_t kInputs = 784;
+
+/**
+ * Returns the index of the network with the largest result.
+ *
+ * @param results   The result of every network.
+ * @return The index of the largest result.
+ */
+static size_t MaximalIndex(const double* results) {
+    
+    size_t max_pos = 0;
+    double max_value = 0.0;
     
-    //Output layer will have only 1 neuron
+    //Find maximal value by network index
+    for (size_t network_index = 0 ; network_index < 10 ; network_index++) {
+        
+        if (results[network_index] > max_value) {
+            max_value = results[network_index];
+            max_pos = network_index;
+        }
+    }
+    
+    return max_pos;
+}
+
+template <typename Scalar>
+SeperatedNetworkImplementation<Scalar>::SeperatedNetworkImplementation(ActivationType hidden) :
+m_fast_activation(false) {
+    
+    //Output layer will have only 1 neuron, which stays a sigmoid
     for (size_t index = 0 ; index < 10 ; index++) {
         
-        Network* new_network = new Network(80);
-        new_network->AddNetwork(19);
+        BasicNetwork<Scalar>* new_network = new BasicNetwork<Scalar>(80, hidden);
+        new_network->AddNetwork(19, hidden);
         new_network->AddNetwork(1);
         
-        m_networks.push_back(std::unique_ptr<Network>(new_network));
+        //The data is conformed to binary values
+        new_network->SetBinaryInput(true);
+        
+        m_networks.push_back(std::unique_ptr<BasicNetwork<Scalar> >(new_network));
     }
 }
 
-SeperatedNetworkImplementation::SeperatedNetworkImplementation(const std::string& serialized)  {
+template <typename Scalar>
+std::unique_ptr<SeperatedNetworkImplementation<Scalar> > SeperatedNetworkImplementation<Scalar>::Deserialize(const char* serialized, const char* end, ThreadPool* pool) {
+    
+    std::vector<std::unique_ptr<BasicNetwork<Scalar> > > networks(10);
 
-    //The networks are seperated by the delimiter '!'
-    size_t network_start = 1;
+    //The networks are seperated by the delimiter '!', which also precedes the first
+    std::vector<const char*> bounds(1, std::find(serialized, end, '!'));
     
-    for (size_t index = 0 ; index < 10 ; index++) {
+    for (size_t index = 0 ; index < 10 ; index++)
+        bounds.push_back(std::find(std::min(bounds.back() + 1, end), end, '!'));
         
-        size_t network_end = serialized.find_first_of('!', network_start);
+    auto load = [&](size_t begin, size_t finish) {
         
-        m_networks.push_back(std::unique_ptr<Network>(new Network(serialized.substr(network_start, network_end - network_start))));
-        network_start = network_end + 1;
+        for (size_t index = begin ; index < finish ; index++) {
+            
+            const char* network_start = std::min(bounds[index] + 1, end);
+            
+            networks[index] = BasicNetwork<Scalar>::Deserialize(network_start, bounds[index + 1]);
+        }
+    };
+    
+    //The networks are independent, so each is read by a thread of it's own
+    if (pool)   pool->Run(networks.size(), 1, load);
+    else        load(0, networks.size());
+    
+    return Load(std::move(networks));
+}
+
+template <typename Scalar>
+std::unique_ptr<SeperatedNetworkImplementation<Scalar> > SeperatedNetworkImplementation<Scalar>::Load(std::vector<std::unique_ptr<BasicNetwork<Scalar> > > networks) {
+    
+    if (networks.size() != 10)
+        return NULL;
+    
+    for (size_t index = 0 ; index < networks.size() ; index++) {
+        
+        //Every network gives a single output, the certainty of it's digit
+        if (!networks[index] || !networks[index]->HasShape(kInputs, 1))
+            return NULL;
     }
+    
+    return std::unique_ptr<SeperatedNetworkImplementation<Scalar> >(new SeperatedNetworkImplementation<Scalar>(std::move(networks)));
+}
+
+template <typename Scalar>
+SeperatedNetworkImplementation<Scalar>::SeperatedNetworkImplementation(std::vector<std::unique_ptr<BasicNetwork<Scalar> > > networks) :
+m_networks(std::move(networks)),
+m_fast_activation(false) {
+    
+    //The data is conformed to binary values
+    for (size_t index = 0 ; index < m_networks.size() ; index++)
+        m_networks[index]->SetBinaryInput(true);
 }
 
-OperationalNetwork::Type SeperatedNetworkImplementation::Type() const {
+template <typename Scalar>
+OperationalNetwork::Type SeperatedNetworkImplementation<Scalar>::Type() const {
     return OperationalNetwork::Type::kSeperated;
 }
 
-SeperatedNetworkImplementation::~SeperatedNetworkImplementation() { };
+template <typename Scalar>
+OperationalNetwork::Precision SeperatedNetworkImplementation<Scalar>::Precision() const {
+    return PrecisionOf<Scalar>::value;
+}
+
+template <typename Scalar>
+SeperatedNetworkImplementation<Scalar>::~SeperatedNetworkImplementation() { };
 
-std::string SeperatedNetworkImplementation::Serialize() const {
+template <typename Scalar>
+std::string SeperatedNetworkImplementation<Scalar>::Serialize() const {
 
     std::string serialized;
     
@@ -56,42 +142,379 @@ std::string SeperatedNetworkImplementation::Serialize() const {
     return serialized;
 }
 
-double SeperatedNetworkImplementation::Estimate(const Data& input) const {
+template <typename Scalar>
+bool SeperatedNetworkImplementation<Scalar>::WriteBinary(std::ostream& output) const {
     
-    size_t max_pos = 0;
-    double max_value = 0.0;
+    std::vector<const BasicNetwork<Scalar>*> networks;
     
-    //Find maximal value by network index
-    for (size_t network_index = 0 ; network_index < 10 ; network_index++) {
+    for (size_t index = 0 ; index < 10 ; index++)
+        networks.push_back(m_networks[index].get());
+    
+    return ModelFile::Write<Scalar>(output, Type(), networks);
+}
+
+template <typename Scalar>
+double SeperatedNetworkImplementation<Scalar>::Estimate(const Data& input) const {
+    
+    //Every network sees the same conformed data
+    Data conformed_data = ConformData(input);
+    double results[10];
+    
+    //The fixed copies are small enough to run one after the other on the calling thread
+    if (!m_fixed.empty()) {
         
-        double result = m_networks[network_index]->Feed(ConformData(input)).front();
-        if (result > max_value) {
-            max_value = result;
-            max_pos = network_index;
+        std::array<Scalar, FixedTopology::kOutputs> outputs;
+        
+        for (size_t network_index = 0 ; network_index < 10 ; network_index++) {
+            
+            m_fixed[network_index]->Feed(conformed_data, outputs);
+            results[network_index] = outputs.front();
         }
+        
+        return MaximalIndex(results);
     }
     
-    return max_pos;
+    ForEachNetwork([this, &conformed_data, &results](size_t network_index) {
+        
+        //Every thread has it's own workspace, so that several threads can estimate at once
+        static thread_local Workspace<Scalar> workspace;
+        
+        results[network_index] = (m_quantized.empty()) ?
+        m_networks[network_index]->Feed(conformed_data, workspace).front() :
+        m_quantized[network_index]->Feed(conformed_data).front();
+    });
+    
+    return MaximalIndex(results);
+}
+    
+template <typename Scalar>
+void SeperatedNetworkImplementation<Scalar>::EstimateBatch(const std::vector<Data>& data, std::vector<double>& results) const {
+        
+    results.resize(data.size());
+    
+    size_t chunks = (data.size() + kRecordsPerChunk - 1) / kRecordsPerChunk;
+    
+    //Every chunk writes only it's own results, so their order does not depend on the threads
+    auto estimate = [this, &data, &results](size_t begin, size_t end) {
+        
+        std::vector<Workspace<Scalar> > workspaces(10);
+        std::vector<Data> conformed_data;
+        std::vector<double> network_results;
+        
+        for (size_t chunk = begin ; chunk < end ; chunk++) {
+            
+            size_t first = chunk * kRecordsPerChunk;
+            size_t last = std::min(first + kRecordsPerChunk, data.size());
+            
+            /*
+             * The fixed copies keep a record's values on the stack and the
+             * quantized copies in buffers of every thread, so both run a
+             * record at a time, with the chunks still split between threads.
+             */
+            if (!m_fixed.empty() || !m_quantized.empty()) {
+                
+                for (size_t index = first ; index < last ; index++)
+                    results[index] = Estimate(data[index]);
+                
+                continue;
+            }
+            
+            conformed_data.clear();
+            
+            for (size_t index = first ; index < last ; index++)
+                conformed_data.push_back(ConformData(data[index]));
+            
+            network_results.resize(conformed_data.size() * 10);
+            
+            //Runs on the calling thread when the chunks already share the pool
+            ForEachNetwork([this, &conformed_data, &network_results, &workspaces](size_t network_index) {
+                
+                const std::vector<Scalar>& outputs = m_networks[network_index]->FeedBatch(conformed_data, workspaces[network_index]);
+                
+                for (size_t record = 0, total = conformed_data.size() ; record < total ; record++)
+                    network_results[record * 10 + network_index] = outputs[record];
+            });
+            
+            for (size_t index = first ; index < last ; index++)
+                results[index] = MaximalIndex(network_results.data() + (index - first) * 10);
+        }
+    };
+    
+    //A single chunk is better off with the networks split between the threads
+    if (m_pool && chunks > 1)   m_pool->Run(chunks, 1, estimate);
+    else                        estimate(0, chunks);
+}
+
+template <typename Scalar>
+void SeperatedNetworkImplementation<Scalar>::Quantize(const std::vector<Data>& calibration) {
+    
+    std::vector<std::unique_ptr<QuantizedNetwork> > quantized;
+    
+    for (size_t network_index = 0 ; network_index < 10 ; network_index++)
+        quantized.push_back(std::unique_ptr<QuantizedNetwork>(new QuantizedNetwork(m_networks[network_index]->Serialize())));
+    
+    std::vector<Data> conformed_data;
+    conformed_data.reserve(calibration.size());
+        
+    for (size_t index = 0, total = calibration.size() ; index < total ; index++)
+        conformed_data.push_back(ConformData(calibration[index]));
+        
+    ForEachNetwork([&quantized, &conformed_data](size_t network_index) {
+    
+        for (size_t index = 0, total = conformed_data.size() ; index < total ; index++)
+            quantized[network_index]->Calibrate(conformed_data[index]);
+        
+        quantized[network_index]->Quantize();
+    });
+    
+    m_quantized.swap(quantized);
+    m_fixed.clear();
 }
 
-void SeperatedNetworkImplementation::Train(const neural::Data &data, size_t key) {
+template <typename Scalar>
+bool SeperatedNetworkImplementation<Scalar>::Specialize() {
+    
+    std::vector<std::unique_ptr<FixedTopology> > fixed;
     
+    //The fixed copies read the same form that is saved to files
     for (size_t network_index = 0 ; network_index < 10 ; network_index++) {
         
+        fixed.push_back(FixedTopology::Load(m_networks[network_index]->Serialize()));
+        
+        if (!fixed.back())
+            return false;
+        
+        fixed.back()->SetFastActivation(m_fast_activation);
+    }
+    
+    m_fixed.swap(fixed);
+    m_quantized.clear();
+    return true;
+}
+
+template <typename Scalar>
+void SeperatedNetworkImplementation<Scalar>::SetFastActivation(bool fast) {
+    
+    m_fast_activation = fast;
+    
+    for (size_t network_index = 0 ; network_index < 10 ; network_index++)
+        m_networks[network_index]->SetFastActivation(fast);
+    
+    for (size_t network_index = 0, total = m_fixed.size() ; network_index < total ; network_index++)
+        m_fixed[network_index]->SetFastActivation(fast);
+}
+
+template <typename Scalar>
+void SeperatedNetworkImplementation<Scalar>::SetThreads(size_t threads) {
+    
+    /*
+     * The threads run whole networks instead of splitting the layers, the
+     * layers of a network this small gain little from more than one thread.
+     * More than 10 threads would have nothing to do.
+     */
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    
+    threads = std::min<size_t>(threads, 10);
+    m_pool.reset((threads > 1) ? new ThreadPool(threads) : NULL);
+}
+    
+template <typename Scalar>
+template <typename Task>
+void SeperatedNetworkImplementation<Scalar>::ForEachNetwork(const Task& task) const {
+    
+    if (m_pool) {
+        
+        m_pool->Run(10, 1, [&task](size_t begin, size_t end) {
+            
+            for (size_t network_index = begin ; network_index < end ; network_index++)
+                task(network_index);
+        });
+    }
+    else {
+        
+        for (size_t network_index = 0 ; network_index < 10 ; network_index++)
+            task(network_index);
+    }
+}
+
+template <typename Scalar>
+size_t SeperatedNetworkImplementation<Scalar>::Inputs() const {
+    return kInputs;
+}
+
+template <typename Scalar>
+size_t SeperatedNetworkImplementation<Scalar>::Outputs() const {
+    
+    //Every network gives the certainty of it's own digit
+    size_t outputs = 0;
+    
+    for (size_t index = 0 ; index < m_networks.size() ; index++)
+        outputs += m_networks[index]->Layers().back()->Size();
+    
+    return outputs;
+}
+
+template <typename Scalar>
+size_t SeperatedNetworkImplementation<Scalar>::Bytes() const {
+    
+    size_t bytes = 0;
+    
+    for (size_t network_index = 0 ; network_index < 10 ; network_index++)
+        bytes += (m_quantized.empty()) ? m_networks[network_index]->Bytes() : m_quantized[network_index]->Bytes();
+    
+    return bytes;
+}
+
+template <typename Scalar>
+void SeperatedNetworkImplementation<Scalar>::ExportParameters(std::vector<double>& parameters) const {
+    
+    size_t total = 0;
+    
+    for (size_t network_index = 0 ; network_index < 10 ; network_index++)
+        total += m_networks[network_index]->Parameters();
+    
+    parameters.resize(total);
+    
+    //The networks one after the other, as they are serialized
+    for (size_t network_index = 0, offset = 0 ; network_index < 10 ; network_index++) {
+        
+        m_networks[network_index]->ExportParameters(parameters.data() + offset);
+        offset += m_networks[network_index]->Parameters();
+    }
+}
+
+template <typename Scalar>
+void SeperatedNetworkImplementation<Scalar>::ImportParameters(const std::vector<double>& parameters) {
+    
+    //The copies no longer match the weights
+    m_quantized.clear();
+    m_fixed.clear();
+    
+    for (size_t network_index = 0, offset = 0 ; network_index < 10 ; network_index++) {
+        
+        m_networks[network_index]->ImportParameters(parameters.data() + offset);
+        offset += m_networks[network_index]->Parameters();
+    }
+}
+
+template <typename Scalar>
+void SeperatedNetworkImplementation<Scalar>::Train(const neural::Data &data, size_t key) {
+    
+    //The copies no longer match the weights
+    m_quantized.clear();
+    m_fixed.clear();
+    
+    //Every network sees the same conformed data
+    Data conformed_data = ConformData(data);
+    
+    ForEachNetwork([this, &conformed_data, key](size_t network_index) {
+        
+        //Get the network to identify the number based on it's index
+        Data modified_result;
+        modified_result.content = std::vector<double>(1, (key == network_index) ? 1.0 : 0.0);
+        
+        m_networks[network_index]->Train(conformed_data, modified_result);
+    });
+}
+
+template <typename Scalar>
+void SeperatedNetworkImplementation<Scalar>::TrainBatch(const std::vector<Data>& data, const std::vector<size_t>& keys) {
+    
+    //The copies no longer match the weights
+    m_quantized.clear();
+    m_fixed.clear();
+    
+    std::vector<Data> conformed_data;
+    conformed_data.reserve(data.size());
+    
+    for (size_t index = 0, total = data.size() ; index < total ; index++)
+        conformed_data.push_back(ConformData(data[index]));
+    
+    ForEachNetwork([this, &conformed_data, &keys](size_t network_index) {
+        
         //Get the network to identify the number based on it's index
+        std::vector<Data> modified_results(keys.size());
+        
+        for (size_t index = 0, total = keys.size() ; index < total ; index++)
+            modified_results[index].content = std::vector<double>(1, (keys[index] == network_index) ? 1.0 : 0.0);
+        
+        m_networks[network_index]->TrainBatch(conformed_data, modified_results);
+    });
+}
+
+template <typename Scalar>
+void SeperatedNetworkImplementation<Scalar>::BeginConcurrentTraining(size_t threads) {
+    
+    //The copies no longer match the weights
+    m_quantized.clear();
+    m_fixed.clear();
+    
+    //A contiguous workspace per thread for every network
+    m_workspaces.resize(10 * threads);
+}
+
+template <typename Scalar>
+void SeperatedNetworkImplementation<Scalar>::TrainConcurrently(const Data& data, size_t key, size_t thread) {
+    
+    Data conformed_data = ConformData(data);
+    size_t threads = m_workspaces.size() / 10;
+    
+    //The weights are shared without locks, the same as in the combined network
+    for (size_t network_index = 0 ; network_index < 10 ; network_index++) {
+        
         Data modified_result;
         modified_result.content = std::vector<double>(1, (key == network_index) ? 1.0 : 0.0);
         
-        m_networks[network_index]->Train(ConformData(data), modified_result);
+        m_networks[network_index]->Train(conformed_data, modified_result, m_workspaces[network_index * threads + thread]);
+    }
+}
+
+template <typename Scalar>
+void SeperatedNetworkImplementation<Scalar>::EndConcurrentTraining() {
+    std::vector<Workspace<Scalar> >().swap(m_workspaces);
+}
+
+template <typename Scalar>
+void SeperatedNetworkImplementation<Scalar>::TrainBatchConcurrently(const std::vector<Data>& data, const std::vector<size_t>& keys, ThreadPool& pool) {
+    
+    std::vector<Data> conformed_data;
+    conformed_data.reserve(data.size());
+    
+    for (size_t index = 0, total = data.size() ; index < total ; index++)
+        conformed_data.push_back(ConformData(data[index]));
+    
+    size_t threads = m_workspaces.size() / 10;
+    
+    //The pool splits the records, so the networks take their turns
+    for (size_t network_index = 0 ; network_index < 10 ; network_index++) {
+        
+        std::vector<Data> modified_results(keys.size());
+        
+        for (size_t index = 0, total = keys.size() ; index < total ; index++)
+            modified_results[index].content = std::vector<double>(1, (keys[index] == network_index) ? 1.0 : 0.0);
+        
+        m_networks[network_index]->TrainBatch(conformed_data, modified_results, &m_workspaces[network_index * threads], pool);
     }
 }
 
-Data SeperatedNetworkImplementation::ConformData(const neural::Data &data) const {
+template <typename Scalar>
+Data SeperatedNetworkImplementation<Scalar>::ConformData(const neural::Data &data) const {
     
     Data modified_data;
-    modified_data.content.reserve(784);
-    for (size_t i = 0 ; i < 784 ; i++)
-        modified_data.content.push_back(data.content.at(i) > 50 ? 1.0 : 0.0);
+    modified_data.content.reserve(kInputs);
+    
+    //Missing values of a short record are taken as unset, so that estimating never throws
+    for (size_t i = 0 ; i < kInputs ; i++)
+        modified_data.content.push_back(i < data.content.size() && data.content[i] > 50 ? 1.0 : 0.0);
+    
+    //List the set pixels, so that the network only touches their weights
+    for (uint32_t i = 0 ; i < kInputs ; i++)
+        if (modified_data.content[i] != 0.0)
+            modified_data.active.push_back(i);
     
     return modified_data;
 }
+
+template class neural::SeperatedNetworkImplementation<double>;
+template class neural::SeperatedNetworkImplementation<float>;
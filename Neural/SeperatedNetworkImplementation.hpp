@@ -10,26 +10,54 @@
 #define SeperatedNetworkImplementation_hpp
 #include "OperationalNetworkImplementation.h"
 #include "Network.hpp"
+#include "QuantizedNetwork.hpp"
+#include "FixedNetwork.hpp"
+#include "ThreadPool.hpp"
+#include "Workspace.hpp"
 #include <memory>
 NAMESPACE_NEURAL_BEGIN
 class Data;
 
+template <typename Scalar>
 class SeperatedNetworkImplementation : public OperationalNetwork::Impl {
 public:
     
     /**
      * Constructor.
      * This will create a new default seperated network.
+     *
+     * @param hidden    The activation function of the hidden layers.
+     */
+    SeperatedNetworkImplementation(ActivationType hidden = ActivationType::kSigmoid);
+    
+    /**
+     * Recreates the network given in the input.
+     *
+     * @param serialized    The beginning of the serialized form of the seperated network.
+     * @param end           The end of the serialized form.
+     * @param pool          The threads that read the ten networks at once, or NULL.
+     * @return The network, or NULL if the serialized form is not valid.
+     */
+    static std::unique_ptr<SeperatedNetworkImplementation> Deserialize(const char* serialized, const char* end, ThreadPool* pool = NULL);
+    
+    /**
+     * Takes over networks that were already created, such as ones that
+     * run from a mapped 'ModelFile', if they have the shape of the
+     * seperated networks: 10 networks of 784 inputs and a single result.
+     *
+     * @param networks  The networks by digit, some of which may be NULL.
+     * @return The network, or NULL if one is missing or has another shape.
      */
-    SeperatedNetworkImplementation();
+    static std::unique_ptr<SeperatedNetworkImplementation> Load(std::vector<std::unique_ptr<BasicNetwork<Scalar> > > networks);
     
     /**
      * Constructor.
-     * This will recreate the network given in the input.
+     * This will take over networks that were already created, such as
+     * ones that run from a mapped 'ModelFile'.
      *
-     * @param serialized The serialized form of the seperated network.
+     * @param networks  The 10 networks, by digit.
      */
-    SeperatedNetworkImplementation(const std::string& serialized);
+    SeperatedNetworkImplementation(std::vector<std::unique_ptr<BasicNetwork<Scalar> > > networks);
     
     /**
      * Destructor.
@@ -43,6 +71,13 @@ public:
      */
     OperationalNetwork::Type Type() const;
     
+    /**
+     * Returns the precision of the network's weights as an enum.
+     *
+     * @return An enum that represents the precision of the network.
+     */
+    OperationalNetwork::Precision Precision() const;
+    
     /**
      * This will serialize the network into a form that can be saved and
      * later construct an identical network to the current one.
@@ -51,6 +86,50 @@ public:
      */
     std::string Serialize() const;
     
+    /**
+     * Writes the network in the binary form of 'ModelFile'.
+     *
+     * @param output    The stream to write to.
+     * @return True if the network was written.
+     */
+    bool WriteBinary(std::ostream& output) const;
+    
+    /**
+     * Returns the number of values that every record has.
+     *
+     * @return The number of values.
+     */
+    size_t Inputs() const;
+    
+    /**
+     * Returns the number of results of the network, a certainty per digit.
+     *
+     * @return The number of results.
+     */
+    size_t Outputs() const;
+    
+    /**
+     * Returns the memory that the weights occupy, of the quantized
+     * copy if there is one.
+     *
+     * @return The size in bytes.
+     */
+    size_t Bytes() const;
+    
+    /**
+     * Copies the weights and biases of the network into a single vector.
+     *
+     * @param parameters    Receives the parameters.
+     */
+    void ExportParameters(std::vector<double>& parameters) const;
+    
+    /**
+     * Replaces the weights and biases of the network.
+     *
+     * @param parameters    The parameters.
+     */
+    void ImportParameters(const std::vector<double>& parameters);
+    
 protected:
     
     /**
@@ -61,6 +140,44 @@ protected:
      */
     virtual void Train(const Data& data, size_t key);
     
+    /**
+     * Trains the network with a batch of inputs and their answers.
+     *
+     * @param data  The data to train on.
+     * @param keys  The answer to every data in the batch.
+     */
+    virtual void TrainBatch(const std::vector<Data>& data, const std::vector<size_t>& keys);
+    
+    /**
+     * Prepares the network to be trained by several threads at once.
+     *
+     * @param threads   The number of threads that will train.
+     */
+    virtual void BeginConcurrentTraining(size_t threads);
+    
+    /**
+     * Trains the network from one of the threads that train at once.
+     *
+     * @param data      The data to train on.
+     * @param key       The answer to the data.
+     * @param thread    The index of the calling thread.
+     */
+    virtual void TrainConcurrently(const Data& data, size_t key, size_t thread);
+    
+    /**
+     * Releases what 'BeginConcurrentTraining' prepared.
+     */
+    virtual void EndConcurrentTraining();
+    
+    /**
+     * Trains the network with a batch that is split between the threads of a pool.
+     *
+     * @param data  The data to train on.
+     * @param keys  The answer to every data in the batch.
+     * @param pool  The threads that share the batch.
+     */
+    virtual void TrainBatchConcurrently(const std::vector<Data>& data, const std::vector<size_t>& keys, ThreadPool& pool);
+    
     /**
      * Estimates the result to the given input.
      *
@@ -68,6 +185,61 @@ protected:
      */
     virtual double Estimate(const Data& input) const;
     
+    /**
+     * Estimates the results of a batch of inputs. With a pool the
+     * inputs are split into chunks that run concurrently.
+     *
+     * @param data      The inputs to estimate.
+     * @param results   Receives the estimation of every input, by order.
+     */
+    virtual void EstimateBatch(const std::vector<Data>& data, std::vector<double>& results) const;
+    
+    /**
+     * Creates an 8 bit integer copy of the network that is used by
+     * 'Estimate' from then on, until the network trains again.
+     *
+     * @param calibration   Sample records to calibrate the copy with.
+     */
+    virtual void Quantize(const std::vector<Data>& calibration);
+    
+    /**
+     * Creates a copy of the network with compile time layer sizes that
+     * is used by 'Estimate' from then on, until the network trains again.
+     *
+     * @return True if the network has the default sizes.
+     */
+    virtual bool Specialize();
+    
+    /**
+     * Chooses between the exact sigmoid and a fast approximation.
+     *
+     * @param fast  True to use the approximation.
+     */
+    virtual void SetFastActivation(bool fast);
+    
+    /**
+     * Changes the number of threads that run the ten networks concurrently.
+     *
+     * @param threads   The number of threads (at most 10 are used), 1 runs on
+     *                  the calling thread only.
+     */
+    virtual void SetThreads(size_t threads);
+    
+    /**
+     * Does nothing, the networks are too shallow to pipeline and the
+     * threads already run the ten networks concurrently.
+     *
+     * @param stages    The number of stages.
+     */
+    virtual void SetPipelineStages(size_t /*stages*/) { }
+    
+    /**
+     * Returns no stages, the networks are not pipelined.
+     *
+     * @return An empty vector.
+     */
+    virtual std::vector<PipelineStage> PipelineStages() const { return std::vector<PipelineStage>(); }
+    
 private:
     
     /**
@@ -78,8 +250,36 @@ private:
      */
     Data ConformData(const Data &data) const;
     
+    /**
+     * Calls 'task(network_index)' for every one of the networks. The
+     * networks share nothing, so with a pool they run concurrently,
+     * each on a single thread.
+     *
+     * @param task  The work to do on a network.
+     */
+    template <typename Task>
+    void ForEachNetwork(const Task& task) const;
+    
     ///Stores the networks.
-    std::vector<std::unique_ptr<Network> > m_networks;
+    std::vector<std::unique_ptr<BasicNetwork<Scalar> > > m_networks;
+    
+    ///Stores the quantized copies of the networks, if they were made.
+    std::vector<std::unique_ptr<QuantizedNetwork> > m_quantized;
+    
+    ///The default topology of every network, the sizes of the inputs and of every layer
+    typedef BasicFixedNetwork<Scalar, 784, 80, 19, 1> FixedTopology;
+    
+    ///Stores the copies of the networks with compile time sizes, if they were made.
+    std::vector<std::unique_ptr<FixedTopology> > m_fixed;
+    
+    ///Stores true if the fast approximation of the sigmoid is used.
+    bool m_fast_activation;
+    
+    ///Stores the threads that run the networks concurrently, if there are any.
+    std::unique_ptr<ThreadPool> m_pool;
+    
+    ///Stores the intermediate results of every network for every thread that trains concurrently.
+    std::vector<Workspace<Scalar> > m_workspaces;
 };
 
 NAMESPACE_NEURAL_END
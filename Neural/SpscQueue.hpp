@@ -0,0 +1,120 @@
+//
+//  SpscQueue.hpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#ifndef SpscQueue_hpp
+#define SpscQueue_hpp
+#include "Definitions.h"
+#include "AlignedAllocator.hpp"
+#include <vector>
+#include <atomic>
+#include <thread>
+NAMESPACE_NEURAL_BEGIN
+
+/**
+ * A queue of a fixed capacity between a single thread that pushes and
+ * a single thread that pops, without locks. Everything that the pushing
+ * thread wrote before a push is visible to the thread that pops it.
+ */
+template <typename T>
+class SpscQueue {
+public:
+    
+    /**
+     * Constructor.
+     *
+     * @param capacity  The number of values that the queue can hold.
+     */
+    SpscQueue(size_t capacity = 1) :
+    m_values(capacity + 1),
+    m_head(0),
+    m_tail(0)
+    { }
+    
+    /**
+     * Adds a value, unless the queue is full.
+     *
+     * @param value     The value to add.
+     * @return True if the value was added.
+     */
+    bool TryPush(const T& value) {
+        
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        size_t next = (tail + 1 == m_values.size()) ? 0 : tail + 1;
+        
+        if (next == m_head.load(std::memory_order_acquire))
+            return false;
+        
+        m_values[tail] = value;
+        m_tail.store(next, std::memory_order_release);
+        return true;
+    }
+    
+    /**
+     * Removes the oldest value, unless the queue is empty.
+     *
+     * @param value     Receives the value.
+     * @return True if a value was removed.
+     */
+    bool TryPop(T& value) {
+        
+        size_t head = m_head.load(std::memory_order_relaxed);
+        
+        if (head == m_tail.load(std::memory_order_acquire))
+            return false;
+        
+        value = m_values[head];
+        m_head.store((head + 1 == m_values.size()) ? 0 : head + 1, std::memory_order_release);
+        return true;
+    }
+    
+    /**
+     * Adds a value, waiting while the queue is full.
+     *
+     * @param value     The value to add.
+     */
+    void Push(const T& value) {
+        
+        for (size_t spin = 0 ; !TryPush(value) ; spin++)
+            if (spin >= kSpins)
+                std::this_thread::yield();
+    }
+    
+    /**
+     * Removes the oldest value, waiting while the queue is empty.
+     *
+     * @return The value.
+     */
+    T Pop() {
+        
+        T value;
+        
+        for (size_t spin = 0 ; !TryPop(value) ; spin++)
+            if (spin >= kSpins)
+                std::this_thread::yield();
+        
+        return value;
+    }
+    
+private:
+    
+    ///The number of times to check the queue before giving up the core
+    static const size_t kSpins = 1 << 10;
+    
+    ///Stores the values, one slot is always empty to tell a full queue from an empty one
+    std::vector<T> m_values;
+    
+    ///Stores the index of the oldest value, written by the popping thread only
+    alignas(NEURAL_ALIGNMENT) std::atomic<size_t> m_head;
+    
+    ///Stores the index after the newest value, written by the pushing thread only
+    alignas(NEURAL_ALIGNMENT) std::atomic<size_t> m_tail;
+    
+};
+
+NAMESPACE_NEURAL_END
+#endif /* SpscQueue_hpp */
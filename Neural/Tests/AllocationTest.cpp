@@ -0,0 +1,117 @@
+//
+//  AllocationTest.cpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#include "Network.hpp"
+#include "Data.hpp"
+#include <iostream>
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+
+using namespace neural;
+
+///The number of times that the global operator new was called
+static std::atomic<size_t> allocations(0);
+
+void* operator new(size_t size) {
+    
+    allocations++;
+    
+    void* memory = malloc((size) ? size : 1);
+    
+    if (!memory)
+        throw std::bad_alloc();
+    
+    return memory;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+    free(memory);
+}
+
+///The number of records that the network trains on before the allocations are counted
+static const size_t kWarmUp = 10;
+
+///The number of records that the allocations are counted over
+static const size_t kIterations = 100;
+
+/**
+ * Trains and feeds a network after it has warmed up, and counts the
+ * allocations that it makes. The workspace is sized by the first
+ * records, after which none should be made.
+ *
+ * @param binary    True if the network reads binary input.
+ * @param type      The name of the scalar type, for the report.
+ * @return The number of allocations after the warm up.
+ */
+template <typename Scalar>
+static size_t CountAllocations(bool binary, const char* type) {
+    
+    BasicNetwork<Scalar> network(301);
+    network.AddNetwork(200);
+    network.AddNetwork(10);
+    network.SetBinaryInput(binary);
+    
+    Data data, target;
+    data.content.resize(784);
+    target.content.resize(10);
+    
+    for (size_t index = 0 ; index < data.content.size() ; index++) {
+        
+        data.content[index] = (index % 3 == 0) ? 1 : 0;
+        
+        if (data.content[index] != 0)
+            data.active.push_back(static_cast<uint32_t>(index));
+    }
+    
+    target.content[3] = 1;
+    
+    for (size_t index = 0 ; index < kWarmUp ; index++) {
+        
+        network.Train(data, target);
+        network.Feed(data);
+    }
+    
+    size_t before = allocations;
+    
+    for (size_t index = 0 ; index < kIterations ; index++) {
+        
+        network.Train(data, target);
+        network.Feed(data);
+    }
+    
+    size_t counted = allocations - before;
+    
+    std::cout << type << ((binary) ? " binary" : "") << ": " << counted << " allocations in " << kIterations << " records\n";
+    
+    return counted;
+}
+
+int main(int argc, const char * argv[]) {
+    
+    size_t counted = CountAllocations<double>(false, "double") + CountAllocations<double>(true, "double") +
+    CountAllocations<float>(false, "float") + CountAllocations<float>(true, "float");
+    
+    return (counted) ? 1 : 0;
+}
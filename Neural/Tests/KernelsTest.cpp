@@ -0,0 +1,192 @@
+//
+//  KernelsTest.cpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#include "Kernels.hpp"
+#include "AlignedAllocator.hpp"
+#include <iostream>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+using namespace neural;
+
+///The lengths that are tested, around the widths of every instruction set and with odd tails
+static const size_t kLengths[] = { 0, 1, 2, 3, 5, 7, 8, 9, 15, 16, 17, 31, 33, 63, 65, 127, 129, 255, 257, 785 };
+
+///The offsets from an aligned buffer that the inputs begin at, in values
+static const size_t kOffsets[] = { 0, 1, 3 };
+
+/**
+ * Returns the difference that is allowed from the scalar kernels,
+ * relative to the magnitude of the result. The vectorized kernels
+ * sum in another order and may fuse the multiplications.
+ *
+ * @return The tolerance.
+ */
+template <typename Scalar>
+static Scalar Tolerance();
+
+template <>
+double Tolerance<double>() { return 1e-12; }
+
+template <>
+float Tolerance<float>() { return 1e-5f; }
+
+/**
+ * Returns true if a value is within the tolerance of the expected one.
+ *
+ * @param value         The value of the tested kernels.
+ * @param expected      The value of the scalar kernels.
+ * @param magnitude     The magnitude that the tolerance is relative to.
+ * @return True if the value is close enough.
+ */
+template <typename Scalar>
+static bool Close(Scalar value, Scalar expected, Scalar magnitude) {
+    return fabs(value - expected) <= Tolerance<Scalar>() * std::max<Scalar>(1, magnitude);
+}
+
+/**
+ * Compares every kernel of a table to the scalar kernels, at every
+ * length and offset.
+ *
+ * @param kernels   The kernels to test.
+ * @param type      The name of the scalar type, for the report.
+ * @return The number of failed comparisons.
+ */
+template <typename Scalar>
+static size_t Compare(const Kernels<Scalar>& kernels, const char* type) {
+    
+    const Kernels<Scalar>& reference = ScalarKernels<Scalar>();
+    
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<Scalar> weights(-1, 1);
+    std::uniform_real_distribution<Scalar> outputs(0, 1);
+    std::uniform_real_distribution<Scalar> values(-100, 100);
+    
+    size_t failures = 0;
+    
+    auto check = [&](bool passed, const char* kernel, size_t length, size_t offset) {
+        
+        if (!passed) {
+            
+            std::cerr << kernels.name << " " << type << " " << kernel << " differs at length " << length << " and offset " << offset << "\n";
+            failures++;
+        }
+    };
+    
+    for (size_t length : kLengths) {
+        for (size_t offset : kOffsets) {
+            
+            AlignedVector<Scalar> a(length + offset), b(length + offset), y(length + offset), expected_y(length + offset);
+            
+            for (size_t index = 0 ; index < a.size() ; index++) {
+                
+                a[index] = weights(generator);
+                b[index] = weights(generator);
+                y[index] = expected_y[index] = weights(generator);
+            }
+            
+            const Scalar* first = a.data() + offset;
+            const Scalar* second = b.data() + offset;
+            
+            //The sum of the magnitudes bounds the error of any order of summation
+            Scalar magnitude = 0;
+            
+            for (size_t index = 0 ; index < length ; index++)
+                magnitude += fabs(first[index] * second[index]);
+            
+            check(Close(kernels.dot(first, second, length), reference.dot(first, second, length), magnitude), "dot", length, offset);
+            
+            Scalar alpha = weights(generator);
+            kernels.axpy(alpha, first, y.data() + offset, length);
+            reference.axpy(alpha, first, expected_y.data() + offset, length);
+            
+            bool passed = true;
+            
+            for (size_t index = 0 ; index < y.size() ; index++)
+                passed = passed && Close(y[index], expected_y[index], static_cast<Scalar>(fabs(expected_y[index])));
+            
+            check(passed, "axpy", length, offset);
+            
+            AlignedVector<Scalar> activated(length + offset), errors(length + offset), deltas(length + offset), expected_deltas(length + offset);
+            
+            for (size_t index = 0 ; index < activated.size() ; index++) {
+                
+                activated[index] = outputs(generator);
+                errors[index] = weights(generator);
+            }
+            
+            kernels.sigmoid_delta(activated.data() + offset, errors.data() + offset, deltas.data() + offset, length);
+            reference.sigmoid_delta(activated.data() + offset, errors.data() + offset, expected_deltas.data() + offset, length);
+            
+            passed = true;
+            
+            for (size_t index = offset ; index < deltas.size() ; index++)
+                passed = passed && Close(deltas[index], expected_deltas[index], static_cast<Scalar>(1));
+            
+            check(passed, "sigmoid_delta", length, offset);
+            
+            //The values reach past the range that the sigmoid is clamped to
+            AlignedVector<Scalar> inputs(length + offset), sigmoids(length + offset), expected_sigmoids(length + offset);
+            
+            for (size_t index = 0 ; index < inputs.size() ; index++)
+                inputs[index] = values(generator);
+            
+            kernels.fast_sigmoid(inputs.data() + offset, sigmoids.data() + offset, length);
+            reference.fast_sigmoid(inputs.data() + offset, expected_sigmoids.data() + offset, length);
+            
+            passed = true;
+            
+            for (size_t index = offset ; index < sigmoids.size() ; index++)
+                passed = passed && Close(sigmoids[index], expected_sigmoids[index], static_cast<Scalar>(1));
+            
+            check(passed, "fast_sigmoid", length, offset);
+        }
+    }
+    
+    std::cout << kernels.name << " " << type << ": " << ((failures) ? "failed" : "passed") << "\n";
+    
+    return failures;
+}
+
+/**
+ * Compares every table of kernels that the host supports to the
+ * scalar kernels.
+ *
+ * @param type      The name of the scalar type, for the report.
+ * @return The number of failed comparisons.
+ */
+template <typename Scalar>
+static size_t CompareAll(const char* type) {
+    
+    size_t failures = Compare(ScalarKernels<Scalar>(), type);
+
+#if NEURAL_X86
+    
+    __builtin_cpu_init();
+    
+    failures += Compare(SSE2Kernels<Scalar>(), type);
+    
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        failures += Compare(AVX2Kernels<Scalar>(), type);
+    
+    if (__builtin_cpu_supports("avx512f"))
+        failures += Compare(AVX512Kernels<Scalar>(), type);
+
+#endif
+    
+    return failures;
+}
+
+int main(int argc, const char * argv[]) {
+    
+    size_t failures = CompareAll<double>("double") + CompareAll<float>("float");
+    
+    return (failures) ? 1 : 0;
+}
@@ -0,0 +1,148 @@
+//
+//  ParseRecordTest.cpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#include "DataIterator.hpp"
+#include <iostream>
+#include <sstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace neural;
+
+///The records that are tested on their own, each a case that the parsing has to keep
+static const char* kRecords[] = {
+    "",
+    "0",
+    "1,2,3",
+    "1,2,3,",
+    "1,2,,",
+    ",",
+    ",1",
+    "1,,2",
+    "1,2\r",
+    "\r",
+    " 1, 2,  3",
+    "1 ,2",
+    "+1,+2",
+    "-3,4,-0",
+    "007,0000",
+    "12.5,3",
+    "1e3",
+    "0x10",
+    "abc",
+    "1,abc",
+    "2147483647,-2147483648",
+    "2147483648",
+    "-2147483649",
+    "99999999999999999999",
+    "1,2,99999999999999999999,3",
+};
+
+///The characters of the random records, mostly the ones that a record is made of
+static const char kAlphabet[] = "0123456789012345678901234567890123456789,,,,,,,,+- \r.";
+
+///The number of random records that are tested
+static const size_t kRandomRecords = 100000;
+
+/**
+ * Parses a record as it was parsed before 'ParseRecord', by splitting
+ * it at every ',' and converting every part with 'std::stoi'.
+ *
+ * @param record    The record.
+ * @param values    Receives the values.
+ */
+static void SplitRecord(const std::string& record, std::vector<double>& values) {
+    
+    values.clear();
+    
+    std::string value;
+    std::stringstream string_stream(record);
+    
+    while (std::getline(string_stream, value, ','))
+        values.push_back(std::stoi(value));
+}
+
+/**
+ * Runs a parser on a record and describes the outcome: the values, or
+ * the exception that it threw.
+ *
+ * @param parse     The parser.
+ * @param values    The values that the parser fills.
+ * @return The outcome.
+ */
+template <typename Parser>
+static std::string Outcome(Parser parse, std::vector<double>& values) {
+    
+    try {
+        parse(values);
+    }
+    catch (const std::invalid_argument&) {
+        return "invalid_argument";
+    }
+    catch (const std::out_of_range&) {
+        return "out_of_range";
+    }
+    
+    std::ostringstream outcome;
+    outcome.precision(17);
+    
+    for (double value : values)
+        outcome << value << ' ';
+    
+    return outcome.str();
+}
+
+/**
+ * Compares 'ParseRecord' to the splitting parser on a record.
+ *
+ * @param record    The record.
+ * @return True if both give the same values or throw the same exception.
+ */
+static bool Compare(const std::string& record) {
+    
+    //The parsed values reuse the same memory for every record, as the records of a file do
+    static std::vector<double> reused;
+    std::vector<double> split;
+    
+    std::string expected = Outcome([&](std::vector<double>& values) { SplitRecord(record, values); }, split);
+    std::string parsed = Outcome([&](std::vector<double>& values) { ParseRecord(record.data(), record.data() + record.size(), values); }, reused);
+    
+    if (parsed == expected)
+        return true;
+    
+    std::cerr << "\"" << record << "\" parsed as \"" << parsed << "\" instead of \"" << expected << "\"\n";
+    return false;
+}
+
+int main(int argc, const char * argv[]) {
+    
+    size_t failures = 0;
+    
+    for (const char* record : kRecords)
+        failures += !Compare(record);
+    
+    std::mt19937 generator(1);
+    std::uniform_int_distribution<size_t> lengths(0, 24);
+    std::uniform_int_distribution<size_t> characters(0, sizeof(kAlphabet) - 2);
+    
+    for (size_t index = 0 ; index < kRandomRecords ; index++) {
+        
+        std::string record(lengths(generator), ' ');
+        
+        for (char& character : record)
+            character = kAlphabet[characters(generator)];
+        
+        failures += !Compare(record);
+    }
+    
+    std::cout << "ParseRecord: " << ((failures) ? "failed" : "passed") << "\n";
+    
+    return (failures) ? 1 : 0;
+}
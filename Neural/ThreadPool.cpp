@@ -0,0 +1,238 @@
+//
+//  ThreadPool.cpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#include "ThreadPool.hpp"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+using namespace neural;
+
+///The number of times that a thread checks for work (or for the end of it) before it gives up the core
+static const size_t kSpins = 1 << 14;
+
+///Stores true on a thread that is running a part of a task
+static thread_local bool s_in_task = false;
+
+/**
+ * Implementation.
+ */
+class ThreadPool::Impl {
+public:
+    
+    /**
+     * Constructor.
+     *
+     * @param threads   The number of threads that share the work.
+     */
+    Impl(size_t threads);
+    
+    /**
+     * Returns the number of threads that share the work.
+     *
+     * @return The number of threads.
+     */
+    size_t Threads() const { return m_workers.size() + 1; }
+    
+    /**
+     * Hands the parts of the range to the threads and waits for them.
+     *
+     * @param count     The size of the range.
+     * @param align     The alignment of the parts.
+     * @param invoke    Calls the task on a part.
+     * @param task      The task.
+     */
+    void Dispatch(size_t count, size_t align, void (*invoke)(const void*, size_t, size_t), const void* task);
+    
+    /**
+     * Destructor.
+     */
+    ~Impl();
+    
+private:
+    
+    /**
+     * Runs the part of a thread in the current task.
+     *
+     * @param part  The index of the part.
+     */
+    void RunPart(size_t part) const;
+    
+    /**
+     * The loop of a worker, which waits for tasks until the pool stops.
+     *
+     * @param part  The part of every task that the worker runs.
+     */
+    void Work(size_t part);
+    
+    ///Stores the number of times to spin before waiting, none when there are more threads than cores
+    size_t m_spins;
+    
+    ///Stores the threads, the calling thread is not one of them
+    std::vector<std::thread> m_workers;
+    
+    ///Allows a single 'Dispatch' at a time
+    std::mutex m_dispatch_mutex;
+    
+    ///Guards the sleep of the workers
+    std::mutex m_mutex;
+    
+    ///Wakes the sleeping workers
+    std::condition_variable m_wake;
+    
+    ///Stores the number of the current task, a new value means new work
+    std::atomic<size_t> m_generation;
+    
+    ///Stores the number of workers that have not finished the current task
+    std::atomic<size_t> m_pending;
+    
+    ///Stores true when the workers should leave
+    std::atomic<bool> m_stop;
+    
+    ///Stores the current task
+    void (*m_invoke)(const void*, size_t, size_t);
+    const void* m_task;
+    size_t m_count;
+    size_t m_part_size;
+    
+};
+
+#pragma mark - Implementation
+
+ThreadPool::Impl::Impl(size_t threads) :
+m_spins(0),
+m_generation(0),
+m_pending(0),
+m_stop(false),
+m_invoke(NULL),
+m_task(NULL),
+m_count(0),
+m_part_size(0) {
+    
+    size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    
+    if (threads == 0)
+        threads = cores;
+    
+    //Spinning only helps when the thread that is waited for has a core of it's own
+    m_spins = (threads <= cores) ? kSpins : 0;
+    
+    for (size_t part = 1 ; part < threads ; part++)
+        m_workers.push_back(std::thread(&ThreadPool::Impl::Work, this, part));
+}
+
+ThreadPool::Impl::~Impl() {
+    
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop.store(true);
+        m_generation.fetch_add(1, std::memory_order_release);
+    }
+    
+    m_wake.notify_all();
+    
+    for (size_t index = 0 ; index < m_workers.size() ; index++)
+        m_workers[index].join();
+}
+
+void ThreadPool::Impl::RunPart(size_t part) const {
+    
+    size_t begin = std::min(m_count, part * m_part_size);
+    size_t end = std::min(m_count, begin + m_part_size);
+    
+    if (begin < end)
+        m_invoke(m_task, begin, end);
+}
+
+void ThreadPool::Impl::Work(size_t part) {
+    
+    size_t seen = 0;
+    s_in_task = true;
+    
+    while (true) {
+        
+        //Spin a little, the next layer usually follows right away
+        size_t generation = m_generation.load(std::memory_order_acquire);
+        for (size_t spin = 0 ; spin < m_spins && generation == seen ; spin++)
+            generation = m_generation.load(std::memory_order_acquire);
+        
+        if (generation == seen) {
+            
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this, seen]() { return m_generation.load(std::memory_order_acquire) != seen; });
+            generation = m_generation.load(std::memory_order_acquire);
+        }
+        
+        if (m_stop.load())
+            return;
+        
+        seen = generation;
+        RunPart(part);
+        m_pending.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void ThreadPool::Impl::Dispatch(size_t count, size_t align, void (*invoke)(const void*, size_t, size_t), const void* task) {
+    
+    //The threads of the pool may all be busy with the task that calls
+    if (s_in_task) {
+        
+        if (count > 0)
+            invoke(task, 0, count);
+        
+        return;
+    }
+    
+    std::lock_guard<std::mutex> dispatch_lock(m_dispatch_mutex);
+    
+    //Round the parts up to the alignment, the last part takes what is left
+    size_t threads = Threads();
+    size_t part_size = (count + threads - 1) / threads;
+    align = std::max<size_t>(align, 1);
+    
+    m_invoke = invoke;
+    m_task = task;
+    m_count = count;
+    m_part_size = (part_size + align - 1) / align * align;
+    m_pending.store(m_workers.size(), std::memory_order_relaxed);
+    
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_generation.fetch_add(1, std::memory_order_release);
+    }
+    
+    m_wake.notify_all();
+    
+    s_in_task = true;
+    RunPart(0);
+    s_in_task = false;
+    
+    //The barrier, spin while the others are most likely close to done
+    for (size_t spin = 0 ; m_pending.load(std::memory_order_acquire) != 0 ; spin++)
+        if (spin >= m_spins)
+            std::this_thread::yield();
+}
+
+#pragma mark - Thread pool functions
+
+ThreadPool::ThreadPool(size_t threads) :
+m_pimpl(new Impl(threads))
+{ }
+
+ThreadPool::~ThreadPool() { };
+
+size_t ThreadPool::Threads() const {
+    return m_pimpl->Threads();
+}
+
+void ThreadPool::Dispatch(size_t count, size_t align, void (*invoke)(const void*, size_t, size_t), const void* task) {
+    m_pimpl->Dispatch(count, align, invoke, task);
+}
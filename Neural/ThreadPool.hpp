@@ -0,0 +1,93 @@
+//
+//  ThreadPool.hpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#ifndef ThreadPool_hpp
+#define ThreadPool_hpp
+#include "Definitions.h"
+#include <stddef.h>
+#include <memory>
+NAMESPACE_NEURAL_BEGIN
+
+/**
+ * A set of threads that live as long as the pool and split ranges
+ * of work between them. The thread that calls 'Run' takes the first
+ * part itself, and 'Run' returns only after every part is done, so
+ * every call is also a barrier. The workers spin for a short while
+ * before they sleep, so that the layers of a network that follow
+ * each other closely do not wake them up every time.
+ *
+ * Calls to 'Run' from different threads are handled one at a time.
+ * A call to 'Run' from inside a task (of any pool) runs the whole range
+ * on the calling thread, so a task may use code that splits it's own
+ * work, without waiting for threads that are busy with the task.
+ */
+class ThreadPool {
+public:
+    
+    /**
+     * Constructor.
+     *
+     * @param threads   The number of threads that share the work, including
+     *                  the one that calls 'Run'. 0 uses a thread per core.
+     */
+    ThreadPool(size_t threads = 0);
+    
+    /**
+     * Returns the number of threads that share the work.
+     *
+     * @return The number of threads, including the one that calls 'Run'.
+     */
+    size_t Threads() const;
+    
+    /**
+     * Splits the range [0, count) into a contiguous part per thread and
+     * calls 'task(begin, end)' for every part that is not empty.
+     *
+     * @param count     The size of the range.
+     * @param align     The parts (except the last) are multiples of this, so
+     *                  that threads do not write to the same cache line.
+     * @param task      The work to do on a part.
+     */
+    template <typename Task>
+    void Run(size_t count, size_t align, const Task& task) {
+        Dispatch(count, align, &Invoke<Task>, &task);
+    }
+    
+    /**
+     * Destructor.
+     */
+    ~ThreadPool();
+    
+private:
+    
+    /**
+     * Calls a task of a known type through a plain pointer, so that
+     * running a task does not allocate.
+     */
+    template <typename Task>
+    static void Invoke(const void* task, size_t begin, size_t end) {
+        (*static_cast<const Task*>(task))(begin, end);
+    }
+    
+    /**
+     * Hands the parts of the range to the threads and waits for them.
+     *
+     * @param count     The size of the range.
+     * @param align     The alignment of the parts.
+     * @param invoke    Calls the task on a part.
+     * @param task      The task.
+     */
+    void Dispatch(size_t count, size_t align, void (*invoke)(const void*, size_t, size_t), const void* task);
+    
+    class Impl;
+    std::unique_ptr<Impl> m_pimpl;
+    
+};
+
+NAMESPACE_NEURAL_END
+#endif /* ThreadPool_hpp */
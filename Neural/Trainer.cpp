@@ -11,6 +11,7 @@
 #include <math.h>
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
 
 using namespace neural;
 
@@ -43,7 +44,7 @@ double Trainer::Train(double percentage,
             //Training session
             train_handler(data.Value(), real_value);
             
-            if (log && index % (train_limit / 100) == 0)
+            if (log && index % std::max<size_t>(train_limit / 100, 1) == 0)
                 std::cout
                 << std::setprecision(3)
                 << "overall progress: "
@@ -57,7 +58,7 @@ double Trainer::Train(double percentage,
             if (real_value == static_cast<size_t>(lround(answer_handler(data.Value()))))
                 ++correct;
             
-            if (log && (index - train_limit) % (validate_limit / 100) == 0)
+            if (log && (index - train_limit) % std::max<size_t>(validate_limit / 100, 1) == 0)
                 std::cout
                 << std::setprecision(3)
                 << "correct: "
@@ -94,7 +95,7 @@ double Trainer::Test(const std::string &test_file_path,
         if (real_value == result)
             ++correct;
 
-        if (log && index % (all_values / 100) == 0)
+        if (log && index % std::max<size_t>(all_values / 100, 1) == 0)
             std::cout
             << std::setprecision(3)
             << "correct: "
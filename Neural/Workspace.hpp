@@ -0,0 +1,60 @@
+//
+//  Workspace.hpp
+//  Neural
+//
+//  Created by Maxim Vainshtein on 18/10/2026.
+//  Copyright © 2026 Maxim Vainshtein. All rights reserved.
+//
+
+#ifndef Workspace_hpp
+#define Workspace_hpp
+#include "Definitions.h"
+#include "AlignedAllocator.hpp"
+#include <vector>
+NAMESPACE_NEURAL_BEGIN
+
+/**
+ * Holds the intermediate results of a network while it processes
+ * data. The forward pass records the activations of every layer
+ * once, and the backward pass reads them from here instead of
+ * calculating them again. The buffers are sized on the first use
+ * and reused afterwards, so a warmed up workspace never allocates.
+ *
+ * A network has it's own workspace, but every thread that uses a
+ * network concurrently must supply one of it's own.
+ */
+template <typename Scalar>
+class Workspace {
+public:
+    
+    /**
+     * The buffers of a single layer.
+     */
+    struct Buffers {
+        
+        ///The outputs (activations) of the layer
+        std::vector<Scalar> outputs;
+        
+        ///The deltas of the layer
+        std::vector<Scalar> deltas;
+        
+        ///The errors of the layer's outputs, as propogated from the next layer
+        std::vector<Scalar> errors;
+        
+        ///The sums of the updates to the layer's weights, laid out as the weights
+        AlignedVector<Scalar> weights_gradient;
+        
+        ///The sums of the updates to the layer's biases
+        std::vector<Scalar> biases_gradient;
+    };
+    
+    ///Stores the inputs of a batch, a record per row
+    std::vector<Scalar> inputs;
+    
+    ///Stores the buffers of every layer, by order
+    std::vector<Buffers> layers;
+    
+};
+
+NAMESPACE_NEURAL_END
+#endif /* Workspace_hpp */
@@ -9,7 +9,23 @@
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <math.h>
+#include <sys/stat.h>
 #include "OperationalNetwork.hpp"
+#include "DataIterator.hpp"
+#include "Trainer.hpp"
+#include "Data.hpp"
+#include "RandomGenerator.hpp"
+#include "ParameterServer.hpp"
+#include "ParameterWorker.hpp"
+#include "InferenceServer.hpp"
+#include "LoadGenerator.hpp"
+#include "ModelHandle.hpp"
+#include "RecordFile.hpp"
 
 using namespace neural;
 
@@ -22,6 +38,141 @@ char* GetOption(char ** begin, char ** end, const std::string& option) {
     return 0;
 }
 
+/**
+ * Measures the number of records that the network estimates per second.
+ *
+ * @param network   The network to measure.
+ * @param records   The records to estimate.
+ * @return The number of records per second.
+ */
+double RecordsPerSecond(const OperationalNetwork& network, const std::vector<Data>& records) {
+    
+    auto start = std::chrono::steady_clock::now();
+    
+    for (size_t index = 0 ; index < records.size() ; index++)
+        network.Estimate(records[index]);
+    
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return records.size() / elapsed.count();
+}
+
+/**
+ * Measures the number of records that are read from a file per second,
+ * without a network. The file is read again and again for a second at
+ * the least, into the same record.
+ *
+ * @param data_file     The data or key file to read.
+ * @return The number of records per second.
+ */
+double ReadsPerSecond(const std::string& data_file) {
+    
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed(0);
+    size_t records = 0;
+    Data record;
+    
+    do {
+        
+        for (DataIterator data(data_file) ; data.Valid() ; data.Next(), records++)
+            data.Value(record);
+        
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+    while (elapsed.count() < 1.0 && records > 0);
+    
+    return records / elapsed.count();
+}
+
+/**
+ * Quantizes the network and prints the accuracy and speed of the
+ * quantized network next to the original one.
+ *
+ * @param network           The network to quantize.
+ * @param calibration_file  The file to calibrate the quantized network with.
+ * @param data_file         The file to test the networks on.
+ * @param key_file          The answers of the test file.
+ */
+void CompareQuantized(OperationalNetwork& network, const char* calibration_file, const char* data_file, const char* key_file) {
+    
+    Trainer trainer;
+    auto estimate = [&network](const Data& data) { return network.Estimate(data); };
+    
+    std::vector<Data> records;
+    for (DataIterator data(data_file) ; data.Valid() ; data.Next())
+        records.push_back(data.Value());
+    
+    double original_accuracy = trainer.Test(data_file, key_file, estimate, false);
+    double original_speed = RecordsPerSecond(network, records);
+    
+    network.Quantize(calibration_file);
+    
+    double quantized_accuracy = trainer.Test(data_file, key_file, estimate, false);
+    double quantized_speed = RecordsPerSecond(network, records);
+    
+    std::cout
+    << "original:\taccuracy " << original_accuracy << "%\t" << original_speed << " records/sec\n"
+    << "quantized:\taccuracy " << quantized_accuracy << "% (" << std::showpos << quantized_accuracy - original_accuracy << std::noshowpos
+    << ")\t" << quantized_speed << " records/sec\n";
+}
+
+/**
+ * Loads the network again whenever it's file is replaced, and publishes
+ * it to the readers of the handle. A new network should be written to
+ * another file and renamed over the served one, so that it is never read
+ * while it is only partly written.
+ *
+ * @param model             The handle of the served network.
+ * @param serialized_file   The file of the served network.
+ * @param threads           The number of threads of every loaded network.
+ * @param fast_activation   True if the loaded networks use the fast activation.
+ * @param calibration_file  The file to quantize the loaded networks with, or NULL.
+ * @param fixed             True to estimate with the fixed layout of the loaded networks.
+ * @param inputs            The number of values of every record that the server reads.
+ * @param outputs           The number of results of the served network.
+ */
+void WatchModel(ModelHandle& model, std::string serialized_file, size_t threads, bool fast_activation, const char* calibration_file, bool fixed, size_t inputs, size_t outputs) {
+    
+    struct stat loaded;
+    stat(serialized_file.c_str(), &loaded);
+    
+    while (true) {
+        
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        
+        struct stat current;
+        
+        //A rename gives the file a new inode, a rewrite a new time or size
+        if (stat(serialized_file.c_str(), &current) != 0 ||
+            (current.st_ino == loaded.st_ino && current.st_mtime == loaded.st_mtime && current.st_size == loaded.st_size))
+            continue;
+        
+        loaded = current;
+        
+        std::unique_ptr<OperationalNetwork> network(new OperationalNetwork(serialized_file, threads));
+        
+        if (!network->Valid()) {
+            std::cout << serialized_file << " is not a valid network, the served one is kept\n" << std::flush;
+            continue;
+        }
+        
+        //The server reads records of the width that it started with
+        if (network->Inputs() != inputs || network->Outputs() != outputs) {
+            std::cout << serialized_file << " has another number of inputs or outputs, the served one is kept\n" << std::flush;
+            continue;
+        }
+        
+        network->SetFastActivation(fast_activation);
+        network->SetThreads(threads);
+        
+        if (calibration_file)
+            network->Quantize(calibration_file, false);
+        else if (fixed && !network->Specialize())
+            std::cout << serialized_file << " does not have the default topology, it is served without the fixed layout\n";
+        
+        std::cout << "loaded version " << model.Publish(std::move(network)) << " from " << serialized_file << '\n' << std::flush;
+    }
+}
+
 int main(int argc, char * argv[]) {
 
     //Show instructions
@@ -29,10 +180,31 @@ int main(int argc, char * argv[]) {
         
         std::cerr << "Welcome to the NeuralNetworker(TM), probably the only C++ implementation around.\n\n"
         << "Usage:\n"
-        << "-i\tSpecifies the input data file that has the raw data as 784 pixels per each read\n"
+        << "-i\tSpecifies the input data file that has the raw data as 784 pixels per each read. Data and key files may also be binary record files (see convert) or MNIST IDX files\n"
         << "-k\tSpecifies the key file that holds the answers for the given data file\n"
         << "-o\tSpecifies the name of the output file\n"
         << "-n\tSpecifies the type of network to use: 1 stands for 10 different networks, 2 will run with a single network\n"
+        << "-b\tSpecifies the number of records that are trained together as a mini-batch (default is 1)\n"
+        << "-p\tSpecifies the precision of the network's weights: double (default) or float\n"
+        << "-f\tSpecifies the layout of the network in test and serving modes: dynamic (default) or fixed, which estimates with the layer sizes of the default topologies compiled in. Cannot be used with -q\n"
+        << "-a\tSpecifies the activation to use: exact (default) or fast, which approximates the sigmoid. In test mode with -k, the accuracy is printed so both can be compared\n"
+        << "-h\tSpecifies the activation of the hidden layers: sigmoid (default), relu, leaky or tanh. The output layer is always a sigmoid\n"
+        << "-j\tSpecifies the number of threads that share the work of every layer: 0 uses a thread per core (default is 1). The ten networks of type 1 run concurrently instead. A model in the text form is also parsed by that many threads\n"
+        << "-w\tSpecifies the number of threads that train at once, each on it's own slice of the data, updating the weights without locks (Hogwild). The throughput of every thread is printed\n"
+        << "-m\tSpecifies how the -w threads train: hogwild (default) or sync, which splits every mini-batch between the threads and gives the same weights on every run (-b defaults to 64)\n"
+        << "-r\tSpecifies a seed for the starting weights, so that runs with the same options give the same network\n"
+        << "-l\tSpecifies the number of pipeline stages that the layers of a type 2 network are split into, each on a thread of it's own. The batches (-b, 64 by default) flow through the stages in micro-batches, and the utilization of every stage is printed\n"
+        << "-s\tRuns a parameter server on the given address (unix:<path> or <host>:<port>) instead of training, and saves the network that the workers trained to the -o file\n"
+        << "-d\tSpecifies the number of workers that the parameter server waits for (default is 1)\n"
+        << "-y\tSpecifies how many steps a worker may be ahead of the slowest one: 0 (default) makes every step synchronous\n"
+        << "-c\tRuns a worker of the parameter server at the given address, which trains on it's shard of the -i and -k files in steps of -b records (default is 64)\n"
+        << "-q\tIn test mode, quantizes the network to 8 bit integers, calibrated on the given data file. When -k is also given, the accuracy and speed are compared to the original network\n"
+        << "--serve\tLoads the -t network once and serves estimations on the given address (unix:<path> or <host>:<port>). Requests are gathered into batches of up to -b records (default is 64), and the latency and throughput are printed every few seconds\n"
+        << "-e\tSpecifies the longest time in microseconds that a request to the server waits for others to be batched with (default is 1000)\n"
+        << "--load\tSends the records of the -i file to the server at the given address from -w clients at once (default is 4), -b records per request (default is 1), and prints the latency and throughput. The results are saved to the -o file if it is given\n"
+        << "-x\tSpecifies the format that the network is saved in: text (default) or binary, which keeps the weights exactly and is loaded by mapping the file instead of parsing it. With -t and without -i, the -t network is converted to the -o file\n"
+        << "convert\tPacks the -i data or key file into a binary record file at -o, a byte per value, which every option that reads a data or key file takes in place of the text form and reads without parsing\n"
+        << "read\tReads the -i data or key file for a second without a network and prints the number of records read per second, to measure the parsing of every form\n"
         << "-t\tActivates the test mode. The flag specifies name of the output file from a previous run. The -i file will be used as the test file and will output the results to the -o file\n\n\n";
     }
     else {
@@ -43,6 +215,151 @@ int main(int argc, char * argv[]) {
         char* output_file       = GetOption(argv, argv + argc, "-o");
         char* serialized_file   = GetOption(argv, argv + argc, "-t");
         char* type              = GetOption(argv, argv + argc, "-u");
+        char* batch             = GetOption(argv, argv + argc, "-b");
+        char* precision         = GetOption(argv, argv + argc, "-p");
+        char* calibration_file  = GetOption(argv, argv + argc, "-q");
+        char* activation        = GetOption(argv, argv + argc, "-a");
+        char* layout            = GetOption(argv, argv + argc, "-f");
+        char* hidden            = GetOption(argv, argv + argc, "-h");
+        char* threads           = GetOption(argv, argv + argc, "-j");
+        char* trainers          = GetOption(argv, argv + argc, "-w");
+        char* mode              = GetOption(argv, argv + argc, "-m");
+        char* seed              = GetOption(argv, argv + argc, "-r");
+        char* server_address    = GetOption(argv, argv + argc, "-s");
+        char* workers           = GetOption(argv, argv + argc, "-d");
+        char* staleness         = GetOption(argv, argv + argc, "-y");
+        char* worker_address    = GetOption(argv, argv + argc, "-c");
+        char* stages            = GetOption(argv, argv + argc, "-l");
+        char* serve_address     = GetOption(argv, argv + argc, "--serve");
+        char* max_wait          = GetOption(argv, argv + argc, "-e");
+        char* load_address      = GetOption(argv, argv + argc, "--load");
+        char* format            = GetOption(argv, argv + argc, "-x");
+        bool synchronous        = mode && std::string(mode) == "sync";
+        bool fast_activation    = activation && std::string(activation) == "fast";
+        bool fixed_layout       = layout && std::string(layout) == "fixed";
+        
+        //Packing a data file needs nothing but the files
+        if (std::string(argv[1]) == "convert") {
+            
+            if (!data_file || !output_file) {
+                std::cerr << "In order to convert a data or key file, -i and -o must be specified.";
+                return 0;
+            }
+            
+            if (!RecordFile::Convert(data_file, output_file))
+                std::cerr << "Could not convert " << data_file << ", every record must have the same number of values, each between 0 and 255.";
+            
+            return 0;
+        }
+        
+        //Reading a file only measures the parsing of it's records
+        if (std::string(argv[1]) == "read") {
+            
+            if (!data_file) {
+                std::cerr << "In order to measure the reading of a file, -i must be specified.";
+                return 0;
+            }
+            
+            std::cout << data_file << ":\t" << static_cast<size_t>(ReadsPerSecond(data_file)) << " records/second\n";
+            return 0;
+        }
+        
+        OperationalNetwork::Format save_format = (format && std::string(format) == "binary") ?
+        OperationalNetwork::Format::kBinary : OperationalNetwork::Format::kText;
+        
+        if (fixed_layout && calibration_file) {
+            std::cerr << "The fixed layout cannot be quantized, -f and -q cannot be used together.";
+            return 0;
+        }
+        
+        //A worker receives it's network from the server
+        if (worker_address) {
+            
+            if (!data_file || !key_file) {
+                std::cerr << "In order to train as a worker, -i and -k must be specified.";
+                return 0;
+            }
+            
+            ParameterWorker worker(worker_address);
+            
+            if (!worker.Connected()) {
+                std::cerr << "Could not reach a parameter server at " << worker_address;
+                return 0;
+            }
+            
+            if (!worker.Train(data_file, key_file, (batch) ? std::stoul(batch) : 64))
+                std::cerr << "The connection to the parameter server was lost";
+            
+            return 0;
+        }
+        
+        //The load generator only needs the records to send
+        if (load_address) {
+            
+            if (!data_file) {
+                std::cerr << "In order to send requests to a server, -i must be specified.";
+                return 0;
+            }
+            
+            LoadGenerator generator(load_address);
+            std::vector<double> results;
+            
+            if (!generator.Run(data_file, (trainers) ? std::stoul(trainers) : 4, (batch) ? std::stoul(batch) : 1, results)) {
+                std::cerr << "Not every request was answered by the server at " << load_address;
+                return 0;
+            }
+            
+            if (output_file) {
+                
+                std::ofstream output(output_file);
+                
+                for (size_t index = 0 ; index < results.size() ; index++)
+                    output << static_cast<unsigned long long>(lround(results[index])) << '\n';
+            }
+            
+            return 0;
+        }
+        
+        //The server keeps the network loaded for as long as it runs
+        if (serve_address) {
+            
+            if (!serialized_file) {
+                std::cerr << "In order to serve estimations, -t must be specified.";
+                return 0;
+            }
+            
+            std::unique_ptr<OperationalNetwork> network(new OperationalNetwork(serialized_file, (threads) ? std::stoul(threads) : 1));
+            
+            if (!network->Valid()) {
+                std::cerr << serialized_file << " is not a valid network.";
+                return 0;
+            }
+            
+            network->SetFastActivation(fast_activation);
+            network->SetThreads((threads) ? std::stoul(threads) : 1);
+            
+            if (calibration_file)
+                network->Quantize(calibration_file);
+            
+            if (fixed_layout && !network->Specialize()) {
+                std::cerr << "The fixed layout only supports the default topologies, " << serialized_file << " has another one.";
+                return 0;
+            }
+            
+            //The server is the only reader, a replaced file is published to it
+            size_t inputs = network->Inputs();
+            size_t outputs = network->Outputs();
+            
+            ModelHandle model(std::move(network), 1);
+            std::thread(WatchModel, std::ref(model), std::string(serialized_file), (threads) ? std::stoul(threads) : 1, fast_activation, calibration_file, fixed_layout, inputs, outputs).detach();
+            
+            InferenceServer server(model, serve_address, (batch) ? std::stoul(batch) : 64, (max_wait) ? std::stoul(max_wait) : 1000);
+            
+            if (!server.Run())
+                std::cerr << "Could not serve on " << serve_address;
+            
+            return 0;
+        }
         
         //Check that the data is valid
         if (!type && !serialized_file) {
@@ -52,14 +369,14 @@ int main(int argc, char * argv[]) {
         
         if (serialized_file) {
             
-            if (!data_file || !output_file) {
+            if (!output_file || (!data_file && !format)) {
                 std::cerr << "In order to create an output file that contains the results, -i and -o must be specified.";
                 return 0;
             }
         }
         else {
             
-            if (!data_file || !output_file || !key_file) {
+            if (!output_file || (!server_address && (!data_file || !key_file))) {
                 std::cerr << "In order to create a network file that contains the trained network, -i, -o and -k must be specified.";
                 return 0;
             }
@@ -69,26 +386,105 @@ int main(int argc, char * argv[]) {
         if (!serialized_file) {
             
             //Output a serialized network into a file according to type
-            std::ofstream output(output_file);
             OperationalNetwork::Type network_type;
             
             if (*type == '1')       network_type = OperationalNetwork::Type::kSeperated;
             else if (*type == '2')  network_type = OperationalNetwork::Type::kCombined;
             
-            OperationalNetwork network(network_type);
-            network.Train(data_file, key_file);
-            output << network.Serialize();
+            OperationalNetwork::Precision network_precision = OperationalNetwork::Precision::kDouble;
+            
+            if (precision && std::string(precision) == "float")
+                network_precision = OperationalNetwork::Precision::kFloat;
+            
+            ActivationType hidden_activation = ActivationType::kSigmoid;
+            
+            if (hidden && !ActivationFromName(hidden, hidden_activation)) {
+                std::cerr << "The activation of the hidden layers given via -h must be sigmoid, relu, leaky or tanh.";
+                return 0;
+            }
+            
+            //The seperated networks are too shallow to be split into stages
+            if (stages && network_type != OperationalNetwork::Type::kCombined) {
+                std::cerr << "Only a type 2 network can be pipelined, -l cannot be used with -u 1.";
+                return 0;
+            }
+            
+            if (seed)
+                RandomGenerator::Seed(static_cast<unsigned int>(std::stoul(seed)));
+            
+            OperationalNetwork network(network_type, network_precision, hidden_activation);
+            network.SetFastActivation(fast_activation);
+            network.SetThreads((threads) ? std::stoul(threads) : 1);
+            network.SetPipelineStages((stages) ? std::stoul(stages) : 1);
+            
+            if (server_address) {
+                
+                ParameterServer server(network, server_address, (workers) ? std::stoul(workers) : 1, (staleness) ? std::stoul(staleness) : 0);
+                
+                if (!server.Run()) {
+                    std::cerr << "The parameter server could not serve the workers on " << server_address;
+                    return 0;
+                }
+            }
+            else if (trainers && std::stoul(trainers) > 1 && synchronous)
+                network.Train(data_file, key_file, true, (batch) ? std::stoul(batch) : 64, std::stoul(trainers));
+            else if (trainers && std::stoul(trainers) > 1)
+                network.TrainConcurrently(data_file, key_file, std::stoul(trainers));
+            else
+                network.Train(data_file, key_file, true, (batch) ? std::stoul(batch) : ((stages) ? 64 : 1));
+            
+            if (!network.Save(output_file, save_format)) {
+                std::cerr << "The network could not be saved to " << output_file;
+                return 0;
+            }
             
-            output.close();
             std::cout << "The network was successfully serialized and saved to " << output_file << '\n';
             return 0;
         }
         else {
             
             //Convert the serialized file by type, and run the test file
+            OperationalNetwork network(serialized_file, (threads) ? std::stoul(threads) : 1);
+            
+            if (!network.Valid()) {
+                std::cerr << serialized_file << " is not a valid network.";
+                return 0;
+            }
+            
+            //Without a test file the network is only converted to the -x format
+            if (!data_file) {
+                
+                if (!network.Save(output_file, save_format)) {
+                    std::cerr << "The network could not be saved to " << output_file;
+                    return 0;
+                }
+                
+                std::cout << "The network was successfully converted and saved to " << output_file << '\n';
+                return 0;
+            }
+            
             std::ofstream output(output_file);
-            OperationalNetwork network(serialized_file);
-            output << network.Estimate(data_file);
+            network.SetFastActivation(fast_activation);
+            network.SetThreads((threads) ? std::stoul(threads) : 1);
+            
+            if (calibration_file) {
+                
+                if (key_file)   CompareQuantized(network, calibration_file, data_file, key_file);
+                else            network.Quantize(calibration_file);
+            }
+            else if (fixed_layout && !network.Specialize()) {
+                std::cerr << "The fixed layout only supports the default topologies, " << serialized_file << " has another one.";
+                return 0;
+            }
+            
+            if (key_file && !calibration_file) {
+                
+                //Validate the network against the answers
+                Trainer trainer;
+                std::cout << "accuracy " << trainer.Test(data_file, key_file, [&network](const Data& data) { return network.Estimate(data); }, false) << "%\n";
+            }
+            
+            network.Estimate(data_file, output);
             
             output.close();
             std::cout << "The results have been saved to " << output_file << '\n';